@@ -3,6 +3,8 @@
 
 #include <iostream>
 #include <cstdint>
+#include <cstring>
+#include <functional>
 #include <thread>
 #include <getopt.h>
 
@@ -10,6 +12,8 @@
 // #include "cpu_data_functions.hpp"
 // #include "gpu_data_functions.cuh"
 #include "cpu_pingpong.hpp"
+#include "compare.hpp"
+#include "sweep.hpp"
 
 
 
@@ -22,67 +26,446 @@
  * */
 
 
-void run_ping_pong_functions(Allocator allocator) {
+void run_ping_pong_functions(Arena &arena) {
+    Allocator allocator = arena.kind();
+
     // std::cout << get_cpu_freq() << std::endl;
     // std::cout << get_gpu_freq() << std::endl;
 
     if (allocator != CUDA_MALLOC) {
-        host_device_fetch_add(allocator);
+        host_device_fetch_add(arena);
     } else {
-        device_device_fetch_add(allocator);
+        device_device_fetch_add(arena);
     }
 
     if (allocator != CUDA_MALLOC) {
-        host_ping_device_pong_base(allocator);
-        device_ping_host_pong_base(allocator);
-        host_ping_device_pong_decoupled(allocator);
-        device_ping_host_pong_decoupled(allocator);
+        host_ping_device_pong_base(arena);
+        device_ping_host_pong_base(arena);
+        host_ping_device_pong_decoupled(arena);
+        device_ping_host_pong_decoupled(arena);
     } 
 
-    device_ping_device_pong_base(allocator);
-    device_ping_device_pong_decoupled(allocator);
+    device_ping_device_pong_base(arena);
+    device_ping_device_pong_decoupled(arena);
     // host_ping_host_pong_decoupled();
 
     if (allocator != CUDA_MALLOC) {
-        host_ping_device_pong_assymetric(allocator);
-        device_ping_host_pong_assymetric(allocator);
+        host_ping_device_pong_assymetric(arena);
+        device_ping_host_pong_assymetric(arena);
     }
 }
 
+// the option grammar, printed for -h and for an option getopt does not know
+void usage(const char *program) {
+    std::cout << "Usage: " << program << " [options]\n"
+        "\n"
+        "  -m <allocator>[,...]        MALLOC, HOST, UM or CUDA_MALLOC, each in its own arena (default MALLOC)\n"
+        "  -e <glob>                   run only cells whose experiment name matches; repeatable\n"
+        "  -f <key>=<value>[,...]      keep cells whose scope, order, protocol or allocator is one of the values; repeatable\n"
+        "  -L                          list the selected cells, run none\n"
+        "  -p <a>,<b>                  pin the two host agents to cores a and b (default 0,1)\n"
+        "  -J <priority>               SCHED_FIFO agents with memory locked, on isolated cores unless -p is given\n"
+        "  -a <min ms>[,<rse %>[,<max iterations>]]\n"
+        "                              grow each ping/pong cell's run until its estimate settles\n"
+        "  -x                          drop disturbed results instead of flagging them\n"
+        "  -T <prefix>                 write a Chrome trace of every ping/pong cell to <prefix><n>-<experiment>.json\n"
+        "  -t <trials>                 repeat the whole run\n"
+        "  -c <baseline>               compare against the saved output of an earlier run\n"
+        "  -r <percent>                regression threshold for -c (default " << COMPARE_DEFAULT_THRESHOLD << ")\n"
+        "  -s <sweep.json>             run a declarative sweep, resuming from <sweep.json>.cache\n"
+        "  -j <workers>[:llc]          run sweep points in parallel on disjoint core pairs, 0 for as many as fit;\n"
+        "                              :llc takes one pair per last-level cache instead of per node\n"
+        "\n"
+        "At most one mode replaces the default ping/pong sequence:\n"
+        "  -l fixed:<ns> | uniform:<lo ns>:<hi ns> | empirical:<histogram> | none\n"
+        "                              simulate the device agent with a latency-injected host thread\n"
+        "  -o                          one-way latency in each direction\n"
+        "  -O constant|poisson[:<rate>,...]\n"
+        "                              open-loop load at each rate in messages/s\n"
+        "  -w evict|tlb|idle:<us>|um   first-message latency after cooling; repeatable\n"
+        "  -i spin|futex|nanosleep|monitor[:<gap us>,...]\n"
+        "                              wake-up latency after idle gaps; repeatable\n"
+        "  -R <agents>[,...][:<tokens>]\n"
+        "                              token ring across topology-placed host agents\n"
+        "  -F <workers>[,...]          broadcast to and gather from host workers\n"
+        "  -M <channels>[,...]|default\n"
+        "                              one consumer polling that many mailboxes\n"
+        "  -W <grain ns>[,...][:<max thieves>]\n"
+        "                              Chase-Lev work stealing against static partitioning\n"
+        "  -P <clients>[,...][:<slots>[,...]]\n"
+        "                              host and device clients calling a host service thread\n"
+        "  -Q each|k:<K>|t:<ns>[,...]|default\n"
+        "                              persistent consumer fed through a ring, per doorbell policy\n"
+        "  -C <channels>[,...]|default\n"
+        "                              ping/pong channels as coroutines against a thread per channel\n"
+        "\n"
+        "  -h                          this help\n";
+}
+
 int main(int argc, char** argv) {
 
-    // do a getopt for a -m flag, and the inputs are either MALLOC or HOST
+    std::vector<Allocator> allocators;
+    ExperimentSelection &selection = experiment_selection();
+
+    const char *sweep_path = nullptr;
+    int sweep_workers = 1;
+    bool sweep_per_llc = false;
 
-    Allocator allocator;
+    // the mode flag given, 0 for the default sequence; -w and -i may repeat, different flags conflict
+    char mode_flag = 0;
+    LatencyModel latency_model;
+    LoadSweep load_sweep;
+    std::vector<Cooling> coolings;
+    std::vector<IdleSweep> idle_sweeps;
+    RingSweep ring_sweep;
+    std::vector<size_t> fan_workers;
+    std::vector<size_t> mailbox_channels;
+    StealSweep steal_sweep;
+    RpcSweep rpc_sweep;
+    std::vector<DoorbellPolicy> doorbell_policies;
+    std::vector<size_t> channel_counts;
+
+    bool cores_given = false;
+
+    int trials = 1;
+    const char *baseline_path = nullptr;
+    double threshold = COMPARE_DEFAULT_THRESHOLD;
 
     int opt;
-    while ((opt = getopt(argc, argv, "m:")) != -1) {
+    while ((opt = getopt(argc, argv, "hm:l:t:c:r:T:oO:e:f:Ls:p:j:a:xJ:w:i:R:F:M:W:P:Q:C:")) != -1) {
+        if (strchr("loOwiRFMWPQC", opt) != nullptr) {
+            if (mode_flag != 0 && mode_flag != opt) {
+                std::cout << "-" << (char) opt << " and -" << mode_flag << " select different modes" << std::endl;
+                return 1;
+            }
+            mode_flag = (char) opt;
+        }
+
         switch (opt) {
             case 'm':
-                if (strcmp(optarg, "MALLOC") == 0) {
-                    std::cout << "Using Malloc" << std::endl;
-                    allocator = MALLOC;
-                } else if (strcmp(optarg, "HOST") == 0) {
-                    std::cout << "Using Host" << std::endl;
-                    allocator = CUDA_MALLOC_HOST;
-                } else if (strcmp(optarg, "UM") == 0) {
-                    std::cout << "Using UM" << std::endl;
-                    allocator = UM;
-                } else if (strcmp(optarg, "CUDA_MALLOC") == 0) {
-                    std::cout << "Using CUDA_MALLOC" << std::endl;
-                    allocator = CUDA_MALLOC;
-                } else {
-                    std::cout << "Invalid argument" << std::endl;
+                for (const std::string &name : split_list(optarg)) {
+                    Allocator allocator;
+                    if (!parse_allocator(name, &allocator)) {
+                        std::cout << "Invalid allocator " << name << std::endl;
+                        return 1;
+                    }
+                    allocators.push_back(allocator);
+                }
+                break;
+            case 'e':
+                selection.patterns.push_back(optarg);
+                break;
+            case 'f':
+                if (!parse_filter(optarg, &selection)) {
+                    std::cout << "Invalid filter " << optarg << std::endl;
+                    return 1;
+                }
+                break;
+            case 'L':
+                selection.list_only = true;
+                break;
+            case 's':
+                sweep_path = optarg;
+                break;
+            case 'j':
+                sweep_workers = atoi(optarg);
+                sweep_per_llc = strchr(optarg, ':') != nullptr && strcmp(strchr(optarg, ':'), ":llc") == 0;
+                if (sweep_workers < 0 || (strchr(optarg, ':') != nullptr && !sweep_per_llc)) {
+                    std::cout << "Invalid worker count" << std::endl;
+                    return 1;
+                }
+                break;
+            case 'p':
+                if (sscanf(optarg, "%d,%d", &core_pair().first, &core_pair().second) != 2) {
+                    std::cout << "Invalid core pair" << std::endl;
+                    return 1;
+                }
+                cores_given = true;
+                break;
+            case 'J':
+                if (!parse_low_jitter(optarg, &low_jitter())) {
+                    std::cout << "Invalid SCHED_FIFO priority" << std::endl;
+                    return 1;
+                }
+                break;
+            case 'l':
+                if (!parse_latency_model(optarg, &latency_model)) {
+                    std::cout << "Invalid latency model" << std::endl;
+                    return 1;
+                }
+                std::cout << "Simulating device with latency " << latency_model.spec << std::endl;
+                break;
+            case 'x':
+                contamination_config().discard = true;
+                break;
+            case 'a':
+                if (!parse_run_length(optarg, &run_length())) {
+                    std::cout << "Invalid run length" << std::endl;
+                    return 1;
+                }
+                break;
+            case 't':
+                trials = atoi(optarg);
+                if (trials < 1) {
+                    std::cout << "Invalid trial count" << std::endl;
+                    return 1;
+                }
+                break;
+            case 'c':
+                baseline_path = optarg;
+                break;
+            case 'r':
+                threshold = atof(optarg);
+                break;
+            case 'O':
+                if (!parse_load_sweep(optarg, &load_sweep)) {
+                    std::cout << "Invalid load sweep" << std::endl;
+                    return 1;
+                }
+                break;
+            case 'i': {
+                IdleSweep sweep;
+                if (!parse_idle_sweep(optarg, &sweep)) {
+                    std::cout << "Invalid idle sweep" << std::endl;
+                    return 1;
+                }
+                idle_sweeps.push_back(sweep);
+                break;
+            }
+            case 'R':
+                if (!parse_ring_sweep(optarg, &ring_sweep)) {
+                    std::cout << "Invalid token ring" << std::endl;
+                    return 1;
+                }
+                break;
+            case 'F':
+                if (!parse_fan_sweep(optarg, &fan_workers)) {
+                    std::cout << "Invalid fan-out" << std::endl;
+                    return 1;
+                }
+                break;
+            case 'M':
+                if (!parse_mailbox_sweep(optarg, &mailbox_channels)) {
+                    std::cout << "Invalid mailbox sweep" << std::endl;
                     return 1;
                 }
                 break;
+            case 'W':
+                if (!parse_steal_sweep(optarg, &steal_sweep)) {
+                    std::cout << "Invalid work-stealing sweep" << std::endl;
+                    return 1;
+                }
+                break;
+            case 'P':
+                if (!parse_rpc_sweep(optarg, &rpc_sweep)) {
+                    std::cout << "Invalid RPC sweep" << std::endl;
+                    return 1;
+                }
+                break;
+            case 'Q':
+                if (!parse_doorbell_policies(optarg, &doorbell_policies)) {
+                    std::cout << "Invalid doorbell policy" << std::endl;
+                    return 1;
+                }
+                break;
+            case 'C':
+                if (!parse_channel_sweep(optarg, &channel_counts)) {
+                    std::cout << "Invalid channel sweep" << std::endl;
+                    return 1;
+                }
+                break;
+            case 'o':
+                break;
+            case 'w': {
+                Cooling cooling;
+                if (!parse_cooling(optarg, &cooling)) {
+                    std::cout << "Invalid cooling action" << std::endl;
+                    return 1;
+                }
+                coolings.push_back(cooling);
+                break;
+            }
+            case 'T':
+                trace_config().enabled = true;
+                trace_config().prefix = optarg;
+                break;
+            case 'h':
+                usage(argv[0]);
+                return 0;
             default:
-                std::cout << "Invalid argument" << std::endl;
+                usage(argv[0]);
+                return 1;
+        }
+    }
+
+    auto allocator_filter = selection.filters.find("allocator");
+    if (allocator_filter != selection.filters.end()) {
+        for (const std::string &name : allocator_filter->second) {
+            Allocator allocator;
+            if (!parse_allocator(name, &allocator)) {
+                std::cout << "Invalid allocator " << name << std::endl;
                 return 1;
+            }
+            allocators.push_back(allocator);
+        }
+    }
+    if (allocators.empty()) {
+        allocators.push_back(MALLOC);
+        // cold-start is reported per allocator, so compare the host-visible ones by default
+        if (!coolings.empty() && platform().has_device) {
+            allocators.push_back(CUDA_MALLOC_HOST);
+            allocators.push_back(UM);
         }
     }
+    if (selection.list_only) {
+        trials = 1;
+    }
+
+    print_platform(std::cout);
+    print_calibrations(std::cout);
 
-    run_ping_pong_functions(allocator);
+    if (low_jitter().enabled) {
+        enable_low_jitter();
+
+        std::vector<int> isolated = isolated_cores();
+        if (!cores_given && isolated.size() >= 2) {
+            core_pair() = {isolated[0], isolated[1]};
+        } else if (!cores_given) {
+            std::cout << "Info | Low-Jitter | Fewer than two isolated cores, keeping " << core_pair().first << "," << core_pair().second << std::endl;
+        }
+
+        int cpus = (int) sysconf(_SC_NPROCESSORS_ONLN);
+        if (core_pair().first == core_pair().second || core_pair().first >= cpus || core_pair().second >= cpus) {
+            std::cout << "Info | Low-Jitter | Cores " << core_pair().first << "," << core_pair().second << " are not two online cores, staying SCHED_OTHER" << std::endl;
+            low_jitter().priority = 0;
+            agent_priority() = 0;
+        }
+
+        std::cout << "Info | Low-Jitter | Agents | Priority : " << low_jitter().priority << " | Cores : " << core_pair().first << "," << core_pair().second << std::endl;
+        warn_device_interrupts(core_pair().first);
+        warn_device_interrupts(core_pair().second);
+    }
+
+    std::vector<ResultRecord> baseline;
+    std::map<std::string, PlatformFields> baseline_platforms;
+    if (baseline_path != nullptr && !load_results(baseline_path, &baseline, &baseline_platforms)) {
+        return 1;
+    }
+
+    // the mode's cells, the name it and its parameters give sweep cache keys, and whether its cells launch kernels
+    std::string mode;
+    std::function<void(Arena &)> run_mode;
+    bool launches_kernels = false;
+    switch (mode_flag) {
+        case 'C':
+            mode = "channels";
+            for (size_t count : channel_counts) mode += ":" + std::to_string(count);
+            run_mode = [&](Arena &arena) { channels(arena, channel_counts); };
+            break;
+        case 'Q':
+            mode = "queue";
+            for (const DoorbellPolicy &policy : doorbell_policies) mode += ":" + doorbell_name(policy);
+            run_mode = [&](Arena &arena) { command_queue(arena, doorbell_policies); };
+            launches_kernels = true;
+            break;
+        case 'P':
+            mode = "rpc";
+            for (size_t clients : rpc_sweep.clients) mode += ":" + std::to_string(clients);
+            for (size_t slots : rpc_sweep.slots) mode += "," + std::to_string(slots);
+            run_mode = [&](Arena &arena) { rpc(arena, rpc_sweep); };
+            launches_kernels = true;
+            break;
+        case 'W':
+            mode = "steal:" + std::to_string(steal_sweep.max_thieves);
+            for (double grain_ns : steal_sweep.grains_ns) mode += ":" + std::to_string(grain_ns);
+            run_mode = [&](Arena &arena) { work_stealing(arena, steal_sweep); };
+            break;
+        case 'M':
+            mode = "mailbox";
+            for (size_t channels : mailbox_channels) mode += ":" + std::to_string(channels);
+            run_mode = [&](Arena &arena) { mailbox(arena, mailbox_channels); };
+            break;
+        case 'F':
+            mode = "fan";
+            for (size_t workers : fan_workers) mode += ":" + std::to_string(workers);
+            run_mode = [&](Arena &arena) { fan(arena, fan_workers); };
+            break;
+        case 'R':
+            mode = "ring:" + std::to_string(ring_sweep.tokens);
+            for (size_t agents : ring_sweep.agents) mode += ":" + std::to_string(agents);
+            run_mode = [&](Arena &arena) { token_ring(arena, ring_sweep); };
+            break;
+        case 'i':
+            mode = "idle";
+            for (const IdleSweep &sweep : idle_sweeps) {
+                mode += std::string(":") + idle_wait_name(sweep.wait);
+                for (double gap_us : sweep.gaps_us) mode += "," + std::to_string(gap_us);
+            }
+            run_mode = [&](Arena &arena) { idle_gap(arena, idle_sweeps); };
+            break;
+        case 'w':
+            mode = "cold";
+            for (const Cooling &cooling : coolings) mode += ":" + cooling.spec;
+            run_mode = [&](Arena &arena) { cold_start(arena, coolings); };
+            launches_kernels = true;
+            break;
+        case 'O':
+            mode = std::string("open-loop:") + schedule_name(load_sweep.schedule);
+            for (double rate : load_sweep.rates) mode += ":" + std::to_string(rate);
+            run_mode = [&](Arena &arena) { open_loop(arena, load_sweep); };
+            launches_kernels = true;
+            break;
+        case 'o':
+            mode = "one-way";
+            run_mode = one_way;
+            launches_kernels = true;
+            break;
+        case 'l':
+            mode = "simulated:" + latency_model.spec;
+            run_mode = [&](Arena &arena) { host_ping_simulated_pong(arena, latency_model); };
+            break;
+        default:
+            mode = "round-trip";
+            run_mode = run_ping_pong_functions;
+            launches_kernels = true;
+            break;
+    }
+    if (run_length().adaptive) {
+        mode += ":adaptive:" + std::to_string(run_length().min_ms) + "," + std::to_string(run_length().target_rse) + "," + std::to_string(run_length().max_iterations);
+    }
+
+    auto run = [&](Arena &arena) {
+        if (low_jitter().enabled) {
+            scheduling_jitter(arena);
+        }
+        run_mode(arena);
+    };
+
+    if (sweep_path != nullptr) {
+        if (!run_sweep(sweep_path, mode, launches_kernels, sweep_workers, sweep_per_llc, run)) {
+            return 1;
+        }
+    } else {
+        for (Allocator allocator : allocators) {
+            std::cout << "Using " << allocator_name(allocator) << std::endl;
+            current_allocator() = allocator_name(allocator);
+
+            // every flag, signal and timer of the run lives in this arena
+            Arena arena(allocator);
+
+            for (int trial = 0; trial < trials; ++trial) {
+                run(arena);
+            }
+        }
+    }
+
+    if (selection.list_only) {
+        return 0;
+    }
+
+    if (baseline_path != nullptr && compare_results(baseline, baseline_platforms, result_records(), threshold) > 0) {
+        return 2;
+    }
 
     return 0;
 }
@@ -0,0 +1,130 @@
+#ifndef ARENA_CUH
+#define ARENA_CUH
+
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <unistd.h>
+
+#include "structs.cuh"
+
+constexpr size_t ARENA_CAPACITY = 1 << 20;
+
+/**
+ * One backing allocation per Allocator kind, carved into aligned slots.
+ *
+ *  - slot<T>() hands out gpu_cacheline-aligned slots, padded to a whole
+ *    number of lines so two slots never share a CPU or GPU cacheline
+ *  - page_slot<T>() does the same at page granularity
+ *  - reset() zeroes what was handed out and rewinds, so the next experiment
+ *    gets the same addresses in the same order (deterministic placement)
+ *  - the backing allocation is released when the arena goes out of scope
+ *
+ * Zeroed slots start out as PONG, which is what every protocol expects.
+ * */
+class Arena {
+public:
+    explicit Arena(Allocator allocator, size_t bytes = ARENA_CAPACITY) : allocator(allocator), base(nullptr), offset(0) {
+        page = (size_t) sysconf(_SC_PAGESIZE);
+        capacity = round_up(bytes, page);
+
+        if (allocator == CUDA_MALLOC_HOST) {
+            cudaMallocHost(&base, capacity);
+        } else if (allocator == MALLOC) {
+            base = (char *) aligned_alloc(page, capacity);
+        } else if (allocator == UM) {
+            cudaMallocManaged(&base, capacity);
+        } else if (allocator == CUDA_MALLOC) {
+            cudaMalloc(&base, capacity);
+        }
+
+        if (base == nullptr) {
+            std::cout << "Arena allocation of " << capacity << " bytes failed" << std::endl;
+            exit(1);
+        }
+
+        clear(capacity);
+    }
+
+    ~Arena() {
+        if (allocator == CUDA_MALLOC_HOST) {
+            cudaFreeHost(base);
+        } else if (allocator == MALLOC) {
+            free(base);
+        } else if (allocator == UM || allocator == CUDA_MALLOC) {
+            cudaFree(base);
+        }
+    }
+
+    Arena(const Arena &) = delete;
+    Arena &operator=(const Arena &) = delete;
+
+    template <typename T>
+    T *slot(size_t count = 1, size_t alignment = gpu_cacheline) {
+        size_t start = round_up(offset, alignment);
+        size_t bytes = round_up(count * sizeof(T), alignment);
+
+        if (start + bytes > capacity) {
+            std::cout << "Arena exhausted: " << start + bytes << " of " << capacity << " bytes" << std::endl;
+            exit(1);
+        }
+
+        offset = start + bytes;
+        return (T *) (base + start);
+    }
+
+    template <typename T>
+    T *page_slot(size_t count = 1) {
+        return slot<T>(count, page);
+    }
+
+    void reset() {
+        clear(offset);
+        offset = 0;
+    }
+
+    // host-side read of a slot the device may have written
+    template <typename T>
+    T read(const T *ptr) const {
+        T value;
+        if (allocator == CUDA_MALLOC) {
+            cudaMemcpy(&value, ptr, sizeof(T), cudaMemcpyDeviceToHost);
+        } else {
+            value = *ptr;
+        }
+        return value;
+    }
+
+    template <typename T>
+    void read(const T *ptr, size_t count, T *out) const {
+        if (allocator == CUDA_MALLOC) {
+            cudaMemcpy(out, ptr, count * sizeof(T), cudaMemcpyDeviceToHost);
+        } else {
+            memcpy(out, ptr, count * sizeof(T));
+        }
+    }
+
+    Allocator kind() const { return allocator; }
+    size_t page_size() const { return page; }
+
+private:
+    static size_t round_up(size_t value, size_t alignment) {
+        return (value + alignment - 1) / alignment * alignment;
+    }
+
+    void clear(size_t bytes) {
+        if (allocator == CUDA_MALLOC) {
+            cudaMemset(base, 0, bytes);
+        } else {
+            memset(base, 0, bytes);
+        }
+    }
+
+    Allocator allocator;
+    char *base;
+    size_t capacity;
+    size_t offset;
+    size_t page;
+};
+
+#endif // ARENA_CUH
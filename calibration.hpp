@@ -0,0 +1,98 @@
+#ifndef CALIBRATION_HPP
+#define CALIBRATION_HPP
+
+#include <algorithm>
+#include <iostream>
+#include <string>
+
+#include "arena.cuh"
+#include "gpu_pingpong.cuh"
+#include "platform.hpp"
+#include "trace.hpp"
+
+/**
+ * Timer and loop overhead of every clock a measurement is taken with.
+ *
+ * A measured loop reads its clock twice and runs loop control once per
+ * round trip, so what it reports is
+ *
+ *     raw = latency + (read + loop * iterations) / iterations
+ *
+ * and for the fastest same-core cells the overhead is a large share of it.
+ * Each clock is calibrated once, on first use, with the same single-source
+ * protocol the agents run (clock_calibration_protocol), and measure_latency()
+ * reports both raw and corrected numbers. A measured interval shorter than
+ * CALIBRATION_MIN_RESOLUTIONS steps of its clock is quantisation noise;
+ * such results are printed as Unresolved and not recorded.
+ * */
+
+constexpr size_t CALIBRATION_READS = 100000;
+constexpr size_t CALIBRATION_LOOP = 1000000;
+constexpr double CALIBRATION_MIN_RESOLUTIONS = 100.;
+
+struct ClockCalibration {
+    std::string name;
+    double read_ns = 0.;            // one clock read, back to back
+    double resolution_ns = 0.;      // finest step the clock takes
+    double loop_ns = 0.;            // empty-loop control, per iteration
+};
+
+ClockCalibration make_calibration(const std::string &name, const uint64_t *ticks, double ns_per_tick) {
+    ClockCalibration clock;
+    clock.name = name;
+    clock.read_ns = (double) ticks[CALIBRATION_READ_TICKS] * ns_per_tick / (double) CALIBRATION_READS;
+    clock.resolution_ns = (double) ticks[CALIBRATION_RESOLUTION_TICKS] * ns_per_tick;
+    clock.loop_ns = std::max(0., (double) ticks[CALIBRATION_LOOP_TICKS] * ns_per_tick - clock.read_ns) / (double) CALIBRATION_LOOP;
+    return clock;
+}
+
+void host_clock_calibration_function(uint64_t *out) {
+    HostAgent agent;
+    agent.iterations = CALIBRATION_LOOP;
+    clock_calibration_protocol<HostAgent, false>(agent, out, CALIBRATION_READS);
+}
+
+const ClockCalibration &host_clock_calibration() {
+    static ClockCalibration clock = [] {
+        uint64_t ticks[CALIBRATION_SLOTS];
+        host_clock_calibration_function(ticks);
+        return make_calibration("Host Clock", ticks, host_ns_per_tick());
+    }();
+    return clock;
+}
+
+// clock64() for TraceClock = false, globaltimer otherwise; all zero without a device
+template <bool TraceClock>
+const ClockCalibration &device_clock_calibration() {
+    static ClockCalibration clock = [] {
+        const char *name = TraceClock ? "Device Trace Clock" : "Device Clock";
+        if (!platform().has_device) {
+            return ClockCalibration{name};
+        }
+
+        Arena arena(CUDA_MALLOC, 4096);
+        uint64_t *out = arena.slot<uint64_t>(CALIBRATION_SLOTS);
+        device_clock_calibration_kernel<TraceClock><<<1,1>>>(out, CALIBRATION_READS, CALIBRATION_LOOP);
+        cudaDeviceSynchronize();
+
+        uint64_t ticks[CALIBRATION_SLOTS];
+        arena.read(out, CALIBRATION_SLOTS, ticks);
+        return make_calibration(name, ticks, TraceClock ? device_ns_per_tick() : 1000000. / (double) get_gpu_freq());
+    }();
+    return clock;
+}
+
+void print_calibration(std::ostream &out, const ClockCalibration &clock) {
+    out << "Info | Calibration | " << clock.name << " | Read ns : " << clock.read_ns << " | Resolution ns : " << clock.resolution_ns << " | Loop ns : " << clock.loop_ns << std::endl;
+}
+
+// calibrates every clock up front, so no cell pays for it mid-run
+void print_calibrations(std::ostream &out) {
+    print_calibration(out, host_clock_calibration());
+    if (platform().has_device) {
+        print_calibration(out, device_clock_calibration<false>());
+        print_calibration(out, device_clock_calibration<true>());
+    }
+}
+
+#endif // CALIBRATION_HPP
@@ -0,0 +1,64 @@
+#ifndef CLOCK_SYNC_HPP
+#define CLOCK_SYNC_HPP
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include "results.hpp"
+#include "trace.hpp"
+
+/**
+ * Offset and drift between two agents' clocks, for one-way latency.
+ *
+ * A sync phase is a short traced decoupled ping/pong; estimate_clock_offset
+ * picks its tightest NTP-style exchange (trace.hpp). One sync phase runs
+ * before and one after the measurement, and the pong (server) clock is
+ * mapped onto the ping (client) timeline by interpolating between the two:
+ *
+ *     client = server + offset + drift * (server + offset - at)
+ *
+ * The error bound is the larger of the two exchanges' half round trips; a
+ * one-way number is only meaningful when it is well above that bound.
+ * */
+struct ClockSync {
+    double offset_ns;
+    double drift;       // client ns gained per client ns
+    double at_ns;
+    double error_ns;
+
+    double to_client(double server_ns) const {
+        double client = server_ns + offset_ns;
+        return client + drift * (client - at_ns);
+    }
+};
+
+ClockSync combine_clock_offsets(const ClockOffset &before, const ClockOffset &after) {
+    ClockSync sync = {before.offset_ns, 0., before.at_ns, std::max(before.error_ns, after.error_ns)};
+    if (after.at_ns > before.at_ns) {
+        sync.drift = (after.offset_ns - before.offset_ns) / (after.at_ns - before.at_ns);
+    }
+    return sync;
+}
+
+struct OneWayLatency {
+    double ping_to_pong_ns;     // medians over all rounds
+    double pong_to_ping_ns;
+};
+
+// arrivals are raw ticks of each side's trace_clock(), see one_way_protocol
+OneWayLatency one_way_latency(const std::vector<uint64_t> &ping_arrivals, double ping_ns_per_tick, const std::vector<uint64_t> &pong_arrivals, double pong_ns_per_tick, const ClockSync &sync) {
+    std::vector<double> ping_to_pong, pong_to_ping;
+    for (size_t i = 0; i < PINGPONG_ITERATIONS; ++i) {
+        double ping_sent = ping_ns_per_tick * (double) pong_arrivals[2 * i + ONEWAY_SENT];
+        double pong_received = sync.to_client(pong_ns_per_tick * (double) pong_arrivals[2 * i + ONEWAY_RECEIVED]);
+        ping_to_pong.push_back(pong_received - ping_sent);
+
+        double pong_sent = sync.to_client(pong_ns_per_tick * (double) ping_arrivals[2 * i + ONEWAY_SENT]);
+        double ping_received = ping_ns_per_tick * (double) ping_arrivals[2 * i + ONEWAY_RECEIVED];
+        pong_to_ping.push_back(ping_received - pong_sent);
+    }
+    return {median(ping_to_pong), median(pong_to_ping)};
+}
+
+#endif // CLOCK_SYNC_HPP
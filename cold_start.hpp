@@ -0,0 +1,154 @@
+#ifndef COLD_START_HPP
+#define COLD_START_HPP
+
+#include <time.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "pingpong_protocols.cuh"
+#include "platform.hpp"
+#include "results.hpp"
+
+/**
+ * Cold-start latency: the first message after the channel was left alone.
+ *
+ * Ping runs COLD_EPISODES episodes of COLD_ROUNDS round trips, cooling
+ * before each while pong keeps answering, and stamps the end of the cooling
+ * action. The first message of an episode thus includes ping's first
+ * access to the cold flag, which is where the cache, TLB or migration miss
+ * lands; the same episodes without cooling give the steady state. um needs
+ * the device pong: a spinning host pong would fault the page straight back.
+ * */
+
+constexpr size_t COLD_EPISODES = 100;
+constexpr size_t COLD_ROUNDS = 8;
+constexpr size_t COLD_TLB_PAGES = 16384;
+constexpr size_t COLD_EPISODE_STAMPS = 1 + 2 * (COLD_ROUNDS + 1);     // cooled, then the trace
+
+enum CoolingAction {
+    COOL_EVICT,
+    COOL_TLB,
+    COOL_IDLE,
+    COOL_UM
+};
+
+struct Cooling {
+    CoolingAction action;
+    double idle_us = 0.;
+    std::string spec;
+};
+
+bool parse_cooling(const char *spec, Cooling *cooling) {
+    cooling->spec = spec;
+    if (strcmp(spec, "evict") == 0) {
+        cooling->action = COOL_EVICT;
+    } else if (strcmp(spec, "tlb") == 0) {
+        cooling->action = COOL_TLB;
+    } else if (strcmp(spec, "um") == 0) {
+        cooling->action = COOL_UM;
+    } else if (strncmp(spec, "idle:", 5) == 0 && atof(spec + 5) > 0.) {
+        cooling->action = COOL_IDLE;
+        cooling->idle_us = atof(spec + 5);
+    } else {
+        return false;
+    }
+    return true;
+}
+
+// size of cpu0's highest-level cache, 0 if sysfs does not say
+size_t llc_bytes() {
+    size_t bytes = 0;
+    for (int index = 0; ; ++index) {
+        std::string size = read_sysfs("/sys/devices/system/cpu/cpu0/cache/index" + std::to_string(index) + "/size");
+        if (size.empty()) {
+            break;
+        }
+        char unit = size.back();
+        bytes = (size_t) atol(size.c_str()) * (unit == 'K' ? 1024 : unit == 'M' ? 1024 * 1024 : 1);
+    }
+    return bytes;
+}
+
+// shared by every cooling thread and only ever read after it is filled; sized for whichever of evict and tlb reaches further
+const std::vector<char> &cooling_buffer() {
+    static std::vector<char> buffer(std::max(2 * llc_bytes(), COLD_TLB_PAGES * (size_t) sysconf(_SC_PAGESIZE)), 1);
+    return buffer;
+}
+
+// what evict reads: twice the last-level cache, the whole buffer if sysfs does not say
+size_t eviction_bytes() {
+    static size_t bytes = llc_bytes() > 0 ? 2 * llc_bytes() : cooling_buffer().size();
+    return bytes;
+}
+
+void cool(const Cooling &cooling, uint32_t *flag, size_t page) {
+    const std::vector<char> &buffer = cooling_buffer();
+    char sum = 0;
+
+    if (cooling.action == COOL_EVICT) {
+        size_t bytes = eviction_bytes();
+        for (size_t i = 0; i < bytes; i += 64) sum += buffer[i];
+    } else if (cooling.action == COOL_TLB) {
+        for (size_t i = 0; i < COLD_TLB_PAGES; ++i) sum += buffer[i * page];
+    } else if (cooling.action == COOL_IDLE) {
+        struct timespec gap = {(time_t) (cooling.idle_us / 1000000.), (long) (cooling.idle_us * 1000.) % 1000000000L};
+        nanosleep(&gap, nullptr);
+    } else if (cooling.action == COOL_UM) {
+        cudaMemPrefetchAsync((void *) ((uintptr_t) flag & ~(uintptr_t) (page - 1)), page, 0);
+        cudaStreamSynchronize(0);
+    }
+
+    // keeps the reads from being optimised away
+    volatile char sink = sum;
+    (void) sink;
+}
+
+/**
+ * Ping side: COLD_EPISODES decoupled runs of COLD_ROUNDS + 1 receives each,
+ * cooled first unless cooling is nullptr. Episode e stamps the end of its
+ * cooling into stamps[COLD_EPISODE_STAMPS * e] and traces right after it;
+ * the peer answers COLD_EPISODES * (COLD_ROUNDS + 1) times in one go.
+ * */
+void host_cold_ping_function(uint32_t *flag, uint64_t *stamps, const Cooling *cooling, size_t page) {
+    HostAgent agent;
+    agent.iterations = COLD_ROUNDS + 1;
+
+    uint64_t time;
+    for (size_t episode = 0; episode < COLD_EPISODES; ++episode) {
+        uint64_t *episode_stamps = stamps + COLD_EPISODE_STAMPS * episode;
+        if (cooling != nullptr) {
+            cool(*cooling, flag, page);
+        }
+        episode_stamps[0] = HostAgent::trace_clock();
+        agent.trace = episode_stamps + 1;
+        ping_protocol<HostAgent, ACQ_REL, DECOUPLED>(agent, flag, &time);
+    }
+}
+
+struct ColdLatency {
+    double first_ns;        // median over episodes of cooled to the first round trip's answer
+    double first_k_ns;      // median over episodes of the same span to the COLD_ROUNDS-th answer, per round trip
+    double all_ns;          // median over every round trip
+};
+
+// round trip i of an episode is the gap between receives i and i + 1; the first message also covers the wait for receive 0
+ColdLatency cold_latency(const std::vector<uint64_t> &stamps, double ns_per_tick) {
+    std::vector<double> first, first_k, all;
+    for (size_t episode = 0; episode < COLD_EPISODES; ++episode) {
+        uint64_t cooled = stamps[COLD_EPISODE_STAMPS * episode];
+        const uint64_t *receives = stamps.data() + COLD_EPISODE_STAMPS * episode + 1;
+        first.push_back((double) (receives[2 + TRACE_RECEIVE] - cooled) * ns_per_tick);
+        first_k.push_back((double) (receives[2 * COLD_ROUNDS + TRACE_RECEIVE] - cooled) * ns_per_tick / (double) COLD_ROUNDS);
+        for (size_t i = 0; i < COLD_ROUNDS; ++i) {
+            all.push_back((double) (receives[2 * (i + 1) + TRACE_RECEIVE] - receives[2 * i + TRACE_RECEIVE]) * ns_per_tick);
+        }
+    }
+    return {median(first), median(first_k), median(all)};
+}
+
+#endif // COLD_START_HPP
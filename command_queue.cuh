@@ -0,0 +1,170 @@
+#ifndef COMMAND_QUEUE_CUH
+#define COMMAND_QUEUE_CUH
+
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "cpu_utils.hpp"
+#include "pingpong_protocols.cuh"
+
+/**
+ * Submission queue to a persistent consumer.
+ *
+ * The consumer is started once and serves every command. The producer
+ * writes commands into a ring and publishes how far it has written through
+ * a doorbell, rung as its DoorbellPolicy says and always before it waits
+ * for ring space or for the last completions, so no policy can strand a
+ * command.
+ * */
+
+constexpr size_t CQ_CAPACITY = 256;
+constexpr size_t CQ_COMMANDS = 10 * PINGPONG_ITERATIONS;
+
+enum DoorbellMode {
+    DOORBELL_EACH,
+    DOORBELL_COUNT,
+    DOORBELL_TIME
+};
+
+struct DoorbellPolicy {
+    DoorbellMode mode = DOORBELL_EACH;
+    size_t count = 1;       // DOORBELL_COUNT
+    double ns = 0.;         // DOORBELL_TIME
+};
+
+const DoorbellPolicy DOORBELL_POLICIES[] = {
+    {DOORBELL_EACH, 1, 0.}, {DOORBELL_COUNT, 4, 0.}, {DOORBELL_COUNT, 16, 0.}, {DOORBELL_COUNT, 64, 0.}, {DOORBELL_TIME, 1, 1000.}, {DOORBELL_TIME, 1, 10000.}
+};
+
+std::string doorbell_name(const DoorbellPolicy &policy) {
+    std::ostringstream name;
+    if (policy.mode == DOORBELL_EACH) {
+        name << "Each";
+    } else if (policy.mode == DOORBELL_COUNT) {
+        name << "Every " << policy.count;
+    } else {
+        name << "Every " << policy.ns << " ns";
+    }
+    return name.str();
+}
+
+bool parse_doorbell_policies(const char *spec, std::vector<DoorbellPolicy> *policies) {
+    policies->clear();
+    if (strcmp(spec, "default") == 0) {
+        policies->assign(std::begin(DOORBELL_POLICIES), std::end(DOORBELL_POLICIES));
+        return true;
+    }
+
+    std::istringstream list(spec);
+    std::string item;
+    while (std::getline(list, item, ',')) {
+        DoorbellPolicy policy;
+        if (item == "each") {
+            policy.mode = DOORBELL_EACH;
+        } else if (item.compare(0, 2, "k:") == 0 && atoi(item.c_str() + 2) >= 1 && (size_t) atoi(item.c_str() + 2) <= CQ_CAPACITY) {
+            policy.mode = DOORBELL_COUNT;
+            policy.count = (size_t) atoi(item.c_str() + 2);
+        } else if (item.compare(0, 2, "t:") == 0 && atof(item.c_str() + 2) > 0.) {
+            policy.mode = DOORBELL_TIME;
+            policy.ns = atof(item.c_str() + 2);
+        } else {
+            return false;
+        }
+        policies->push_back(policy);
+    }
+    return !policies->empty();
+}
+
+struct CommandRing {
+    uint64_t *doorbell;     // commands written, as last rung
+    uint64_t *done;         // commands completed
+    uint64_t *commands;     // CQ_CAPACITY of them
+    uint64_t *results;
+};
+
+// the persistent consumer: runs every command up to the doorbell, then reports how far it got, agent.iterations commands in all
+#pragma nv_exec_check_disable
+template <typename Agent>
+__host__ __device__ void command_consumer_protocol(Agent &agent, uint64_t *doorbell_ptr, uint64_t *done_ptr, uint64_t *commands, uint64_t *results) {
+    typename Agent::template ref<uint64_t> doorbell(*doorbell_ptr);
+    typename Agent::template ref<uint64_t> done(*done_ptr);
+
+    for (uint64_t head = 0; head < agent.iterations; ) {
+        uint64_t tail = doorbell.load(Agent::acquire);
+        if (tail == head) {
+            Agent::pause();
+            continue;
+        }
+        for (; head < tail; ++head) {
+            results[head % CQ_CAPACITY] = commands[head % CQ_CAPACITY] + 1;
+        }
+        done.store(head, Agent::release);
+    }
+}
+
+void host_command_consumer_function(CommandRing ring, size_t count) {
+    HostAgent agent;
+    agent.iterations = count;
+    command_consumer_protocol<HostAgent>(agent, ring.doorbell, ring.done, ring.commands, ring.results);
+}
+
+/**
+ * latencies[i] is in CPU ticks from command i's enqueue to its completion
+ * being seen; elapsed covers the whole run.
+ * */
+void command_producer(CommandRing ring, DoorbellPolicy policy, size_t count, std::vector<uint64_t> *latencies, uint64_t *elapsed, size_t *doorbells) {
+    std::atomic_ref<uint64_t> doorbell(*ring.doorbell);
+    std::atomic_ref<uint64_t> done(*ring.done);
+    uint64_t threshold = (uint64_t) (policy.ns * (double) get_cpu_freq() / 1000000000.);
+
+    std::vector<uint64_t> enqueued(count);
+    latencies->assign(count, 0);
+    *doorbells = 0;
+
+    size_t tail = 0, rung = 0, collected = 0;
+    auto ring_bell = [&]() {
+        doorbell.store(tail, std::memory_order_release);
+        rung = tail;
+        (*doorbells)++;
+    };
+    auto collect = [&]() {
+        size_t completed = (size_t) done.load(std::memory_order_acquire);
+        uint64_t now = get_cpu_clock();
+        for (; collected < completed; ++collected) {
+            (*latencies)[collected] = now - enqueued[collected];
+        }
+    };
+
+    uint64_t start = get_cpu_clock();
+    while (tail < count) {
+        if (tail - collected >= CQ_CAPACITY) {
+            if (rung < tail) ring_bell();
+            collect();
+            continue;
+        }
+
+        ring.commands[tail % CQ_CAPACITY] = tail;
+        enqueued[tail] = get_cpu_clock();
+        tail++;
+
+        if (policy.mode == DOORBELL_EACH
+            || (policy.mode == DOORBELL_COUNT && tail - rung >= policy.count)
+            || (policy.mode == DOORBELL_TIME && get_cpu_clock() - enqueued[rung] >= threshold)) {
+            ring_bell();
+        }
+        collect();
+    }
+
+    if (rung < tail) ring_bell();
+    while (collected < count) {
+        collect();
+    }
+    *elapsed = get_cpu_clock() - start;
+}
+
+#endif // COMMAND_QUEUE_CUH
@@ -0,0 +1,321 @@
+#ifndef COMPARE_HPP
+#define COMPARE_HPP
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "results.hpp"
+
+/**
+ * Compare mode: is this run slower than a stored one?
+ *
+ * The baseline is the saved output of an earlier run; its result and
+ * platform lines are read back and Info lines skipped. Per experiment/key, a
+ * pair regresses only when its median moved the wrong way by more than the
+ * threshold *and* a two-sided Mann-Whitney U test says the shift is real.
+ * Pairs whose trial counts cannot reach COMPARE_ALPHA at all (1 or 3 per
+ * side, say) are warned about instead of silently passing.
+ * */
+
+constexpr double COMPARE_DEFAULT_THRESHOLD = 5.;    // percent
+constexpr double COMPARE_ALPHA = 0.05;
+
+// parses one report_result() line; false for anything else
+bool parse_result_line(const std::string &line, ResultRecord *record) {
+    if (line.starts_with("Info | ")) {
+        return false;
+    }
+
+    size_t bar = line.find(" | ");
+    if (bar == std::string::npos) {
+        return false;
+    }
+
+    record->experiment = line.substr(0, bar);
+    record->fields.clear();
+    record->allocator.clear();
+    record->platform.clear();
+
+    while (bar != std::string::npos) {
+        size_t start = bar + 3;
+        bar = line.find(" | ", start);
+        std::string field = line.substr(start, bar == std::string::npos ? std::string::npos : bar - start);
+
+        size_t colon = field.find(" : ");
+        if (colon == std::string::npos) {
+            return false;
+        }
+
+        std::string key = field.substr(0, colon);
+        std::string value = field.substr(colon + 3);
+        FieldKind kind = LOWER_IS_BETTER;
+        for (FieldKind tagged : {HIGHER_IS_BETTER, DESCRIPTIVE}) {
+            if (key.ends_with(FIELD_KIND_TAGS[tagged])) {
+                key.erase(key.size() - strlen(FIELD_KIND_TAGS[tagged]));
+                kind = tagged;
+            }
+        }
+        if (key == "Platform") {
+            record->platform = value;
+            continue;
+        } else if (key == "Allocator") {
+            record->allocator = value;
+            continue;
+        }
+
+        char *end;
+        double number = strtod(value.c_str(), &end);
+        if (end == value.c_str() || *end != '\0') {
+            return false;
+        }
+        record->fields.push_back({key, number, kind});
+    }
+
+    return !record->fields.empty();
+}
+
+// parses a print_platform() line; false for anything else
+bool parse_platform_line(const std::string &line, std::string *id, PlatformFields *fields) {
+    if (line.compare(0, 9, "Platform ") != 0) {
+        return false;
+    }
+
+    size_t bar = line.find(" | ");
+    *id = line.substr(9, bar == std::string::npos ? std::string::npos : bar - 9);
+    fields->clear();
+    while (bar != std::string::npos) {
+        size_t start = bar + 3;
+        bar = line.find(" | ", start);
+        std::string field = line.substr(start, bar == std::string::npos ? std::string::npos : bar - start);
+
+        size_t colon = field.find(" : ");
+        if (colon == std::string::npos) {
+            return false;
+        }
+        fields->push_back({field.substr(0, colon), field.substr(colon + 3)});
+    }
+    return true;
+}
+
+// platforms collects the fingerprint behind every platform id the file prints
+bool load_results(const char *path, std::vector<ResultRecord> *records, std::map<std::string, PlatformFields> *platforms) {
+    std::ifstream in(path);
+    if (!in) {
+        std::cout << "Could not open baseline " << path << std::endl;
+        return false;
+    }
+
+    std::string line, id;
+    ResultRecord record;
+    PlatformFields fields;
+    while (std::getline(in, line)) {
+        if (parse_platform_line(line, &id, &fields)) {
+            (*platforms)[id] = fields;
+        } else if (parse_result_line(line, &record)) {
+            records->push_back(record);
+        }
+    }
+
+    if (records->empty()) {
+        std::cout << "Baseline " << path << " has no results" << std::endl;
+        return false;
+    }
+
+    return true;
+}
+
+// one value per trial, in the order the trials ran
+struct TrialSeries {
+    FieldKind kind = LOWER_IS_BETTER;
+    std::vector<double> values;
+};
+
+// experiment [allocator]/key -> its trials
+typedef std::map<std::pair<std::string, std::string>, TrialSeries> TrialSamples;
+
+TrialSamples group_trials(const std::vector<ResultRecord> &records) {
+    TrialSamples samples;
+    for (const ResultRecord &record : records) {
+        for (const ResultField &field : record.fields) {
+            if (field.kind != DESCRIPTIVE) {
+                std::string experiment = record.allocator.empty() ? record.experiment : record.experiment + " [" + record.allocator + "]";
+                TrialSeries &series = samples[{experiment, field.key}];
+                series.kind = field.kind;
+                series.values.push_back(field.value);
+            }
+        }
+    }
+    return samples;
+}
+
+constexpr size_t COMPARE_EXACT_MAX = 20;     // trials per side up to which U is tested exactly
+
+// ways[u] = arrangements of n1 against n2 untied samples with U = u
+std::vector<double> mann_whitney_counts(size_t n1, size_t n2) {
+    size_t cells = n1 * n2 + 1;
+    std::vector<double> ways((n1 + 1) * (n2 + 1) * cells, 0.);
+    auto at = [&](size_t i, size_t j, size_t u) -> double & { return ways[(i * (n2 + 1) + j) * cells + u]; };
+
+    for (size_t i = 0; i <= n1; ++i) {
+        for (size_t j = 0; j <= n2; ++j) {
+            if (i == 0 || j == 0) {
+                at(i, j, 0) = 1.;
+                continue;
+            }
+            // the largest sample is either one of a's (beating all j of b's) or one of b's
+            for (size_t u = 0; u <= i * j; ++u) {
+                at(i, j, u) = (u >= j ? at(i - 1, j, u - j) : 0.) + at(i, j - 1, u);
+            }
+        }
+    }
+    return std::vector<double>(&at(n1, n2, 0), &at(n1, n2, 0) + cells);
+}
+
+// the smallest two-sided p any outcome can reach with n1 against n2 trials
+double mann_whitney_min_p(size_t n1, size_t n2) {
+    if (n1 == 0 || n2 == 0) {
+        return 1.;
+    }
+    double arrangements = 1.;
+    for (size_t k = 1; k <= n2; ++k) {
+        arrangements = arrangements * (double) (n1 + k) / (double) k;
+    }
+    return std::min(1., 2. / arrangements);
+}
+
+/**
+ * Two-sided p-value of the Mann-Whitney U test: exact up to
+ * COMPARE_EXACT_MAX trials per side (mid-ranks for ties, against the untied
+ * distribution), normal approximation with tie correction above that.
+ * */
+double mann_whitney_p(const std::vector<double> &a, const std::vector<double> &b) {
+    std::vector<std::pair<double, int>> pooled;
+    for (double x : a) pooled.push_back({x, 0});
+    for (double x : b) pooled.push_back({x, 1});
+    std::sort(pooled.begin(), pooled.end());
+
+    double n1 = a.size(), n2 = b.size(), n = n1 + n2;
+    double rank_sum_a = 0., tie_term = 0.;
+
+    for (size_t i = 0; i < pooled.size();) {
+        size_t j = i;
+        while (j < pooled.size() && pooled[j].first == pooled[i].first) ++j;
+
+        double rank = (i + 1 + j) / 2.;     // average of ranks i+1 .. j
+        double ties = j - i;
+        tie_term += ties * ties * ties - ties;
+        for (size_t k = i; k < j; ++k) {
+            if (pooled[k].second == 0) rank_sum_a += rank;
+        }
+        i = j;
+    }
+
+    double u = rank_sum_a - n1 * (n1 + 1) / 2.;
+    double mean = n1 * n2 / 2.;
+
+    if (a.size() <= COMPARE_EXACT_MAX && b.size() <= COMPARE_EXACT_MAX) {
+        if (a.empty() || b.empty()) {
+            return 1.;
+        }
+        std::vector<double> ways = mann_whitney_counts(a.size(), b.size());
+        double extreme = 0., total = 0.;
+        for (size_t k = 0; k < ways.size(); ++k) {
+            total += ways[k];
+            if (std::fabs((double) k - mean) >= std::fabs(u - mean) - 1e-9) extreme += ways[k];
+        }
+        return std::min(1., extreme / total);
+    }
+
+    double variance = n1 * n2 / 12. * ((n + 1) - tie_term / (n * (n - 1)));
+    if (variance <= 0.) {
+        return 1.;
+    }
+
+    double z = (std::fabs(u - mean) - 0.5) / std::sqrt(variance);
+    return z <= 0. ? 1. : std::erfc(z / std::sqrt(2.));
+}
+
+// prints the delta table and returns how many experiment/key pairs regressed
+int compare_results(const std::vector<ResultRecord> &baseline, const std::map<std::string, PlatformFields> &platforms, const std::vector<ResultRecord> &current, double threshold) {
+    std::set<std::string> baseline_platforms;
+    for (const ResultRecord &record : baseline) {
+        baseline_platforms.insert(record.platform);
+    }
+    PlatformFields now = platform_fields(platform());
+    for (const std::string &id : baseline_platforms) {
+        if (id == platform().id) {
+            continue;
+        }
+        std::cout << "Info | Compare | Note : baseline platform " << id << " differs from " << platform().id << std::endl;
+
+        auto fingerprint = platforms.find(id);
+        if (fingerprint == platforms.end()) {
+            std::cout << "Info | Compare | Note : baseline has no fingerprint for " << id << std::endl;
+            continue;
+        }
+        for (const auto &field : now) {
+            auto before = std::find_if(fingerprint->second.begin(), fingerprint->second.end(), [&](const auto &old) { return old.first == field.first; });
+            std::string old_value = before == fingerprint->second.end() ? "(missing)" : before->second;
+            if (old_value != field.second) {
+                std::cout << "Info | Compare | Platform | " << field.first << " | Baseline : " << old_value << " | Current : " << field.second << std::endl;
+            }
+        }
+    }
+
+    TrialSamples before = group_trials(baseline);
+    TrialSamples after = group_trials(current);
+
+    int regressions = 0, untestable = 0;
+    std::cout << std::fixed << std::setprecision(2);
+    for (const auto &entry : after) {
+        auto match = before.find(entry.first);
+        if (match == before.end()) {
+            std::cout << "Info | Compare | " << entry.first.first << " | " << entry.first.second << " | not in baseline" << std::endl;
+            continue;
+        }
+
+        const std::vector<double> &old_values = match->second.values;
+        const std::vector<double> &new_values = entry.second.values;
+        double old_median = median(old_values);
+        double new_median = median(new_values);
+        double delta = old_median == 0. ? 0. : (new_median - old_median) / old_median * 100.;
+        if (entry.second.kind == HIGHER_IS_BETTER) delta = -delta;
+        double p = mann_whitney_p(old_values, new_values);
+        bool testable = mann_whitney_min_p(old_values.size(), new_values.size()) < COMPARE_ALPHA;
+        bool regressed = delta > threshold && p < COMPARE_ALPHA;
+        regressions += regressed;
+        untestable += !testable;
+
+        std::cout << "Info | Compare | " << entry.first.first << " | " << entry.first.second
+                  << " | Baseline : " << old_median << " (" << old_values.size() << ")"
+                  << " | Current : " << new_median << " (" << new_values.size() << ")"
+                  << " | Delta % : " << delta
+                  << " | p : " << std::setprecision(4) << p << std::setprecision(2)
+                  << " | " << (regressed ? "REGRESSION" : testable ? "ok" : "too few trials") << std::endl;
+    }
+    std::cout << std::defaultfloat << std::setprecision(6);
+
+    for (const auto &entry : before) {
+        if (after.find(entry.first) == after.end()) {
+            std::cout << "Info | Compare | " << entry.first.first << " | " << entry.first.second << " | not run" << std::endl;
+        }
+    }
+
+    std::cout << "Info | Compare | Summary | Regressions : " << regressions << " | Threshold % : " << threshold << std::endl;
+    if (untestable > 0) {
+        std::cout << "Info | Compare | Warning : " << untestable << " pair(s) have too few trials to reach p < " << COMPARE_ALPHA
+                  << " on either side; run baseline and current with -t 4 or more" << std::endl;
+    }
+    return regressions;
+}
+
+#endif // COMPARE_HPP
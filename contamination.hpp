@@ -0,0 +1,184 @@
+#ifndef CONTAMINATION_HPP
+#define CONTAMINATION_HPP
+
+#include <sched.h>
+#include <sys/resource.h>
+#include <time.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <set>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "platform.hpp"
+
+/**
+ * Did anything disturb a measurement?
+ *
+ * A cell's measured region runs from its first host agent starting (see
+ * pinned_thread in cpu_pingpong.hpp) to its result being reported. Over it:
+ *  - every agent counts its own context switches (getrusage RUSAGE_THREAD)
+ *    and checks with sched_getcpu() that it started and ended on its core
+ *  - /proc/interrupts is diffed on the cores the agents were pinned to
+ *  - scaling_cur_freq of those cores is read at both ends
+ *
+ * A result whose region exceeds any threshold is flagged with the counts
+ * (descriptive fields, never compared), or with -x printed as Contaminated
+ * and not recorded. Agents that block on purpose (allow_blocking on their
+ * core) only count involuntary switches. Device-only cells have no host agents
+ * and are not monitored. cpufreq is a sampled reading, not APERF/MPERF, so
+ * a short excursion between the two reads goes unseen.
+ * */
+
+constexpr long CONTAMINATION_MAX_SWITCHES = 0;
+constexpr long CONTAMINATION_MAX_MIGRATIONS = 0;
+constexpr double CONTAMINATION_MAX_INTERRUPTS_PER_MS = 2.;     // per core; a 1000 Hz tick is 1
+constexpr double CONTAMINATION_MAX_FREQ_DELTA = 5.;            // percent
+
+struct ContaminationConfig {
+    bool discard = false;
+};
+
+ContaminationConfig &contamination_config() {
+    static ContaminationConfig config;
+    return config;
+}
+
+// per-CPU totals over every line of /proc/interrupts
+std::vector<long long> read_interrupts() {
+    std::ifstream in("/proc/interrupts");
+    std::string header;
+    std::getline(in, header);
+
+    std::istringstream columns(header);
+    std::string column;
+    size_t cpus = 0;
+    while (columns >> column) {
+        cpus++;
+    }
+
+    std::vector<long long> totals(cpus, 0);
+    std::string line;
+    while (std::getline(in, line)) {
+        size_t colon = line.find(':');
+        if (colon == std::string::npos) {
+            continue;
+        }
+        std::istringstream counts(line.substr(colon + 1));
+        long long count;
+        for (size_t cpu = 0; cpu < cpus && counts >> count; ++cpu) {
+            totals[cpu] += count;
+        }
+    }
+    return totals;
+}
+
+long read_cur_khz(int cpu) {
+    return atol(read_sysfs("/sys/devices/system/cpu/cpu" + std::to_string(cpu) + "/cpufreq/scaling_cur_freq").c_str());
+}
+
+double monotonic_ms() {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (double) now.tv_sec * 1000. + (double) now.tv_nsec / 1000000.;
+}
+
+struct Contamination {
+    long switches = 0;
+    long migrations = 0;
+    long long interrupts = 0;
+    double freq_delta = 0.;     // percent, largest over the cores
+    bool exceeded = false;
+};
+
+class ContaminationMonitor {
+public:
+    // called by the spawning thread for every agent, before the agent starts
+    void add_agent(int core) {
+        if (!active) {
+            active = true;
+            start_ms = monotonic_ms();
+            interrupts = read_interrupts();
+            khz.clear();
+            cores.clear();
+            switches = 0;
+            migrations = 0;
+        }
+        if (cores.insert(core).second) {
+            khz.push_back({core, read_cur_khz(core)});
+        }
+    }
+
+    // the agent on this core sleeps by design; its voluntary switches are not a disturbance
+    void allow_blocking(int core) {
+        blocking.insert(core);
+    }
+
+    // called by the agent itself around its body
+    void agent_started(int core) {
+        if (sched_getcpu() != core) migrations++;
+    }
+
+    void agent_finished(int core, const struct rusage &before) {
+        struct rusage after;
+        getrusage(RUSAGE_THREAD, &after);
+        switches += (blocking.count(core) ? 0 : after.ru_nvcsw - before.ru_nvcsw) + (after.ru_nivcsw - before.ru_nivcsw);
+        if (sched_getcpu() != core) migrations++;
+    }
+
+    // ends the region; zero and not exceeded when no agent ran
+    Contamination finish() {
+        Contamination result;
+        if (!active) {
+            return result;
+        }
+        active = false;
+        blocking.clear();
+
+        double elapsed_ms = monotonic_ms() - start_ms;
+        std::vector<long long> now = read_interrupts();
+        for (int core : cores) {
+            if ((size_t) core < now.size() && (size_t) core < interrupts.size()) {
+                result.interrupts += now[core] - interrupts[core];
+            }
+        }
+        for (const auto &reading : khz) {
+            long after = read_cur_khz(reading.first);
+            if (reading.second > 0 && after > 0) {
+                result.freq_delta = std::max(result.freq_delta, 100. * std::fabs((double) (after - reading.second)) / (double) reading.second);
+            }
+        }
+        result.switches = switches;
+        result.migrations = migrations;
+
+        result.exceeded = result.switches > CONTAMINATION_MAX_SWITCHES
+                       || result.migrations > CONTAMINATION_MAX_MIGRATIONS
+                       || (double) result.interrupts > CONTAMINATION_MAX_INTERRUPTS_PER_MS * elapsed_ms * (double) cores.size()
+                       || result.freq_delta > CONTAMINATION_MAX_FREQ_DELTA;
+        return result;
+    }
+
+private:
+    bool active = false;
+    std::set<int> blocking;     // filled before the agents start, only read by them
+    double start_ms = 0.;
+    std::vector<long long> interrupts;
+    std::vector<std::pair<int, long>> khz;
+    std::set<int> cores;
+    std::atomic<long> switches{0};
+    std::atomic<long> migrations{0};
+};
+
+// the region of the cell running on this thread (sweep workers each have one)
+ContaminationMonitor &contamination() {
+    thread_local ContaminationMonitor monitor;
+    return monitor;
+}
+
+#endif // CONTAMINATION_HPP
@@ -0,0 +1,208 @@
+#ifndef COROUTINE_CHANNELS_HPP
+#define COROUTINE_CHANNELS_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <coroutine>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "cpu_utils.hpp"
+#include "pingpong_protocols.cuh"
+
+/**
+ * Many ping/pong channels multiplexed on one thread per side.
+ *
+ * Each channel is a C++20 coroutine that co_awaits a flag change; one
+ * polling scheduler per side checks every suspended channel's flag once per
+ * pass and resumes the ones that changed. The baseline is a spinning thread
+ * per channel and side; past 2N CPUs those wrap around the CPUs and take
+ * turns (spin, then yield), are labelled Oversubscribed, and switch by
+ * construction, so the contamination monitor flags them.
+ * */
+
+constexpr size_t CORO_ROUND_TRIPS = 10 * PINGPONG_ITERATIONS;
+constexpr size_t CORO_MIN_ROUNDS = 16;
+constexpr size_t CORO_MAX_CHANNELS = 4096;
+constexpr size_t CORO_MAX_THREADED = 1024;
+constexpr size_t CORO_SPINS = 1000;        // polls before a thread-per-channel agent yields
+const size_t CORO_CHANNELS[] = {1, 16, 64, 256, 1024, 4096};
+
+bool parse_channel_sweep(const char *spec, std::vector<size_t> *channels) {
+    channels->clear();
+    if (strcmp(spec, "default") == 0) {
+        channels->assign(std::begin(CORO_CHANNELS), std::end(CORO_CHANNELS));
+        return true;
+    }
+
+    std::istringstream list(spec);
+    std::string count;
+    while (std::getline(list, count, ',')) {
+        int value = atoi(count.c_str());
+        if (value < 1 || (size_t) value > CORO_MAX_CHANNELS) {
+            return false;
+        }
+        channels->push_back((size_t) value);
+    }
+    return !channels->empty();
+}
+
+size_t channel_rounds(size_t channels) {
+    return std::max(CORO_MIN_ROUNDS, CORO_ROUND_TRIPS / channels);
+}
+
+// a channel body; started and destroyed by the scheduler
+struct ChannelTask {
+    struct promise_type {
+        ChannelTask get_return_object() { return {std::coroutine_handle<promise_type>::from_promise(*this)}; }
+        std::suspend_always initial_suspend() noexcept { return {}; }
+        std::suspend_always final_suspend() noexcept { return {}; }
+        void return_void() {}
+        void unhandled_exception() { std::terminate(); }
+    };
+
+    std::coroutine_handle<promise_type> handle;
+};
+
+/**
+ * Runs every spawned channel until it first waits, then polls the waiting
+ * ones in passes until none is left. A channel whose flag already holds the
+ * value it waits for does not suspend at all.
+ * */
+class PollingScheduler {
+public:
+    struct FlagAwaiter {
+        PollingScheduler &scheduler;
+        uint32_t *flag;
+        uint32_t value;
+
+        bool await_ready() const { return std::atomic_ref<uint32_t>(*flag).load(std::memory_order_acquire) == value; }
+        void await_suspend(std::coroutine_handle<> handle) { scheduler.waiting.push_back({handle, flag, value}); }
+        void await_resume() const {}
+    };
+
+    PollingScheduler() = default;
+    PollingScheduler(const PollingScheduler &) = delete;
+    PollingScheduler &operator=(const PollingScheduler &) = delete;
+
+    ~PollingScheduler() {
+        for (std::coroutine_handle<> task : tasks) {
+            task.destroy();
+        }
+    }
+
+    FlagAwaiter until(uint32_t *flag, uint32_t value) {
+        return {*this, flag, value};
+    }
+
+    void spawn(ChannelTask task) {
+        tasks.push_back(task.handle);
+    }
+
+    void run() {
+        for (std::coroutine_handle<> task : tasks) {
+            task.resume();
+        }
+        while (!waiting.empty()) {
+            polling.swap(waiting);
+            waiting.clear();
+            for (const Waiter &waiter : polling) {
+                if (std::atomic_ref<uint32_t>(*waiter.flag).load(std::memory_order_acquire) == waiter.value) {
+                    waiter.handle.resume();
+                } else {
+                    waiting.push_back(waiter);
+                }
+            }
+            asm volatile("" ::: "memory");
+        }
+    }
+
+private:
+    struct Waiter {
+        std::coroutine_handle<> handle;
+        uint32_t *flag;
+        uint32_t value;
+    };
+
+    std::vector<std::coroutine_handle<>> tasks;
+    std::vector<Waiter> waiting, polling;
+};
+
+// latencies[i] is round trip i in CPU ticks
+ChannelTask channel_ping(PollingScheduler &scheduler, uint32_t *flag_ptr, size_t rounds, uint64_t *latencies) {
+    std::atomic_ref<uint32_t> flag(*flag_ptr);
+    for (size_t i = 0; i < rounds; ++i) {
+        uint64_t start = get_cpu_clock();
+        flag.store(PING, std::memory_order_release);
+        co_await scheduler.until(flag_ptr, PONG);
+        latencies[i] = get_cpu_clock() - start;
+    }
+}
+
+ChannelTask channel_pong(PollingScheduler &scheduler, uint32_t *flag_ptr, size_t rounds) {
+    std::atomic_ref<uint32_t> flag(*flag_ptr);
+    for (size_t i = 0; i < rounds; ++i) {
+        co_await scheduler.until(flag_ptr, PING);
+        flag.store(PONG, std::memory_order_release);
+    }
+}
+
+// yields, so the thread that raises go gets a turn on an oversubscribed core
+inline void wait_for_go(uint64_t *go_ptr) {
+    while (std::atomic_ref<uint64_t>(*go_ptr).load(std::memory_order_acquire) == 0) std::this_thread::yield();
+}
+
+// every channel's pinger on this thread; finished is stamped once the last round trip is in
+void coroutine_pinger(uint64_t *go, const std::vector<uint32_t *> &flags, size_t rounds, uint64_t *latencies, uint64_t *finished) {
+    PollingScheduler scheduler;
+    for (size_t i = 0; i < flags.size(); ++i) {
+        scheduler.spawn(channel_ping(scheduler, flags[i], rounds, latencies + i * rounds));
+    }
+    wait_for_go(go);
+    scheduler.run();
+    *finished = get_cpu_clock();
+}
+
+void coroutine_ponger(uint64_t *go, const std::vector<uint32_t *> &flags, size_t rounds) {
+    PollingScheduler scheduler;
+    for (uint32_t *flag : flags) {
+        scheduler.spawn(channel_pong(scheduler, flag, rounds));
+    }
+    wait_for_go(go);
+    scheduler.run();
+}
+
+inline void wait_for_flag(std::atomic_ref<uint32_t> &flag, uint32_t value) {
+    for (size_t spins = 0; flag.load(std::memory_order_acquire) != value; ++spins) {
+        if (spins >= CORO_SPINS) std::this_thread::yield();
+    }
+}
+
+void threaded_pinger(uint64_t *go, uint32_t *flag_ptr, size_t rounds, uint64_t *latencies, uint64_t *finished) {
+    std::atomic_ref<uint32_t> flag(*flag_ptr);
+    wait_for_go(go);
+    for (size_t i = 0; i < rounds; ++i) {
+        uint64_t start = get_cpu_clock();
+        flag.store(PING, std::memory_order_release);
+        wait_for_flag(flag, PONG);
+        latencies[i] = get_cpu_clock() - start;
+    }
+    *finished = get_cpu_clock();
+}
+
+void threaded_ponger(uint64_t *go, uint32_t *flag_ptr, size_t rounds) {
+    std::atomic_ref<uint32_t> flag(*flag_ptr);
+    wait_for_go(go);
+    for (size_t i = 0; i < rounds; ++i) {
+        wait_for_flag(flag, PING);
+        flag.store(PONG, std::memory_order_release);
+    }
+}
+
+#endif // COROUTINE_CHANNELS_HPP
@@ -1,2561 +1,1321 @@
 #ifndef CPU_PINGPONG_HPP
 #define CPU_PINGPONG_HPP
 
+#include <functional>
+#include <sstream>
+#include <thread>
+
+#include "arena.cuh"
+#include "cold_start.hpp"
+#include "coroutine_channels.hpp"
+#include "fan.hpp"
 #include "gpu_pingpong.cuh"
-
-void host_fetch_add_relaxed(std::atomic<uint16_t> *flag, std::atomic<uint16_t> *sig, uint64_t *time) {
-    // while (sig->load() == PONG);
-
-    sig->fetch_add(PING);
-    while(sig->load() != PANG);
-
-    uint64_t start = get_cpu_clock();
-    for (size_t i = 0; i < 10000; ++i) {
-        flag->fetch_add(1, std::memory_order_relaxed);
-    }
-    uint64_t end = get_cpu_clock();
-    *time = end - start;
+#include "idle_gap.hpp"
+#include "latency_model.hpp"
+#include "low_jitter.hpp"
+#include "mailbox.hpp"
+#include "open_loop.hpp"
+#include "clock_sync.hpp"
+#include "results.hpp"
+#include "run_length.hpp"
+#include "selection.hpp"
+#include "token_ring.hpp"
+#include "trace.hpp"
+#include "work_stealing.cuh"
+
+template <MemOrder Order>
+void host_fetch_add_function(uint32_t *flag, uint32_t *sig, uint64_t *time, size_t iterations) {
+    HostAgent agent;
+    agent.iterations = iterations;
+    fetch_add_protocol<HostAgent, Order, START_HANDSHAKE>(agent, flag, sig, time);
 }
 
-void host_fetch_add_acqrel(std::atomic<uint16_t> *flag, std::atomic<uint16_t> *sig, uint64_t *time) {
-    // while (sig->load() == PONG);
-
-    sig->fetch_add(PING);
-    while(sig->load() != PANG);
-
-    uint64_t start = get_cpu_clock();
-    for (size_t i = 0; i < 10000; ++i) {
-        flag->fetch_add(1, std::memory_order_acq_rel);
-    }
-    uint64_t end = get_cpu_clock();
-    *time = end - start;
+// change ping to pong
+template <MemOrder Order, PingPongProtocol Protocol>
+void host_ping_function(uint32_t *flag, uint64_t *time, uint64_t *trace, size_t iterations) {
+    HostAgent agent;
+    agent.trace = trace;
+    agent.iterations = iterations;
+    ping_protocol<HostAgent, Order, Protocol>(agent, flag, time);
 }
 
-void host_fetch_add_seqcst(std::atomic<uint16_t> *flag, std::atomic<uint16_t> *sig, uint64_t *time) {
-    // while (sig->load() == PONG);
-
-    sig->fetch_add(PING);
-    while(sig->load() != PANG);
-
-    uint64_t start = get_cpu_clock();
-    for (size_t i = 0; i < 10000; ++i) {
-        flag->fetch_add(1, std::memory_order_seq_cst);
-    }
-    uint64_t end = get_cpu_clock();
-    *time = end - start;
+// change pong to ping
+template <MemOrder Order, PingPongProtocol Protocol>
+void host_pong_function(uint32_t *flag, uint64_t *trace, size_t iterations) {
+    HostAgent agent;
+    agent.trace = trace;
+    agent.iterations = iterations;
+    pong_protocol<HostAgent, Order, Protocol>(agent, flag);
 }
 
-// change ping to pong
-void host_ping_function_relaxed_base(std::atomic<uint16_t> *flag, uint64_t *time) {
-    while (flag->load() == PONG);
-    uint16_t expected = PING;
-
-    uint64_t start = get_cpu_clock();
-    for (size_t i = 0; i < 10000; ++i) {
-        while (!flag->compare_exchange_strong(expected, PONG, std::memory_order_relaxed, std::memory_order_relaxed)) {
-            expected = PING;
-        }
-        std::cout << i << std::endl;
-    }
-    uint64_t end = get_cpu_clock();
-    *time = end - start;
+// host stand-in for the device pong; every PING becomes visible to the peer only after an injected delay
+template <MemOrder Order, PingPongProtocol Protocol>
+void host_pong_function_simulated(uint32_t *flag, LatencyInjector *injector, uint64_t *trace, size_t iterations) {
+    SimulatedAgent agent(injector);
+    agent.trace = trace;
+    agent.iterations = iterations;
+    pong_protocol<SimulatedAgent, Order, Protocol>(agent, flag);
 }
 
+void host_ping_one_way_function(uint32_t *flag, uint64_t *message, uint64_t *arrivals) {
+    HostAgent agent;
+    ping_one_way_protocol<HostAgent>(agent, flag, message, arrivals);
+}
 
-void host_ping_function_acqrel_base(std::atomic<uint16_t> *flag, uint64_t *time) {
-    while (flag->load() == PONG);
-    uint16_t expected = PING;
+void host_pong_one_way_function(uint32_t *flag, uint64_t *message, uint64_t *arrivals) {
+    HostAgent agent;
+    pong_one_way_protocol<HostAgent>(agent, flag, message, arrivals);
+}
 
-    uint64_t start = get_cpu_clock();
-    for (size_t i = 0; i < 10000; ++i) {
-        while (!flag->compare_exchange_strong(expected, PONG, std::memory_order_acq_rel, std::memory_order_acquire)) {
-            expected = PING;
-        }
-    }
-    uint64_t end = get_cpu_clock();
-    *time = end - start;
+void host_open_loop_consumer_function(uint64_t *head, uint64_t *done, uint64_t *requests, uint64_t *responses, size_t capacity, size_t count) {
+    HostAgent agent;
+    agent.iterations = count;
+    open_loop_consumer_protocol<HostAgent>(agent, head, done, requests, responses, capacity);
 }
 
-void host_ping_function_relaxed_decoupled(std::atomic<uint16_t> *flag, uint64_t *time) {
-    while (flag->load() == PONG);
-    uint16_t expected = PING;
+// cores the two host-side agents of a cell are pinned to (-p, a sweep's cores
+// axis, or the pair a parallel sweep worker owns)
+struct CorePair {
+    int first = 0;
+    int second = 1;
+};
 
-    uint64_t start = get_cpu_clock();
-    for (size_t i = 0; i < 10000; ++i) {
-        while (flag->load(std::memory_order_relaxed) != expected) {
-            expected = PING;
-        }
-        flag->store(PONG, std::memory_order_relaxed);
-    }
-    uint64_t end = get_cpu_clock();
-    *time = end - start;
+CorePair &core_pair() {
+    thread_local CorePair cores;
+    return cores;
 }
 
-void host_ping_function_acqrel_decoupled(std::atomic<uint16_t> *flag, uint64_t *time) {
-    while (flag->load() == PONG);
-    uint16_t expected = PING;
-
-    uint64_t start = get_cpu_clock();
-    for (size_t i = 0; i < 10000; ++i) {
-        while (flag->load(std::memory_order_acquire) != expected) {
-            expected = PING;
-        }
-        flag->store(PONG, std::memory_order_release);
-    }
-    uint64_t end = get_cpu_clock();
-    *time = end - start;
+/**
+ * Starts a host agent already on its core: the thread sets its own affinity
+ * (and, in low-jitter mode, SCHED_FIFO) before running the body, so the
+ * agent never runs anywhere else, and it reports its context switches and
+ * any migration to the spawning thread's contamination monitor
+ * (contamination.hpp).
+ * */
+template <typename F, typename... Args>
+std::thread pinned_thread(int core, F &&f, Args &&...args) {
+    ContaminationMonitor *monitor = &contamination();
+    monitor->add_agent(core);
+    int priority = agent_priority();
+
+    return std::thread([core, monitor, priority, body = std::bind(std::forward<F>(f), std::forward<Args>(args)...)]() mutable {
+        cpu_set_t cpuset;
+        CPU_ZERO(&cpuset);
+        CPU_SET(core, &cpuset);
+        pthread_setaffinity_np(pthread_self(), sizeof(cpu_set_t), &cpuset);
+        apply_agent_scheduling(core, priority);
+
+        struct rusage before;
+        getrusage(RUSAGE_THREAD, &before);
+        monitor->agent_started(core);
+        body();
+        monitor->agent_finished(core, before);
+    });
 }
 
+// whole measured loops, for measure_latency()
+double host_elapsed_ns(uint64_t cpu_time) {
+    return (double) cpu_time * host_ns_per_tick();
+}
 
-void host_pong_function_relaxed_base(std::atomic<uint16_t> *flag) {
-    uint16_t expected = PONG;
-    flag->store(PING);
-    for (size_t i = 0; i < 10000; ++i) {
-        while (!flag->compare_exchange_strong(expected, PING, std::memory_order_relaxed, std::memory_order_relaxed)) {
-            expected = PONG;
-        }
-    }
+double device_elapsed_ns(clock_t gpu_time) {
+    return (double) gpu_time / (double) get_gpu_freq() * 1000000.;
 }
 
-void host_pong_function_relaxed_decoupled(std::atomic<uint16_t> *flag) {
-    uint16_t expected = PONG;
-    flag->store(PING);
-    for (size_t i = 0; i < 10000; ++i) {
-        while (flag->load(std::memory_order_relaxed) != expected) {
-            expected = PONG;
-        }
-        // std::cout << i * 1000000. << std::endl;
-        flag->store(PING, std::memory_order_relaxed);
+const char *protocol_suffix(PingPongProtocol host, PingPongProtocol device) {
+    if (host == BASE && device == BASE) {
+        return "";
+    } else if (host == DECOUPLED && device == DECOUPLED) {
+        return ", Decoupled";
     }
+    return host == BASE ? ", CPU-CAS GPU-Decoupled" : ", CPU-Decoupled GPU-CAS";
 }
 
-
-void host_pong_function_acqrel_base(std::atomic<uint16_t> *flag) {
-    uint16_t expected = PONG;
-    flag->store(PING);
-    for (size_t i = 0; i < 10000; ++i) {
-        while (!flag->compare_exchange_strong(expected, PING, std::memory_order_acq_rel, std::memory_order_acquire)) {
-            expected = PONG;
-        }
+// the protocol parameter -f protocol=... matches against, host side first when they differ
+const char *protocol_name(PingPongProtocol host, PingPongProtocol device) {
+    if (host == device) {
+        return host == BASE ? "Base" : "Decoupled";
     }
+    return host == BASE ? "Base-Decoupled" : "Decoupled-Base";
 }
 
-void host_pong_function_acqrel_decoupled(std::atomic<uint16_t> *flag) {
-    uint16_t expected = PONG;
-    flag->store(PING);
-    for (size_t i = 0; i < 10000; ++i) {
-        while (flag->load(std::memory_order_acquire) != expected) {
-            expected = PONG;
-        }
-        // std::cout << i * 1000000. << std::endl;
-        flag->store(PING, std::memory_order_release);
-    }
-}
-
-void device_device_fetch_add(Allocator allocator) {
-    cuda::atomic<uint16_t, cuda::thread_scope_thread> *flag_thread_relaxed;
-    cuda::atomic<uint16_t, cuda::thread_scope_device> *flag_device_relaxed;
-    cuda::atomic<uint16_t, cuda::thread_scope_system> *flag_system_relaxed;
-
-    cuda::atomic<uint16_t, cuda::thread_scope_system> *sig;
-
-    if (allocator == CUDA_MALLOC_HOST) {
-        cudaMallocHost(&sig, sizeof(cuda::atomic<uint16_t, cuda::thread_scope_system>));
-    } else if (allocator == MALLOC) {
-        sig = (cuda::atomic<uint16_t, cuda::thread_scope_system> *) malloc(sizeof(cuda::atomic<uint16_t, cuda::thread_scope_system>));
-    } else if (allocator == UM) {
-        cudaMallocManaged(&sig, sizeof(cuda::atomic<uint16_t, cuda::thread_scope_system>));
-    } else if (allocator == CUDA_MALLOC) {
-        cudaMalloc(&sig, sizeof(cuda::atomic<uint16_t, cuda::thread_scope_system>));
-    }
-
-    if (allocator == CUDA_MALLOC_HOST) {
-        cudaMallocHost(&flag_thread_relaxed, sizeof(cuda::atomic<uint16_t, cuda::thread_scope_thread>));
-        cudaMallocHost(&flag_device_relaxed, sizeof(cuda::atomic<uint16_t, cuda::thread_scope_device>));
-        cudaMallocHost(&flag_system_relaxed, sizeof(cuda::atomic<uint16_t, cuda::thread_scope_system>));
-    } else if (allocator == MALLOC) {
-        flag_thread_relaxed = (cuda::atomic<uint16_t, cuda::thread_scope_thread> *) malloc(sizeof(cuda::atomic<uint16_t, cuda::thread_scope_thread>));
-        flag_device_relaxed = (cuda::atomic<uint16_t, cuda::thread_scope_device> *) malloc(sizeof(cuda::atomic<uint16_t, cuda::thread_scope_device>));
-        flag_system_relaxed = (cuda::atomic<uint16_t, cuda::thread_scope_system> *) malloc(sizeof(cuda::atomic<uint16_t, cuda::thread_scope_system>));
-    } else if (allocator == UM) {
-        cudaMallocManaged(&flag_thread_relaxed, sizeof(cuda::atomic<uint16_t, cuda::thread_scope_thread>));
-        cudaMallocManaged(&flag_device_relaxed, sizeof(cuda::atomic<uint16_t, cuda::thread_scope_device>));
-        cudaMallocManaged(&flag_system_relaxed, sizeof(cuda::atomic<uint16_t, cuda::thread_scope_system>));
-    } else if (allocator == CUDA_MALLOC) {
-        cudaMalloc(&flag_thread_relaxed, sizeof(cuda::atomic<uint16_t, cuda::thread_scope_thread>));
-        cudaMalloc(&flag_device_relaxed, sizeof(cuda::atomic<uint16_t, cuda::thread_scope_device>));
-        cudaMalloc(&flag_system_relaxed, sizeof(cuda::atomic<uint16_t, cuda::thread_scope_system>));
-    }
-
-    if (allocator == CUDA_MALLOC) {
-        // clear flag and sig
-        cudaMemset(flag_thread_relaxed, 0, sizeof(cuda::atomic<uint16_t, cuda::thread_scope_thread>));
-        cudaMemset(flag_device_relaxed, 0, sizeof(cuda::atomic<uint16_t, cuda::thread_scope_device>));
-        cudaMemset(flag_system_relaxed, 0, sizeof(cuda::atomic<uint16_t, cuda::thread_scope_system>));
-        cudaMemset(sig, 0, sizeof(cuda::atomic<uint16_t, cuda::thread_scope_system>));
-    } else {
-        sig->store(PONG);
-    }
+template <cuda::thread_scope Scope, MemOrder Order>
+void device_device_fetch_add_cell(Arena &arena) {
+    std::string experiment = std::string("Device-Fetch-Add Device-Fetch-Add (") + scope_name(Scope) + ", " + order_name(Order) + ")";
+    if (!select_cell(experiment, {scope_name(Scope), order_name(Order), "Fetch-Add"})) return;
 
-    clock_t *gpu_time_system_relaxed_store;
-    clock_t *gpu_time_system_relaxed_wait;
+    cudaStream_t stream_store;
+    cudaStream_t stream_wait;
 
-    if (allocator == CUDA_MALLOC_HOST) {
-        cudaMallocHost(&gpu_time_system_relaxed_store, sizeof(clock_t));
-        cudaMallocHost(&gpu_time_system_relaxed_wait, sizeof(clock_t));
-    } else if (allocator == MALLOC) {
-        gpu_time_system_relaxed_store = (clock_t *) malloc(sizeof(clock_t));
-        gpu_time_system_relaxed_wait = (clock_t *) malloc(sizeof(clock_t));
-    } else if (allocator == UM) {
-        cudaMallocManaged(&gpu_time_system_relaxed_store, sizeof(clock_t));
-        cudaMallocManaged(&gpu_time_system_relaxed_wait, sizeof(clock_t));
-    } else if (allocator == CUDA_MALLOC) {
-        cudaMalloc(&gpu_time_system_relaxed_store, sizeof(clock_t));
-        cudaMalloc(&gpu_time_system_relaxed_wait, sizeof(clock_t));
-    }
+    cudaStreamCreate(&stream_store);
+    cudaStreamCreate(&stream_wait);
 
-    cudaStream_t stream_system_relaxed_store;
-    cudaStream_t stream_system_relaxed_wait;
+    // both agents are timed; measure_latency follows the store side, the wait side rides along
+    uint32_t *flag;
+    size_t size = 0;
+    std::vector<double> wait_batches;
+    Measurement store = measure_latency([&](size_t iterations) {
+        arena.reset();
+        flag = arena.slot<uint32_t>();
+        uint32_t *sig = arena.slot<uint32_t>();
+        clock_t *gpu_time_store = arena.slot<clock_t>();
+        clock_t *gpu_time_wait = arena.slot<clock_t>();
 
-    cudaStreamCreate(&stream_system_relaxed_store);
-    cudaStreamCreate(&stream_system_relaxed_wait);
+        device_fetch_add_kernel<Scope, Order, START_HANDSHAKE><<<1,1,0, stream_store>>>(flag, sig, gpu_time_store, iterations);
+        device_fetch_add_kernel<Scope, Order, START_HANDSHAKE><<<1,1,0, stream_wait>>>(flag, sig, gpu_time_wait, iterations);
 
-    device_fetch_add_relaxed<<<1,1,0, stream_system_relaxed_store>>>(flag_system_relaxed, sig, gpu_time_system_relaxed_store);
-    device_fetch_add_relaxed<<<1,1,0, stream_system_relaxed_wait>>>(flag_system_relaxed, sig, gpu_time_system_relaxed_wait);
+        cudaStreamSynchronize(stream_store);
+        cudaStreamSynchronize(stream_wait);
 
-    cudaStreamSynchronize(stream_system_relaxed_store);
-    cudaStreamSynchronize(stream_system_relaxed_wait);
+        cudaDeviceSynchronize();
 
-    cudaDeviceSynchronize();
+        size = iterations;
+        wait_batches.push_back(device_elapsed_ns(arena.read(gpu_time_wait)));
+        return device_elapsed_ns(arena.read(gpu_time_store));
+    }, device_clock_calibration<false>());
+    Measurement wait = companion_measurement(wait_batches, store, size, device_clock_calibration<false>());
 
-    if (allocator == CUDA_MALLOC) {
-        int flag;
-        clock_t gpu_clock_store;
-        clock_t gpu_clock_wait;
+    report_latencies(experiment, {{"Store", store, &device_clock_calibration<false>()}, {"Wait", wait, &device_clock_calibration<false>()}}, {{"Value", (double) arena.read(flag), DESCRIPTIVE}});
 
-        cudaMemcpy(&flag, flag_system_relaxed, sizeof(int), cudaMemcpyDeviceToHost);
-        cudaMemcpy(&gpu_clock_store, gpu_time_system_relaxed_store, sizeof(clock_t), cudaMemcpyDeviceToHost);
-        cudaMemcpy(&gpu_clock_wait, gpu_time_system_relaxed_wait, sizeof(clock_t), cudaMemcpyDeviceToHost);
+    cudaStreamDestroy(stream_store);
+    cudaStreamDestroy(stream_wait);
+}
 
-        std::cout << "Device-Fetch-Add Device-Fetch-Add (System, Relaxed) | Value : " << flag << " | Store : " << ((double) gpu_clock_store / 10000) / ((double) get_gpu_freq()) * 1000000. << " | Wait : " << ((double) gpu_clock_wait / 10000) / ((double) get_gpu_freq()) * 1000000. << std::endl;
-    } else {
-        std::cout << "Device-Fetch-Add Device-Fetch-Add (System, Relaxed) | Value:  " << *flag_system_relaxed << " | Store : " << ((double) (*gpu_time_system_relaxed_store / 10000)) / ((double) get_gpu_freq()) * 1000000. << " | Wait : " << ((double) (*gpu_time_system_relaxed_wait / 10000)) / ((double) get_gpu_freq()) * 1000000. << std::endl;
-    }
+template <cuda::thread_scope Scope, MemOrder Order>
+void host_device_fetch_add_cell(Arena &arena) {
+    std::string experiment = std::string("Host-Fetch-Add Device-Fetch-Add (") + scope_name(Scope) + ", " + order_name(Order) + ")";
+    if (!select_cell(experiment, {scope_name(Scope), order_name(Order), "Fetch-Add"})) return;
 
-    cudaStreamDestroy(stream_system_relaxed_store);
-    cudaStreamDestroy(stream_system_relaxed_wait);
+    // measure_latency follows the host side, the device side rides along
+    uint32_t *flag;
+    size_t size = 0;
+    std::vector<double> device_batches;
+    Measurement host = measure_latency([&](size_t iterations) {
+        arena.reset();
+        flag = arena.slot<uint32_t>();
+        uint32_t *sig = arena.slot<uint32_t>();
+        clock_t *gpu_time = arena.slot<clock_t>();
 
-    if (allocator == CUDA_MALLOC) {
-        cudaMemset(sig, 0, sizeof(cuda::atomic<uint16_t, cuda::thread_scope_system>));
-    } else {
-        sig->store(PONG);
-    }
-    
-    clock_t *gpu_time_device_relaxed_store;
-    clock_t *gpu_time_device_relaxed_wait;
-    
-    if (allocator == CUDA_MALLOC_HOST) {
-        cudaMallocHost(&gpu_time_device_relaxed_store, sizeof(clock_t));
-        cudaMallocHost(&gpu_time_device_relaxed_wait, sizeof(clock_t));
-    } else if (allocator == MALLOC) {
-        gpu_time_device_relaxed_store = (clock_t *) malloc(sizeof(clock_t));
-        gpu_time_device_relaxed_wait = (clock_t *) malloc(sizeof(clock_t));
-    } else if (allocator == UM) {
-        cudaMallocManaged(&gpu_time_device_relaxed_store, sizeof(clock_t));
-        cudaMallocManaged(&gpu_time_device_relaxed_wait, sizeof(clock_t));
-    } else if (allocator == CUDA_MALLOC) {
-        cudaMalloc(&gpu_time_device_relaxed_store, sizeof(clock_t));
-        cudaMalloc(&gpu_time_device_relaxed_wait, sizeof(clock_t));
-    }
-
-    cudaStream_t stream_device_relaxed_store;
-    cudaStream_t stream_device_relaxed_wait;
-    
-    cudaStreamCreate(&stream_device_relaxed_store);
-    cudaStreamCreate(&stream_device_relaxed_wait);
-
-    device_fetch_add_relaxed<<<1,1,0, stream_device_relaxed_store>>>(flag_device_relaxed, sig, gpu_time_device_relaxed_store);
-    device_fetch_add_relaxed<<<1,1,0, stream_device_relaxed_wait>>>(flag_device_relaxed, sig, gpu_time_device_relaxed_wait);
-    
-    cudaStreamSynchronize(stream_device_relaxed_store);
-    cudaStreamSynchronize(stream_device_relaxed_wait);
-    
-    cudaDeviceSynchronize();
-    
-    if (allocator == CUDA_MALLOC) {
-        int flag;
-        clock_t gpu_clock_store;
-        clock_t gpu_clock_wait;
-        
-        cudaMemcpy(&flag, flag_device_relaxed, sizeof(int), cudaMemcpyDeviceToHost);
-        cudaMemcpy(&gpu_clock_store, gpu_time_device_relaxed_store, sizeof(clock_t), cudaMemcpyDeviceToHost);
-        cudaMemcpy(&gpu_clock_wait, gpu_time_device_relaxed_wait, sizeof(clock_t), cudaMemcpyDeviceToHost);
-        
-        std::cout << "Device-Fetch-Add Device-Fetch-Add (Device, Relaxed) | Value : " << flag << " | Store : " << ((double) gpu_clock_store / 10000) / ((double) get_gpu_freq()) * 1000000. << " | Wait : " << ((double) gpu_clock_wait / 10000) / ((double) get_gpu_freq()) * 1000000. << std::endl;
-    } else {
-        std::cout << "Device-Fetch-Add Device-Fetch-Add (Device, Relaxed) | Value : " << *flag_device_relaxed << " | Store : " << ((double) (*gpu_time_device_relaxed_store / 10000)) / ((double) get_gpu_freq()) * 1000000. << " | Wait : " << ((double) (*gpu_time_device_relaxed_wait / 10000)) / ((double) get_gpu_freq()) * 1000000. << std::endl;
-    }
-    
-    cudaStreamDestroy(stream_device_relaxed_store);
-    cudaStreamDestroy(stream_device_relaxed_wait);
+        uint64_t cpu_time;
+        std::thread t = pinned_thread(core_pair().first, host_fetch_add_function<Order>, flag, sig, &cpu_time, iterations);
 
-    if (allocator == CUDA_MALLOC) {
-        cudaMemset(sig, 0, sizeof(cuda::atomic<uint16_t, cuda::thread_scope_system>));
-    } else {
-        sig->store(PONG);
-    }
-    
-    clock_t *gpu_time_thread_relaxed_store;
-    clock_t *gpu_time_thread_relaxed_wait;
-    
-    if (allocator == CUDA_MALLOC_HOST) {
-        cudaMallocHost(&gpu_time_thread_relaxed_store, sizeof(clock_t));
-        cudaMallocHost(&gpu_time_thread_relaxed_wait, sizeof(clock_t));
-    } else if (allocator == MALLOC) {
-        gpu_time_thread_relaxed_store = (clock_t *) malloc(sizeof(clock_t));
-        gpu_time_thread_relaxed_wait = (clock_t *) malloc(sizeof(clock_t));
-    } else if (allocator == UM) {
-        cudaMallocManaged(&gpu_time_thread_relaxed_store, sizeof(clock_t));
-        cudaMallocManaged(&gpu_time_thread_relaxed_wait, sizeof(clock_t));
-    } else if (allocator == CUDA_MALLOC) {
-        cudaMalloc(&gpu_time_thread_relaxed_store, sizeof(clock_t));
-        cudaMalloc(&gpu_time_thread_relaxed_wait, sizeof(clock_t));
-    }
-
-    cudaStream_t stream_thread_relaxed_store;
-    cudaStream_t stream_thread_relaxed_wait;
-    
-    cudaStreamCreate(&stream_thread_relaxed_store);
-    cudaStreamCreate(&stream_thread_relaxed_wait);
-    
-    device_fetch_add_relaxed<<<1,1,0, stream_thread_relaxed_store>>>(flag_thread_relaxed, sig, gpu_time_thread_relaxed_store);
-    device_fetch_add_relaxed<<<1,1,0, stream_thread_relaxed_wait>>>(flag_thread_relaxed, sig, gpu_time_thread_relaxed_wait);
-    
-    cudaStreamSynchronize(stream_thread_relaxed_store);
-    cudaStreamSynchronize(stream_thread_relaxed_wait);
-    
-    cudaDeviceSynchronize();
-    
-    if (allocator == CUDA_MALLOC) {
-        int flag;
-        clock_t gpu_clock_store;
-        clock_t gpu_clock_wait;
-        
-        cudaMemcpy(&flag, flag_thread_relaxed, sizeof(int), cudaMemcpyDeviceToHost);
-        cudaMemcpy(&gpu_clock_store, gpu_time_thread_relaxed_store, sizeof(clock_t), cudaMemcpyDeviceToHost);
-        cudaMemcpy(&gpu_clock_wait, gpu_time_thread_relaxed_wait, sizeof(clock_t), cudaMemcpyDeviceToHost);
-        
-        std::cout << "Device-Fetch-Add Device-Fetch-Add (Thread, Relaxed) | Value : " << flag << " | Store : " << ((double) gpu_clock_store / 10000) / ((double) get_gpu_freq()) * 1000000. << " | Wait : " << ((double) gpu_clock_wait / 10000) / ((double) get_gpu_freq()) * 1000000. << std::endl;
-    } else {
-        std::cout << "Device-Fetch-Add Device-Fetch-Add (Thread, Relaxed) | Value : " << *flag_thread_relaxed << " | Store : " << ((double) (*gpu_time_thread_relaxed_store / 10000)) / ((double) get_gpu_freq()) * 1000000. << " | Wait : " << ((double) (*gpu_time_thread_relaxed_wait / 10000)) / ((double) get_gpu_freq()) * 1000000. << std::endl;
-    }
-    
-    cuda::atomic<uint16_t, cuda::thread_scope_thread> *flag_thread_acqrel;
-    cuda::atomic<uint16_t, cuda::thread_scope_device> *flag_device_acqrel;
-    cuda::atomic<uint16_t, cuda::thread_scope_system> *flag_system_acqrel;
-    
-    if (allocator == CUDA_MALLOC_HOST) {
-        cudaMallocHost(&flag_thread_acqrel, sizeof(cuda::atomic<uint16_t, cuda::thread_scope_thread>));
-        cudaMallocHost(&flag_device_acqrel, sizeof(cuda::atomic<uint16_t, cuda::thread_scope_device>));
-        cudaMallocHost(&flag_system_acqrel, sizeof(cuda::atomic<uint16_t, cuda::thread_scope_system>));
-    } else if (allocator == MALLOC) {
-        flag_thread_acqrel = (cuda::atomic<uint16_t, cuda::thread_scope_thread> *) malloc(sizeof(cuda::atomic<uint16_t, cuda::thread_scope_thread>));
-        flag_device_acqrel = (cuda::atomic<uint16_t, cuda::thread_scope_device> *) malloc(sizeof(cuda::atomic<uint16_t, cuda::thread_scope_device>));
-        flag_system_acqrel = (cuda::atomic<uint16_t, cuda::thread_scope_system> *) malloc(sizeof(cuda::atomic<uint16_t, cuda::thread_scope_system>));
-    } else if (allocator == UM) {
-        cudaMallocManaged(&flag_system_acqrel, sizeof(cuda::atomic<uint16_t, cuda::thread_scope_system>));
-        cudaMallocManaged(&flag_device_acqrel, sizeof(cuda::atomic<uint16_t, cuda::thread_scope_device>));
-        cudaMallocManaged(&flag_thread_acqrel, sizeof(cuda::atomic<uint16_t, cuda::thread_scope_thread>));
-    } else if (allocator == CUDA_MALLOC) {
-        cudaMalloc(&flag_thread_acqrel, sizeof(cuda::atomic<uint16_t, cuda::thread_scope_thread>));
-        cudaMalloc(&flag_device_acqrel, sizeof(cuda::atomic<uint16_t, cuda::thread_scope_device>));
-        cudaMalloc(&flag_system_acqrel, sizeof(cuda::atomic<uint16_t, cuda::thread_scope_system>));
-    }
-
-    if (allocator == CUDA_MALLOC) {
-        // clear flag and sig
-        cudaMemset(flag_thread_acqrel, 0, sizeof(cuda::atomic<uint16_t, cuda::thread_scope_thread>));
-        cudaMemset(flag_device_acqrel, 0, sizeof(cuda::atomic<uint16_t, cuda::thread_scope_device>));
-        cudaMemset(flag_system_acqrel, 0, sizeof(cuda::atomic<uint16_t, cuda::thread_scope_system>));
-        cudaMemset(sig, 0, sizeof(cuda::atomic<uint16_t, cuda::thread_scope_system>));
-    } else {
-        sig->store(PONG);
-    }
-
-    clock_t *gpu_time_system_acqrel_store;
-    clock_t *gpu_time_system_acqrel_wait;
-    
-    if (allocator == CUDA_MALLOC_HOST) {
-        cudaMallocHost(&gpu_time_system_acqrel_store, sizeof(clock_t));
-        cudaMallocHost(&gpu_time_system_acqrel_wait, sizeof(clock_t));
-    } else if (allocator == MALLOC) {
-        gpu_time_system_acqrel_store = (clock_t *) malloc(sizeof(clock_t));
-        gpu_time_system_acqrel_wait = (clock_t *) malloc(sizeof(clock_t));
-    } else if (allocator == UM) {
-        cudaMallocManaged(&gpu_time_system_acqrel_store, sizeof(clock_t));
-        cudaMallocManaged(&gpu_time_system_acqrel_wait, sizeof(clock_t));
-    } else if (allocator == CUDA_MALLOC) {
-        cudaMalloc(&gpu_time_system_acqrel_store, sizeof(clock_t));
-        cudaMalloc(&gpu_time_system_acqrel_wait, sizeof(clock_t));
-    }
-
-    cudaStream_t stream_system_acqrel_store;
-    cudaStream_t stream_system_acqrel_wait;
-    
-    cudaStreamCreate(&stream_system_acqrel_store);
-    cudaStreamCreate(&stream_system_acqrel_wait);
-    
-    device_fetch_add_acqrel<<<1,1,0, stream_system_acqrel_store>>>(flag_system_acqrel, sig, gpu_time_system_acqrel_store);
-    device_fetch_add_acqrel<<<1,1,0, stream_system_acqrel_wait>>>(flag_system_acqrel, sig, gpu_time_system_acqrel_wait);
-    
-    cudaStreamSynchronize(stream_system_acqrel_store);
-    cudaStreamSynchronize(stream_system_acqrel_wait);
+        device_fetch_add_kernel<Scope, Order, START_HANDSHAKE><<<1,1>>>(flag, sig, gpu_time, iterations);
 
-    cudaDeviceSynchronize();
-    
-    if (allocator == CUDA_MALLOC) {
-        int flag;
-        clock_t gpu_clock_store;
-        clock_t gpu_clock_wait;
+        cudaDeviceSynchronize();
+        t.join();
 
-        cudaMemcpy(&flag, flag_system_acqrel, sizeof(int), cudaMemcpyDeviceToHost);
-        cudaMemcpy(&gpu_clock_store, gpu_time_system_acqrel_store, sizeof(clock_t), cudaMemcpyDeviceToHost);
-        cudaMemcpy(&gpu_clock_wait, gpu_time_system_acqrel_wait, sizeof(clock_t), cudaMemcpyDeviceToHost);
+        size = iterations;
+        device_batches.push_back(device_elapsed_ns(arena.read(gpu_time)));
+        return host_elapsed_ns(cpu_time);
+    }, host_clock_calibration());
+    Measurement device = companion_measurement(device_batches, host, size, device_clock_calibration<false>());
 
-        std::cout << "Device-Fetch-Add Device-Fetch-Add (System, Acq-Rel) | Value : " << flag << " | Store : " << ((double) gpu_clock_store / 10000) / ((double) get_gpu_freq()) * 1000000. << " | Wait : " << ((double) gpu_clock_wait / 10000) / ((double) get_gpu_freq()) * 1000000. << std::endl;
-    } else {
-        std::cout << "Device-Fetch-Add Device-Fetch-Add (System, Acq-Rel) | Value : " << *flag_system_acqrel << " | Store : " << ((double) (*gpu_time_system_acqrel_store / 10000)) / ((double) get_gpu_freq()) * 1000000. << " | Wait : " << ((double) (*gpu_time_system_acqrel_wait / 10000)) / ((double) get_gpu_freq()) * 1000000. << std::endl;
-    }
+    report_latencies(experiment, {{"Host", host, &host_clock_calibration()}, {"Device", device, &device_clock_calibration<false>()}}, {{"Value", (double) arena.read(flag), DESCRIPTIVE}});
+}
 
-    cudaStreamDestroy(stream_system_acqrel_store);
-    cudaStreamDestroy(stream_system_acqrel_wait);
+template <cuda::thread_scope Scope, MemOrder Order, PingPongProtocol HostProtocol, PingPongProtocol DeviceProtocol>
+void host_ping_device_pong_cell(Arena &arena) {
+    std::string experiment = std::string("Host-PING Device-PONG (") + scope_name(Scope) + ", " + order_name(Order) + protocol_suffix(HostProtocol, DeviceProtocol) + ")";
+    if (!select_cell(experiment, {scope_name(Scope), order_name(Order), protocol_name(HostProtocol, DeviceProtocol)})) return;
 
-    if (allocator == CUDA_MALLOC) {
-        cudaMemset(sig, 0, sizeof(cuda::atomic<uint16_t, cuda::thread_scope_system>));
-    } else {
-        sig->store(PONG);
-    }
-    
-    clock_t *gpu_time_device_acqrel_store;
-    clock_t *gpu_time_device_acqrel_wait;
-
-    if (allocator == CUDA_MALLOC_HOST) {
-        cudaMallocHost(&gpu_time_device_acqrel_store, sizeof(clock_t));
-        cudaMallocHost(&gpu_time_device_acqrel_wait, sizeof(clock_t));
-    } else if (allocator == MALLOC) {
-        gpu_time_device_acqrel_store = (clock_t *) malloc(sizeof(clock_t));
-        gpu_time_device_acqrel_wait = (clock_t *) malloc(sizeof(clock_t));
-    } else if (allocator == UM) {
-        cudaMallocManaged(&gpu_time_device_acqrel_store, sizeof(clock_t));
-        cudaMallocManaged(&gpu_time_device_acqrel_wait, sizeof(clock_t));
-    } else if (allocator == CUDA_MALLOC) {
-        cudaMalloc(&gpu_time_device_acqrel_store, sizeof(clock_t));
-        cudaMalloc(&gpu_time_device_acqrel_wait, sizeof(clock_t));
-    }
-
-    cudaStream_t stream_device_acqrel_store;
-    cudaStream_t stream_device_acqrel_wait;
-    
-    cudaStreamCreate(&stream_device_acqrel_store);
-    cudaStreamCreate(&stream_device_acqrel_wait);
-    
-    device_fetch_add_acqrel<<<1,1,0, stream_device_acqrel_store>>>(flag_device_acqrel, sig, gpu_time_device_acqrel_store);
-    device_fetch_add_acqrel<<<1,1,0, stream_device_acqrel_wait>>>(flag_device_acqrel, sig, gpu_time_device_acqrel_wait);
-    
-    cudaStreamSynchronize(stream_device_acqrel_store);
-    cudaStreamSynchronize(stream_device_acqrel_wait);
-    
-    cudaDeviceSynchronize();
-    
-    if (allocator == CUDA_MALLOC) {
-        int flag;
-        clock_t gpu_clock_store;
-        clock_t gpu_clock_wait;
-        
-        cudaMemcpy(&flag, flag_device_acqrel, sizeof(int), cudaMemcpyDeviceToHost);
-        cudaMemcpy(&gpu_clock_store, gpu_time_device_acqrel_store, sizeof(clock_t), cudaMemcpyDeviceToHost);
-        cudaMemcpy(&gpu_clock_wait, gpu_time_device_acqrel_wait, sizeof(clock_t), cudaMemcpyDeviceToHost);
-
-        std::cout << "Device-Fetch-Add Device-Fetch-Add (Device, Acq-Rel) | Value : " << flag << " | Store : " << ((double) gpu_clock_store / 10000) / ((double) get_gpu_freq()) * 1000000. << " | Wait : " << ((double) gpu_clock_wait / 10000) / ((double) get_gpu_freq()) * 1000000. << std::endl;
-    } else {
-        std::cout << "Device-Fetch-Add Device-Fetch-Add (Device, Acq-Rel) | Value : " << *flag_device_acqrel << " | Store : " << ((double) (*gpu_time_device_acqrel_store / 10000)) / ((double) get_gpu_freq()) * 1000000. << " | Wait : " << ((double) (*gpu_time_device_acqrel_wait / 10000)) / ((double) get_gpu_freq()) * 1000000. << std::endl;
-    }
-    
-    cudaStreamDestroy(stream_device_acqrel_store);
-    cudaStreamDestroy(stream_device_acqrel_wait);
+    // every batch starts from a freshly zeroed flag at the same address
+    uint64_t *ping_trace, *pong_trace;
+    Measurement measurement = measure_latency([&](size_t iterations) {
+        arena.reset();
+        uint32_t *flag = arena.slot<uint32_t>();
+        ping_trace = trace_slot(arena);
+        pong_trace = trace_slot(arena);
 
-    if (allocator == CUDA_MALLOC) {
-        cudaMemset(sig, 0, sizeof(cuda::atomic<uint16_t, cuda::thread_scope_system>));
-    } else {
-        sig->store(PONG);
-    }
-    
-    clock_t *gpu_time_thread_acqrel_store;
-    clock_t *gpu_time_thread_acqrel_wait;
-    
-    if (allocator == CUDA_MALLOC_HOST) {
-        cudaMallocHost(&gpu_time_thread_acqrel_store, sizeof(clock_t));
-        cudaMallocHost(&gpu_time_thread_acqrel_wait, sizeof(clock_t));
-    } else if (allocator == MALLOC) {
-        gpu_time_thread_acqrel_store = (clock_t *) malloc(sizeof(clock_t));
-        gpu_time_thread_acqrel_wait = (clock_t *) malloc(sizeof(clock_t));
-    } else if (allocator == UM) {
-        cudaMallocManaged(&gpu_time_thread_acqrel_store, sizeof(clock_t));
-        cudaMallocManaged(&gpu_time_thread_acqrel_wait, sizeof(clock_t));
-    } else if (allocator == CUDA_MALLOC) {
-        cudaMalloc(&gpu_time_thread_acqrel_store, sizeof(clock_t));
-        cudaMalloc(&gpu_time_thread_acqrel_wait, sizeof(clock_t));
-    }
-
-    cudaStream_t stream_thread_acqrel_store;
-    cudaStream_t stream_thread_acqrel_wait;
-    
-    
-    cudaStreamCreate(&stream_thread_acqrel_store);
-    cudaStreamCreate(&stream_thread_acqrel_wait);
-
-    device_fetch_add_acqrel<<<1,1,0, stream_thread_acqrel_store>>>(flag_thread_acqrel, sig, gpu_time_thread_acqrel_store);
-    device_fetch_add_acqrel<<<1,1,0, stream_thread_acqrel_wait>>>(flag_thread_acqrel, sig, gpu_time_thread_acqrel_wait);
-
-    cudaStreamSynchronize(stream_thread_acqrel_store);
-    cudaStreamSynchronize(stream_thread_acqrel_wait);
+        uint64_t cpu_time;
+        std::thread t = pinned_thread(core_pair().first, host_ping_function<Order, HostProtocol>, flag, &cpu_time, ping_trace, iterations);
+        device_pong_kernel<Scope, Order, DeviceProtocol><<<1,1>>>(flag, pong_trace, iterations);
+        t.join();
+        cudaDeviceSynchronize();
+        return host_elapsed_ns(cpu_time);
+    }, host_clock_calibration());
 
-    cudaDeviceSynchronize();
-    
-    if (allocator == CUDA_MALLOC) {
-        int flag;
-        clock_t gpu_clock_store;
-        clock_t gpu_clock_wait;
-        
-        cudaMemcpy(&flag, flag_thread_acqrel, sizeof(int), cudaMemcpyDeviceToHost);
-        cudaMemcpy(&gpu_clock_store, gpu_time_thread_acqrel_store, sizeof(clock_t), cudaMemcpyDeviceToHost);
-        cudaMemcpy(&gpu_clock_wait, gpu_time_thread_acqrel_wait, sizeof(clock_t), cudaMemcpyDeviceToHost);
-        
-        std::cout << "Device-Fetch-Add Device-Fetch-Add (Thread, Acq-Rel) | Value : " << flag << " | Store : " << ((double) gpu_clock_store / 10000) / ((double) get_gpu_freq()) * 1000000. << " | Wait : " << ((double) gpu_clock_wait / 10000) / ((double) get_gpu_freq()) * 1000000. << std::endl;
-    } else {
-        std::cout << "Device-Fetch-Add Device-Fetch-Add (Thread, Acq-Rel) | Value : " << *flag_thread_acqrel << " | Store : " << ((double) (*gpu_time_thread_acqrel_store / 10000)) / ((double) get_gpu_freq()) * 1000000. << " | Wait : " << ((double) (*gpu_time_thread_acqrel_wait / 10000)) / ((double) get_gpu_freq()) * 1000000. << std::endl;
-    }
-    
-    cuda::atomic<uint16_t, cuda::thread_scope_thread> *flag_thread_seqcst;
-    cuda::atomic<uint16_t, cuda::thread_scope_device> *flag_device_seqcst;
-    cuda::atomic<uint16_t, cuda::thread_scope_system> *flag_system_seqcst;
-
-    if (allocator == CUDA_MALLOC_HOST) {
-        cudaMallocHost(&flag_thread_seqcst, sizeof(cuda::atomic<uint16_t, cuda::thread_scope_thread>));
-        cudaMallocHost(&flag_device_seqcst, sizeof(cuda::atomic<uint16_t, cuda::thread_scope_device>));
-        cudaMallocHost(&flag_system_seqcst, sizeof(cuda::atomic<uint16_t, cuda::thread_scope_system>));
-    } else if (allocator == MALLOC) {
-        flag_thread_seqcst = (cuda::atomic<uint16_t, cuda::thread_scope_thread> *) malloc(sizeof(cuda::atomic<uint16_t, cuda::thread_scope_thread>));
-        flag_device_seqcst = (cuda::atomic<uint16_t, cuda::thread_scope_device> *) malloc(sizeof(cuda::atomic<uint16_t, cuda::thread_scope_device>));
-        flag_system_seqcst = (cuda::atomic<uint16_t, cuda::thread_scope_system> *) malloc(sizeof(cuda::atomic<uint16_t, cuda::thread_scope_system>));
-    } else if (allocator == UM) {
-        cudaMallocManaged(&flag_thread_seqcst, sizeof(cuda::atomic<uint16_t, cuda::thread_scope_thread>));
-        cudaMallocManaged(&flag_device_seqcst, sizeof(cuda::atomic<uint16_t, cuda::thread_scope_device>));
-        cudaMallocManaged(&flag_system_seqcst, sizeof(cuda::atomic<uint16_t, cuda::thread_scope_system>));
-    } else if (allocator == CUDA_MALLOC) {
-        cudaMalloc(&flag_thread_seqcst, sizeof(cuda::atomic<uint16_t, cuda::thread_scope_thread>));
-        cudaMalloc(&flag_device_seqcst, sizeof(cuda::atomic<uint16_t, cuda::thread_scope_device>));
-        cudaMalloc(&flag_system_seqcst, sizeof(cuda::atomic<uint16_t, cuda::thread_scope_system>));
-    }
-
-    if (allocator == CUDA_MALLOC) {
-        // clear flag and sig
-        cudaMemset(flag_thread_seqcst, 0, sizeof(cuda::atomic<uint16_t, cuda::thread_scope_thread>));
-        cudaMemset(flag_device_seqcst, 0, sizeof(cuda::atomic<uint16_t, cuda::thread_scope_device>));
-        cudaMemset(flag_system_seqcst, 0, sizeof(cuda::atomic<uint16_t, cuda::thread_scope_system>));
-        cudaMemset(sig, 0, sizeof(cuda::atomic<uint16_t, cuda::thread_scope_system>));
-    } else {
-        sig->store(PONG);
-    }
-    
-    clock_t *gpu_time_system_seqcst_store;
-    clock_t *gpu_time_system_seqcst_wait;
-    
-    if (allocator == CUDA_MALLOC_HOST) {
-        cudaMallocHost(&gpu_time_system_seqcst_store, sizeof(clock_t));
-        cudaMallocHost(&gpu_time_system_seqcst_wait, sizeof(clock_t));
-    } else if (allocator == MALLOC) {
-        gpu_time_system_seqcst_store = (clock_t *) malloc(sizeof(clock_t));
-        gpu_time_system_seqcst_wait = (clock_t *) malloc(sizeof(clock_t));
-    } else if (allocator == UM) {
-        cudaMallocManaged(&gpu_time_system_seqcst_store, sizeof(clock_t));
-        cudaMallocManaged(&gpu_time_system_seqcst_wait, sizeof(clock_t));
-    } else if (allocator == CUDA_MALLOC) {
-        cudaMalloc(&gpu_time_system_seqcst_store, sizeof(clock_t));
-        cudaMalloc(&gpu_time_system_seqcst_wait, sizeof(clock_t));
-    }
-    
-    cudaStream_t stream_system_seqcst_store;
-    cudaStream_t stream_system_seqcst_wait;
-    
-    cudaStreamCreate(&stream_system_seqcst_store);
-    cudaStreamCreate(&stream_system_seqcst_wait);
-
-    device_fetch_add_seqcst<<<1,1,0, stream_system_seqcst_store>>>(flag_system_seqcst, sig, gpu_time_system_seqcst_store);
-    device_fetch_add_seqcst<<<1,1,0, stream_system_seqcst_wait>>>(flag_system_seqcst, sig, gpu_time_system_seqcst_wait);
-    
-    cudaStreamSynchronize(stream_system_seqcst_store);
-    cudaStreamSynchronize(stream_system_seqcst_wait);
-    
-    cudaDeviceSynchronize();
+    report_latency(experiment, "Host", measurement, host_clock_calibration());
 
-    if (allocator == CUDA_MALLOC) {
-        int flag;
-        clock_t gpu_clock_store;
-        clock_t gpu_clock_wait;
-        
-        cudaMemcpy(&flag, flag_system_seqcst, sizeof(int), cudaMemcpyDeviceToHost);
-        cudaMemcpy(&gpu_clock_store, gpu_time_system_seqcst_store, sizeof(clock_t), cudaMemcpyDeviceToHost);
-        cudaMemcpy(&gpu_clock_wait, gpu_time_system_seqcst_wait, sizeof(clock_t), cudaMemcpyDeviceToHost);
-        
-        std::cout << "Device-Fetch-Add Device-Fetch-Add (System, Seq-Cst) | Value : " << flag << " | Store : " << ((double) gpu_clock_store / 10000) / ((double) get_gpu_freq()) * 1000000. << " | Wait : " << ((double) gpu_clock_wait / 10000) / ((double) get_gpu_freq()) * 1000000. << std::endl;
-    } else {
-        std::cout << "Device-Fetch-Add Device-Fetch-Add (System, Seq-Cst) | Value : " << *flag_system_seqcst << " | Store : " << ((double) (*gpu_time_system_seqcst_store / 10000)) / ((double) get_gpu_freq()) * 1000000. << " | Wait : " << ((double) (*gpu_time_system_seqcst_wait / 10000)) / ((double) get_gpu_freq()) * 1000000. << std::endl;
+    if (ping_trace != nullptr) {
+        export_trace(experiment, read_trace(arena, ping_trace, "Host-PING", host_ns_per_tick()), read_trace(arena, pong_trace, "Device-PONG", device_ns_per_tick()));
     }
-    
-    cudaStreamDestroy(stream_system_seqcst_store);
-    cudaStreamDestroy(stream_system_seqcst_wait);
+}
 
-    if (allocator == CUDA_MALLOC) {
-        cudaMemset(sig, 0, sizeof(cuda::atomic<uint16_t, cuda::thread_scope_system>));
-    } else {
-        sig->store(PONG);
-    }
-    
-    clock_t *gpu_time_device_seqcst_store;
-    clock_t *gpu_time_device_seqcst_wait;
-    
-    if (allocator == CUDA_MALLOC_HOST) {
-        cudaMallocHost(&gpu_time_device_seqcst_store, sizeof(clock_t));
-        cudaMallocHost(&gpu_time_device_seqcst_wait, sizeof(clock_t));
-    } else if (allocator == MALLOC) {
-        gpu_time_device_seqcst_store = (clock_t *) malloc(sizeof(clock_t));
-        gpu_time_device_seqcst_wait = (clock_t *) malloc(sizeof(clock_t));
-    } else if (allocator == UM) {
-        cudaMallocManaged(&gpu_time_device_seqcst_store, sizeof(clock_t));
-        cudaMallocManaged(&gpu_time_device_seqcst_wait, sizeof(clock_t));
-    } else if (allocator == CUDA_MALLOC) {
-        cudaMalloc(&gpu_time_device_seqcst_store, sizeof(clock_t));
-        cudaMalloc(&gpu_time_device_seqcst_wait, sizeof(clock_t));
-    }
-    
-    cudaStream_t stream_device_seqcst_store;
-    cudaStream_t stream_device_seqcst_wait;
-    
-    cudaStreamCreate(&stream_device_seqcst_store);
-    cudaStreamCreate(&stream_device_seqcst_wait);
-    
-    device_fetch_add_seqcst<<<1,1,0, stream_device_seqcst_store>>>(flag_device_seqcst, sig, gpu_time_device_seqcst_store);
-    device_fetch_add_seqcst<<<1,1,0, stream_device_seqcst_wait>>>(flag_device_seqcst, sig, gpu_time_device_seqcst_wait);
-    
-    cudaStreamSynchronize(stream_device_seqcst_store);
-    cudaStreamSynchronize(stream_device_seqcst_wait);
-    
-    cudaDeviceSynchronize();
-    
-    if (allocator == CUDA_MALLOC) {
-        int flag;
-        clock_t gpu_clock_store;
-        clock_t gpu_clock_wait;
-        
-        cudaMemcpy(&flag, flag_device_seqcst, sizeof(int), cudaMemcpyDeviceToHost);
-        cudaMemcpy(&gpu_clock_store, gpu_time_device_seqcst_store, sizeof(clock_t), cudaMemcpyDeviceToHost);
-        cudaMemcpy(&gpu_clock_wait, gpu_time_device_seqcst_wait, sizeof(clock_t), cudaMemcpyDeviceToHost);
-        
-        std::cout << "Device-Fetch-Add Device-Fetch-Add (Device, Seq-Cst) | Value : " << flag << " | Store : " << ((double) gpu_clock_store / 10000) / ((double) get_gpu_freq()) * 1000000. << " | Wait : " << ((double) gpu_clock_wait / 10000) / ((double) get_gpu_freq()) * 1000000. << std::endl;
-    } else {
-        std::cout << "Device-Fetch-Add Device-Fetch-Add (Device, Seq-Cst) | Value : " << *flag_device_seqcst << " | Store : " << ((double) (*gpu_time_device_seqcst_store / 10000)) / ((double) get_gpu_freq()) * 1000000. << " | Wait : " << ((double) (*gpu_time_device_seqcst_wait / 10000)) / ((double) get_gpu_freq()) * 1000000. << std::endl;
-    }
+template <cuda::thread_scope Scope, MemOrder Order, PingPongProtocol HostProtocol, PingPongProtocol DeviceProtocol>
+void device_ping_host_pong_cell(Arena &arena) {
+    std::string experiment = std::string("Device-PING Host-PONG (") + scope_name(Scope) + ", " + order_name(Order) + protocol_suffix(HostProtocol, DeviceProtocol) + ")";
+    if (!select_cell(experiment, {scope_name(Scope), order_name(Order), protocol_name(HostProtocol, DeviceProtocol)})) return;
 
-    cudaStreamDestroy(stream_device_seqcst_store);
-    cudaStreamDestroy(stream_device_seqcst_wait);
+    uint64_t *ping_trace, *pong_trace;
+    Measurement measurement = measure_latency([&](size_t iterations) {
+        arena.reset();
+        uint32_t *flag = arena.slot<uint32_t>();
+        clock_t *gpu_time = arena.slot<clock_t>();
+        ping_trace = trace_slot(arena);
+        pong_trace = trace_slot(arena);
 
-    if (allocator == CUDA_MALLOC) {
-        cudaMemset(sig, 0, sizeof(cuda::atomic<uint16_t, cuda::thread_scope_system>));
-    } else {
-        sig->store(PONG);
-    }
-    
-    clock_t *gpu_time_thread_seqcst_store;
-    clock_t *gpu_time_thread_seqcst_wait;
+        std::thread t = pinned_thread(core_pair().first, host_pong_function<Order, HostProtocol>, flag, pong_trace, iterations);
+        device_ping_kernel<Scope, Order, DeviceProtocol><<<1,1>>>(flag, gpu_time, ping_trace, iterations);
+        t.join();
+        cudaDeviceSynchronize();
+        return device_elapsed_ns(arena.read(gpu_time));
+    }, device_clock_calibration<false>());
 
-    if (allocator == CUDA_MALLOC_HOST) {
-        cudaMallocHost(&gpu_time_thread_seqcst_store, sizeof(clock_t));
-        cudaMallocHost(&gpu_time_thread_seqcst_wait, sizeof(clock_t));
-    } else if (allocator == MALLOC) {
-        gpu_time_thread_seqcst_store = (clock_t *) malloc(sizeof(clock_t));
-        gpu_time_thread_seqcst_wait = (clock_t *) malloc(sizeof(clock_t));
-    } else if (allocator == UM) {
-        cudaMallocManaged(&gpu_time_thread_seqcst_store, sizeof(clock_t));
-        cudaMallocManaged(&gpu_time_thread_seqcst_wait, sizeof(clock_t));
-    } else if (allocator == CUDA_MALLOC) {
-        cudaMalloc(&gpu_time_thread_seqcst_store, sizeof(clock_t));
-        cudaMalloc(&gpu_time_thread_seqcst_wait, sizeof(clock_t));
-    }
+    report_latency(experiment, "Device", measurement, device_clock_calibration<false>());
 
-    cudaStream_t stream_thread_seqcst_store;
-    cudaStream_t stream_thread_seqcst_wait;
+    if (ping_trace != nullptr) {
+        export_trace(experiment, read_trace(arena, ping_trace, "Device-PING", device_ns_per_tick()), read_trace(arena, pong_trace, "Host-PONG", host_ns_per_tick()));
+    }
+}
 
-    cudaStreamCreate(&stream_thread_seqcst_store);
-    cudaStreamCreate(&stream_thread_seqcst_wait);
+template <cuda::thread_scope Scope, MemOrder Order, PingPongProtocol Protocol>
+void device_ping_device_pong_cell(Arena &arena) {
+    std::string experiment = std::string("Device-PING Device-PONG (") + scope_name(Scope) + ", " + order_name(Order) + protocol_suffix(Protocol, Protocol) + ")";
+    if (!select_cell(experiment, {scope_name(Scope), order_name(Order), protocol_name(Protocol, Protocol)})) return;
 
-    device_fetch_add_seqcst<<<1,1,0, stream_thread_seqcst_store>>>(flag_thread_seqcst, sig, gpu_time_thread_seqcst_store);
-    device_fetch_add_seqcst<<<1,1,0, stream_thread_seqcst_wait>>>(flag_thread_seqcst, sig, gpu_time_thread_seqcst_wait);
+    cudaStream_t stream_a, stream_b;
+    cudaStreamCreate(&stream_a);
+    cudaStreamCreate(&stream_b);
 
-    cudaStreamSynchronize(stream_thread_seqcst_store);
-    cudaStreamSynchronize(stream_thread_seqcst_wait);
+    uint64_t *ping_trace, *pong_trace;
+    Measurement measurement = measure_latency([&](size_t iterations) {
+        arena.reset();
+        uint32_t *flag = arena.slot<uint32_t>();
+        clock_t *gpu_time = arena.slot<clock_t>();
+        ping_trace = trace_slot(arena);
+        pong_trace = trace_slot(arena);
 
-    cudaDeviceSynchronize();
+        device_ping_kernel<Scope, Order, Protocol><<<1,1,0,stream_a>>>(flag, gpu_time, ping_trace, iterations);
+        device_pong_kernel<Scope, Order, Protocol><<<1,1,0,stream_b>>>(flag, pong_trace, iterations);
 
-    if (allocator == CUDA_MALLOC) {
-        int flag;
-        clock_t gpu_clock_store;
-        clock_t gpu_clock_wait;
+        cudaStreamSynchronize(stream_a);
+        cudaStreamSynchronize(stream_b);
 
-        cudaMemcpy(&flag, flag_thread_seqcst, sizeof(int), cudaMemcpyDeviceToHost);
-        cudaMemcpy(&gpu_clock_store, gpu_time_thread_seqcst_store, sizeof(clock_t), cudaMemcpyDeviceToHost);
-        cudaMemcpy(&gpu_clock_wait, gpu_time_thread_seqcst_wait, sizeof(clock_t), cudaMemcpyDeviceToHost);
+        cudaDeviceSynchronize();
+        return device_elapsed_ns(arena.read(gpu_time));
+    }, device_clock_calibration<false>());
 
-        std::cout << "Device-Fetch-Add Device-Fetch-Add (Thread, Seq-Cst) | Value : " << flag << " | Store : " << ((double) gpu_clock_store / 10000) / ((double) get_gpu_freq()) * 1000000. << " | Wait : " << ((double) gpu_clock_wait / 10000) / ((double) get_gpu_freq()) * 1000000. << std::endl;
-    } else {
-        std::cout << "Device-Fetch-Add Device-Fetch-Add (Thread, Seq-Cst) | Value : " << *flag_thread_seqcst << " | Store : " << ((double) (*gpu_time_thread_seqcst_store / 10000)) / ((double) get_gpu_freq()) * 1000000. << " | Wait : " << ((double) (*gpu_time_thread_seqcst_wait / 10000)) / ((double) get_gpu_freq()) * 1000000. << std::endl;
-    }
-
-    cudaStreamDestroy(stream_thread_seqcst_store);
-    cudaStreamDestroy(stream_thread_seqcst_wait);
-
-    if (allocator == CUDA_MALLOC_HOST) {
-        cudaFreeHost(flag_thread_relaxed);
-        cudaFreeHost(flag_device_relaxed);
-        cudaFreeHost(flag_system_relaxed);
-        cudaFreeHost(flag_system_acqrel);
-        cudaFreeHost(flag_device_acqrel);
-        cudaFreeHost(flag_thread_acqrel);
-        cudaFreeHost(flag_system_seqcst);
-        cudaFreeHost(flag_device_seqcst);
-        cudaFreeHost(flag_thread_seqcst);
-        cudaFreeHost(sig);
-        cudaFreeHost(gpu_time_system_relaxed_store);
-        cudaFreeHost(gpu_time_system_relaxed_wait);
-        cudaFreeHost(gpu_time_device_relaxed_store);
-        cudaFreeHost(gpu_time_device_relaxed_wait);
-        cudaFreeHost(gpu_time_thread_relaxed_store);
-        cudaFreeHost(gpu_time_thread_relaxed_wait);
-        cudaFreeHost(gpu_time_device_relaxed_store);
-        cudaFreeHost(gpu_time_device_relaxed_wait);
-        cudaFreeHost(gpu_time_system_acqrel_store);
-        cudaFreeHost(gpu_time_system_acqrel_wait);
-        cudaFreeHost(gpu_time_device_acqrel_store);
-        cudaFreeHost(gpu_time_device_acqrel_wait);
-        cudaFreeHost(gpu_time_thread_acqrel_store);
-        cudaFreeHost(gpu_time_thread_acqrel_wait);
-        cudaFreeHost(gpu_time_system_seqcst_store);
-        cudaFreeHost(gpu_time_system_seqcst_wait);
-        cudaFreeHost(gpu_time_device_seqcst_store);
-        cudaFreeHost(gpu_time_device_seqcst_wait);
-        cudaFreeHost(gpu_time_thread_seqcst_store);
-        cudaFreeHost(gpu_time_thread_seqcst_wait);
-    } else if (allocator == MALLOC) {
-        free(flag_thread_relaxed);
-        free(flag_device_relaxed);
-        free(flag_system_relaxed);
-        free(flag_system_acqrel);
-        free(flag_device_acqrel);
-        free(flag_thread_acqrel);
-        free(flag_system_seqcst);
-        free(flag_device_seqcst);
-        free(flag_thread_seqcst);
-        free(sig);
-        free(gpu_time_system_relaxed_store);
-        free(gpu_time_system_relaxed_wait);
-        free(gpu_time_device_relaxed_store);
-        free(gpu_time_device_relaxed_wait);        
-        free(gpu_time_thread_relaxed_store);
-        free(gpu_time_thread_relaxed_wait);
-        free(gpu_time_device_relaxed_store);
-        free(gpu_time_device_relaxed_wait);
-        free(gpu_time_system_acqrel_store);
-        free(gpu_time_system_acqrel_wait);
-        free(gpu_time_device_acqrel_store);
-        free(gpu_time_device_acqrel_wait);
-        free(gpu_time_thread_acqrel_store);
-        free(gpu_time_thread_acqrel_wait);
-        free(gpu_time_system_seqcst_store);
-        free(gpu_time_system_seqcst_wait);
-        free(gpu_time_device_seqcst_store);
-        free(gpu_time_device_seqcst_wait);
-        free(gpu_time_thread_seqcst_store);
-        free(gpu_time_thread_seqcst_wait);
-    } else if (allocator == UM || allocator == CUDA_MALLOC) {
-        cudaFree(flag_thread_relaxed);
-        cudaFree(flag_device_relaxed);
-        cudaFree(flag_system_relaxed);
-        cudaFree(flag_system_acqrel);
-        cudaFree(flag_device_acqrel);
-        cudaFree(flag_thread_acqrel);
-        cudaFree(flag_system_seqcst);
-        cudaFree(flag_device_seqcst);
-        cudaFree(flag_thread_seqcst);
-        cudaFree(sig);
-        cudaFree(gpu_time_system_relaxed_store);
-        cudaFree(gpu_time_system_relaxed_wait);
-        cudaFree(gpu_time_thread_relaxed_store);
-        cudaFree(gpu_time_thread_relaxed_wait);
-        cudaFree(gpu_time_device_relaxed_store);
-        cudaFree(gpu_time_device_relaxed_wait);
-        cudaFree(gpu_time_system_acqrel_store);
-        cudaFree(gpu_time_system_acqrel_wait);
-        cudaFree(gpu_time_device_acqrel_store);
-        cudaFree(gpu_time_device_acqrel_wait);
-        cudaFree(gpu_time_thread_acqrel_store);
-        cudaFree(gpu_time_thread_acqrel_wait);
-        cudaFree(gpu_time_system_seqcst_store);
-        cudaFree(gpu_time_system_seqcst_wait);
-        cudaFree(gpu_time_device_seqcst_store);
-        cudaFree(gpu_time_device_seqcst_wait);
-        cudaFree(gpu_time_thread_seqcst_store);
-        cudaFree(gpu_time_thread_seqcst_wait);
-    }
-
-    // cuda::atomic<uint16_t, cuda::thread_scope_thread> *flag_thread_relaxed_store_wait;
-    // cuda::atomic<uint16_t, cuda::thread_scope_device> *flag_device_relaxed_store_wait;
-    // cuda::atomic<uint16_t, cuda::thread_scope_system> *flag_system_relaxed_store_wait;
-
-    // if (allocator)
-}
-
-void host_device_fetch_add(Allocator allocator) {
-    cuda::atomic<uint16_t, cuda::thread_scope_thread> *flag_thread_relaxed;
-    cuda::atomic<uint16_t, cuda::thread_scope_device> *flag_device_relaxed;
-    cuda::atomic<uint16_t, cuda::thread_scope_system> *flag_system_relaxed;
-
-    cuda::atomic<uint16_t, cuda::thread_scope_system> *sig;
-
-    if (allocator == CUDA_MALLOC_HOST) {
-        cudaMallocHost(&sig, sizeof(cuda::atomic<uint16_t, cuda::thread_scope_system>));
-    } else if (allocator == MALLOC) {
-        sig = (cuda::atomic<uint16_t, cuda::thread_scope_system> *) malloc(sizeof(cuda::atomic<uint16_t, cuda::thread_scope_system>));
-    } else if (allocator == UM) {
-        cudaMallocManaged(&sig, sizeof(cuda::atomic<uint16_t, cuda::thread_scope_system>));
-    }
-
-    if (allocator == CUDA_MALLOC_HOST) {
-        cudaMallocHost(&flag_thread_relaxed, sizeof(cuda::atomic<uint16_t, cuda::thread_scope_thread>));
-        cudaMallocHost(&flag_device_relaxed, sizeof(cuda::atomic<uint16_t, cuda::thread_scope_device>));
-        cudaMallocHost(&flag_system_relaxed, sizeof(cuda::atomic<uint16_t, cuda::thread_scope_system>));
-    } else if (allocator == MALLOC) {
-        flag_thread_relaxed = (cuda::atomic<uint16_t, cuda::thread_scope_thread> *) malloc(sizeof(cuda::atomic<uint16_t, cuda::thread_scope_thread>));
-        flag_device_relaxed = (cuda::atomic<uint16_t, cuda::thread_scope_device> *) malloc(sizeof(cuda::atomic<uint16_t, cuda::thread_scope_device>));
-        flag_system_relaxed = (cuda::atomic<uint16_t, cuda::thread_scope_system> *) malloc(sizeof(cuda::atomic<uint16_t, cuda::thread_scope_system>));
-    } else if (allocator == UM) {
-        cudaMallocManaged(&flag_thread_relaxed, sizeof(cuda::atomic<uint16_t, cuda::thread_scope_thread>));
-        cudaMallocManaged(&flag_device_relaxed, sizeof(cuda::atomic<uint16_t, cuda::thread_scope_device>));
-        cudaMallocManaged(&flag_system_relaxed, sizeof(cuda::atomic<uint16_t, cuda::thread_scope_system>));
-    }
-    
-    cpu_set_t cpuset;
-    
-    sig->store(PONG);
-    uint64_t cpu_time_system_relaxed;
-    std::thread t_system_relaxed(host_fetch_add_relaxed, (std::atomic<uint16_t> *) flag_system_relaxed, (std::atomic<uint16_t> *) sig, &cpu_time_system_relaxed);
-    CPU_ZERO(&cpuset);
-    CPU_SET(0, &cpuset);
-    pthread_setaffinity_np(t_system_relaxed.native_handle(), sizeof(cpu_set_t), &cpuset);
-    
-    // clock_t gpu_time_system_relaxed;
-    clock_t * gpu_time_system_relaxed;
-
-    if (allocator == CUDA_MALLOC_HOST) {
-        cudaMallocHost(&gpu_time_system_relaxed, sizeof(clock_t));
-    } else if (allocator == MALLOC) {
-        gpu_time_system_relaxed = (clock_t *) malloc(sizeof(clock_t));
-    } else if (allocator == UM) {
-        cudaMallocManaged(&gpu_time_system_relaxed, sizeof(clock_t));
-    }
-
-    device_fetch_add_relaxed<<<1,1>>>(flag_system_relaxed, sig, gpu_time_system_relaxed);
-    
-    cudaDeviceSynchronize();
-    t_system_relaxed.join();
+    report_latency(experiment, "Device", measurement, device_clock_calibration<false>());
 
-    std::cout << "Host-Fetch-Add Device-Fetch-Add (System, Relaxed) | Value : " << *flag_system_relaxed << " | Host : " << ((double) (cpu_time_system_relaxed / 10000)) / ((double) get_cpu_freq() / 1000.) * 1000000. << " | Device : " << ((double) (*gpu_time_system_relaxed / 10000)) / ((double) get_gpu_freq()) * 1000000. << std::endl;
+    if (ping_trace != nullptr) {
+        export_trace(experiment, read_trace(arena, ping_trace, "Device-PING", device_ns_per_tick()), read_trace(arena, pong_trace, "Device-PONG", device_ns_per_tick()));
+    }
 
-    sig->store(PONG);
-    uint64_t cpu_time_device_relaxed;
-    std::thread t_device_relaxed(host_fetch_add_relaxed, (std::atomic<uint16_t> *) flag_device_relaxed, (std::atomic<uint16_t> *) sig, &cpu_time_device_relaxed);
-    CPU_ZERO(&cpuset);
-    CPU_SET(0, &cpuset);
-    pthread_setaffinity_np(t_device_relaxed.native_handle(), sizeof(cpu_set_t), &cpuset);
-    
-    // clock_t gpu_time_device_relaxed;
+    cudaStreamDestroy(stream_a);
+    cudaStreamDestroy(stream_b);
+}
 
-    clock_t * gpu_time_device_relaxed;
+// GPU-less: the device pong is replaced by a host thread with an injected interconnect latency
+template <MemOrder Order, PingPongProtocol Protocol>
+void host_ping_simulated_pong_cell(Arena &arena, const LatencyModel &model) {
+    std::string experiment = std::string("Host-PING Simulated-PONG (") + order_name(Order) + protocol_suffix(Protocol, Protocol) + ", " + model.spec + ")";
+    if (!select_cell(experiment, {nullptr, order_name(Order), protocol_name(Protocol, Protocol)})) return;
 
-    if (allocator == CUDA_MALLOC_HOST) {
-        cudaMallocHost(&gpu_time_device_relaxed, sizeof(clock_t));
-    } else if (allocator == MALLOC) {
-        gpu_time_device_relaxed = (clock_t *) malloc(sizeof(clock_t));
-    } else if (allocator == UM) {
-        cudaMallocManaged(&gpu_time_device_relaxed, sizeof(clock_t));
-    }
+    uint64_t *ping_trace, *pong_trace;
+    Measurement measurement = measure_latency([&](size_t iterations) {
+        arena.reset();
+        uint32_t *flag = arena.slot<uint32_t>();
+        ping_trace = trace_slot(arena);
+        pong_trace = trace_slot(arena);
 
-    device_fetch_add_relaxed<<<1,1>>>(flag_device_relaxed, sig, gpu_time_device_relaxed);
-    
-    cudaDeviceSynchronize();
-    t_device_relaxed.join();
-    
-    std::cout << "Host-Fetch-Add Device-Fetch-Add (Device, Relaxed) | Value : " << *flag_device_relaxed << " | Host : " << ((double) (cpu_time_device_relaxed / 10000)) / ((double) get_cpu_freq() / 1000.) * 1000000. << " | Device : " << ((double) (*gpu_time_device_relaxed / 10000)) / ((double) get_gpu_freq()) * 1000000. << std::endl;
-    
-    sig->store(PONG);
-    uint64_t cpu_time_thread_relaxed;
-    std::thread t_thread_relaxed(host_fetch_add_relaxed, (std::atomic<uint16_t> *) flag_thread_relaxed, (std::atomic<uint16_t> *) sig, &cpu_time_thread_relaxed);
-    CPU_ZERO(&cpuset);
-    CPU_SET(0, &cpuset);
-    pthread_setaffinity_np(t_thread_relaxed.native_handle(), sizeof(cpu_set_t), &cpuset);
-    
-    // clock_t gpu_time_thread_relaxed;
-
-    clock_t * gpu_time_thread_relaxed;
-
-    if (allocator == CUDA_MALLOC_HOST) {
-        cudaMallocHost(&gpu_time_thread_relaxed, sizeof(clock_t));
-    } else if (allocator == MALLOC) {
-        gpu_time_thread_relaxed = (clock_t *) malloc(sizeof(clock_t));
-    } else if (allocator == UM) {
-        cudaMallocManaged(&gpu_time_thread_relaxed, sizeof(clock_t));
-    }
-
-    device_fetch_add_relaxed<<<1,1>>>(flag_thread_relaxed, sig, gpu_time_thread_relaxed);
-    
-    cudaDeviceSynchronize();
-    t_thread_relaxed.join();
-    
-    std::cout << "Host-Fetch-Add Device-Fetch-Add (Thread, Relaxed) | Value : " << *flag_thread_relaxed << " | Host : " << ((double) (cpu_time_thread_relaxed / 10000)) / ((double) get_cpu_freq() / 1000.) * 1000000. << " | Device : " << ((double) (*gpu_time_thread_relaxed / 10000)) / ((double) get_gpu_freq()) * 1000000. << std::endl;
-    
-    cuda::atomic<uint16_t, cuda::thread_scope_thread> *flag_thread_acqrel;
-    cuda::atomic<uint16_t, cuda::thread_scope_device> *flag_device_acqrel;
-    cuda::atomic<uint16_t, cuda::thread_scope_system> *flag_system_acqrel;
-
-    if (allocator == CUDA_MALLOC_HOST) {
-        cudaMallocHost(&flag_thread_acqrel, sizeof(cuda::atomic<uint16_t, cuda::thread_scope_thread>));
-        cudaMallocHost(&flag_device_acqrel, sizeof(cuda::atomic<uint16_t, cuda::thread_scope_device>));
-        cudaMallocHost(&flag_system_acqrel, sizeof(cuda::atomic<uint16_t, cuda::thread_scope_system>));
-    } else if (allocator == MALLOC) {
-        flag_thread_acqrel = (cuda::atomic<uint16_t, cuda::thread_scope_thread> *) malloc(sizeof(cuda::atomic<uint16_t, cuda::thread_scope_thread>));
-        flag_device_acqrel = (cuda::atomic<uint16_t, cuda::thread_scope_device> *) malloc(sizeof(cuda::atomic<uint16_t, cuda::thread_scope_device>));
-        flag_system_acqrel = (cuda::atomic<uint16_t, cuda::thread_scope_system> *) malloc(sizeof(cuda::atomic<uint16_t, cuda::thread_scope_system>));
-    } else if (allocator == UM) {
-        cudaMallocManaged(&flag_system_acqrel, sizeof(cuda::atomic<uint16_t, cuda::thread_scope_system>));
-        cudaMallocManaged(&flag_device_acqrel, sizeof(cuda::atomic<uint16_t, cuda::thread_scope_device>));
-        cudaMallocManaged(&flag_thread_acqrel, sizeof(cuda::atomic<uint16_t, cuda::thread_scope_thread>));
-    }
-    
-    sig->store(PONG);
-    uint64_t cpu_time_system_acqrel;
-    std::thread t_system_acqrel(host_fetch_add_acqrel, (std::atomic<uint16_t> *) flag_system_acqrel, (std::atomic<uint16_t> *) sig, &cpu_time_system_acqrel);
-    CPU_ZERO(&cpuset);
-    CPU_SET(0, &cpuset);
-    pthread_setaffinity_np(t_system_acqrel.native_handle(), sizeof(cpu_set_t), &cpuset);
-    
-    // clock_t gpu_time_system_acqrel;
-
-    clock_t * gpu_time_system_acqrel;
-
-    if (allocator == CUDA_MALLOC_HOST) {
-        cudaMallocHost(&gpu_time_system_acqrel, sizeof(clock_t));
-    } else if (allocator == MALLOC) {
-        gpu_time_system_acqrel = (clock_t *) malloc(sizeof(clock_t));
-    } else if (allocator == UM) {
-        cudaMallocManaged(&gpu_time_system_acqrel, sizeof(clock_t));
-    }
-
-    device_fetch_add_acqrel<<<1,1>>>(flag_system_acqrel, sig, gpu_time_system_acqrel);
-    
-    t_system_acqrel.join();
-    cudaDeviceSynchronize();
-    
-    std::cout << "Host-Fetch-Add Device-Fetch-Add (System, Acq-Rel) | Value : " << *flag_system_acqrel << " | Host : " << ((double) (cpu_time_system_acqrel / 10000)) / ((double) get_cpu_freq() / 1000.) * 1000000. << " | Device : " << ((double) (*gpu_time_system_acqrel / 10000)) / ((double) get_gpu_freq()) * 1000000. << std::endl;
-    
-    sig->store(PONG);
-    uint64_t cpu_time_device_acqrel;
-    std::thread t_device_acqrel(host_fetch_add_acqrel, (std::atomic<uint16_t> *) flag_device_acqrel, (std::atomic<uint16_t> *) sig, &cpu_time_device_acqrel);
-    CPU_ZERO(&cpuset);
-    CPU_SET(0, &cpuset);
-    pthread_setaffinity_np(t_device_acqrel.native_handle(), sizeof(cpu_set_t), &cpuset);
-    
-    // clock_t gpu_time_device_acqrel;
-
-    clock_t * gpu_time_device_acqrel;
-
-    if (allocator == CUDA_MALLOC_HOST) {
-        cudaMallocHost(&gpu_time_device_acqrel, sizeof(clock_t));
-    } else if (allocator == MALLOC) {
-        gpu_time_device_acqrel = (clock_t *) malloc(sizeof(clock_t));
-    } else if (allocator == UM) {
-        cudaMallocManaged(&gpu_time_device_acqrel, sizeof(clock_t));
-    }
-
-    device_fetch_add_acqrel<<<1,1>>>(flag_device_acqrel, sig, gpu_time_device_acqrel);
-    
-    t_device_acqrel.join();
-    cudaDeviceSynchronize();
-    
-    std::cout << "Host-Fetch-Add Device-Fetch-Add (Device, Acq-Rel) | Value : " << *flag_device_acqrel << " | Host : " << ((double) (cpu_time_device_acqrel / 10000)) / ((double) get_cpu_freq() / 1000.) * 1000000. << " | Device : " << ((double) (*gpu_time_device_acqrel / 10000)) / ((double) get_gpu_freq()) * 1000000. << std::endl;
-    
-    sig->store(PONG);
-    uint64_t cpu_time_thread_acqrel;
-    std::thread t_thread_acqrel(host_fetch_add_acqrel, (std::atomic<uint16_t> *) flag_thread_acqrel, (std::atomic<uint16_t> *) sig, &cpu_time_thread_acqrel);
-    CPU_ZERO(&cpuset);
-    CPU_SET(0, &cpuset);
-    pthread_setaffinity_np(t_thread_acqrel.native_handle(), sizeof(cpu_set_t), &cpuset);
-    
-    // clock_t gpu_time_thread_acqrel;
-
-    clock_t * gpu_time_thread_acqrel;
-
-    if (allocator == CUDA_MALLOC_HOST) {
-        cudaMallocHost(&gpu_time_thread_acqrel, sizeof(clock_t));
-    } else if (allocator == MALLOC) {
-        gpu_time_thread_acqrel = (clock_t *) malloc(sizeof(clock_t));
-    } else if (allocator == UM) {
-        cudaMallocManaged(&gpu_time_thread_acqrel, sizeof(clock_t));
-    }
-
-    device_fetch_add_acqrel<<<1,1>>>(flag_thread_acqrel, sig, gpu_time_thread_acqrel);
-    
-    t_thread_acqrel.join();
-    cudaDeviceSynchronize();
-    
-    std::cout << "Host-Fetch-Add Device-Fetch-Add (Thread, Acq-Rel) | Value : " << *flag_thread_acqrel << " | Host : " << ((double) (cpu_time_thread_acqrel / 10000)) / ((double) get_cpu_freq() / 1000.) * 1000000. << " | Device : " << ((double) (*gpu_time_thread_acqrel / 10000)) / ((double) get_gpu_freq()) * 1000000. << std::endl;
-    
-    cuda::atomic<uint16_t, cuda::thread_scope_thread> *flag_thread_seqcst;
-    cuda::atomic<uint16_t, cuda::thread_scope_device> *flag_device_seqcst;
-    cuda::atomic<uint16_t, cuda::thread_scope_system> *flag_system_seqcst;
-    
-    if (allocator == CUDA_MALLOC_HOST) {
-        cudaMallocHost(&flag_thread_seqcst, sizeof(cuda::atomic<uint16_t, cuda::thread_scope_thread>));
-        cudaMallocHost(&flag_device_seqcst, sizeof(cuda::atomic<uint16_t, cuda::thread_scope_device>));
-        cudaMallocHost(&flag_system_seqcst, sizeof(cuda::atomic<uint16_t, cuda::thread_scope_system>));
-    } else if (allocator == MALLOC) {
-        flag_thread_seqcst = (cuda::atomic<uint16_t, cuda::thread_scope_thread> *) malloc(sizeof(cuda::atomic<uint16_t, cuda::thread_scope_thread>));
-        flag_device_seqcst = (cuda::atomic<uint16_t, cuda::thread_scope_device> *) malloc(sizeof(cuda::atomic<uint16_t, cuda::thread_scope_device>));
-        flag_system_seqcst = (cuda::atomic<uint16_t, cuda::thread_scope_system> *) malloc(sizeof(cuda::atomic<uint16_t, cuda::thread_scope_system>));
-    } else if (allocator == UM) {
-        cudaMallocManaged(&flag_thread_seqcst, sizeof(cuda::atomic<uint16_t, cuda::thread_scope_thread>));
-        cudaMallocManaged(&flag_device_seqcst, sizeof(cuda::atomic<uint16_t, cuda::thread_scope_device>));
-        cudaMallocManaged(&flag_system_seqcst, sizeof(cuda::atomic<uint16_t, cuda::thread_scope_system>));
-    }
-    
-    sig->store(PONG);
-    uint64_t cpu_time_system_seqcst;
-    std::thread t_system_seqcst(host_fetch_add_seqcst, (std::atomic<uint16_t> *) flag_system_seqcst, (std::atomic<uint16_t> *) sig, &cpu_time_system_seqcst);
-    CPU_ZERO(&cpuset);
-    CPU_SET(0, &cpuset);
-    pthread_setaffinity_np(t_system_seqcst.native_handle(), sizeof(cpu_set_t), &cpuset);
-    
-    // clock_t gpu_time_system_seqcst;
-
-    clock_t * gpu_time_system_seqcst;
-
-    if (allocator == CUDA_MALLOC_HOST) {
-        cudaMallocHost(&gpu_time_system_seqcst, sizeof(clock_t));
-    } else if (allocator == MALLOC) {
-        gpu_time_system_seqcst = (clock_t *) malloc(sizeof(clock_t));
-    } else if (allocator == UM) {
-        cudaMallocManaged(&gpu_time_system_seqcst, sizeof(clock_t));
-    }
-
-    device_fetch_add_seqcst<<<1,1>>>(flag_system_seqcst, sig, gpu_time_system_seqcst);
-    
-    t_system_seqcst.join();
-    cudaDeviceSynchronize();
-    
-    std::cout << "Host-Fetch-Add Device-Fetch-Add (System, Seq-Cst) | Value : " << *flag_system_seqcst << " | Host : " << ((double) (cpu_time_system_seqcst / 10000)) / ((double) get_cpu_freq() / 1000.) * 1000000. << " | Device : " << ((double) (*gpu_time_system_seqcst / 10000)) / ((double) get_gpu_freq()) * 1000000. << std::endl;
-    
-    sig->store(PONG);
-    uint64_t cpu_time_device_seqcst;
-    std::thread t_device_seqcst(host_fetch_add_seqcst, (std::atomic<uint16_t> *) flag_device_seqcst, (std::atomic<uint16_t> *) sig, &cpu_time_device_seqcst);
-    CPU_ZERO(&cpuset);
-    CPU_SET(0, &cpuset);
-    pthread_setaffinity_np(t_device_seqcst.native_handle(), sizeof(cpu_set_t), &cpuset);
-    
-    // clock_t gpu_time_device_seqcst;
-
-    clock_t * gpu_time_device_seqcst;
-
-    if (allocator == CUDA_MALLOC_HOST) {
-        cudaMallocHost(&gpu_time_device_seqcst, sizeof(clock_t));
-    } else if (allocator == MALLOC) {
-        gpu_time_device_seqcst = (clock_t *) malloc(sizeof(clock_t));
-    } else if (allocator == UM) {
-        cudaMallocManaged(&gpu_time_device_seqcst, sizeof(clock_t));
-    }
-
-    device_fetch_add_seqcst<<<1,1>>>(flag_device_seqcst, sig, gpu_time_device_seqcst);
-    
-    t_device_seqcst.join();
-    cudaDeviceSynchronize();
-    
-    std::cout << "Host-Fetch-Add Device-Fetch-Add (Device, Seq-Cst) | Value : " << *flag_device_seqcst << " | Host : " << ((double) (cpu_time_device_seqcst / 10000)) / ((double) get_cpu_freq() / 1000.) * 1000000. << " | Device : " << ((double) (*gpu_time_device_seqcst / 10000)) / ((double) get_gpu_freq()) * 1000000. << std::endl;
-    
-    sig->store(PONG);
-    uint64_t cpu_time_thread_seqcst;
-    std::thread t_thread_seqcst(host_fetch_add_seqcst, (std::atomic<uint16_t> *) flag_thread_seqcst, (std::atomic<uint16_t> *) sig, &cpu_time_thread_seqcst);
-    CPU_ZERO(&cpuset);
-    CPU_SET(0, &cpuset);
-    pthread_setaffinity_np(t_thread_seqcst.native_handle(), sizeof(cpu_set_t), &cpuset);
+        LatencyInjector injector(model, iterations);
 
-    // clock_t gpu_time_thread_seqcst;
+        uint64_t cpu_time;
+        std::thread t_ping = pinned_thread(core_pair().first, host_ping_function<Order, Protocol>, flag, &cpu_time, ping_trace, iterations);
+        std::thread t_pong = pinned_thread(core_pair().second, host_pong_function_simulated<Order, Protocol>, flag, &injector, pong_trace, iterations);
+        t_ping.join();
+        t_pong.join();
+        return host_elapsed_ns(cpu_time);
+    }, host_clock_calibration());
 
-    clock_t * gpu_time_thread_seqcst;
+    report_latency(experiment, "Host", measurement, host_clock_calibration());
 
-    if (allocator == CUDA_MALLOC_HOST) {
-        cudaMallocHost(&gpu_time_thread_seqcst, sizeof(clock_t));
-    } else if (allocator == MALLOC) {
-        gpu_time_thread_seqcst = (clock_t *) malloc(sizeof(clock_t));
-    } else if (allocator == UM) {
-        cudaMallocManaged(&gpu_time_thread_seqcst, sizeof(clock_t));
+    if (ping_trace != nullptr) {
+        export_trace(experiment, read_trace(arena, ping_trace, "Host-PING", host_ns_per_tick()), read_trace(arena, pong_trace, "Simulated-PONG", host_ns_per_tick()));
     }
+}
 
-    device_fetch_add_seqcst<<<1,1>>>(flag_thread_seqcst, sig, gpu_time_thread_seqcst);
-
-    t_thread_seqcst.join();
-    cudaDeviceSynchronize();
-
-    std::cout << "Host-Fetch-Add Device-Fetch-Add (Thread, Seq-Cst) | Value : " << *flag_thread_seqcst << " | Host : " << ((double) (cpu_time_thread_seqcst / 10000)) / ((double) get_cpu_freq() / 1000.) * 1000000. << " | Device : " << ((double) (*gpu_time_thread_seqcst / 10000)) / ((double) get_gpu_freq()) * 1000000. << std::endl;
-
-    if (allocator == MALLOC) {
-        free(flag_thread_relaxed);
-        free(flag_device_relaxed);
-        free(flag_system_relaxed);
-
-        free(flag_thread_acqrel);
-        free(flag_device_acqrel);
-        free(flag_system_acqrel);
-
-        free(flag_thread_seqcst);
-        free(flag_device_seqcst);
-        free(flag_system_seqcst);
-    } else if (allocator == CUDA_MALLOC_HOST) {
-        cudaFreeHost(flag_thread_relaxed);
-        cudaFreeHost(flag_device_relaxed);
-        cudaFreeHost(flag_system_relaxed);
-
-        cudaFreeHost(flag_thread_acqrel);
-        cudaFreeHost(flag_device_acqrel);
-        cudaFreeHost(flag_system_acqrel);
-
-        cudaFreeHost(flag_thread_seqcst);
-        cudaFreeHost(flag_device_seqcst);
-        cudaFreeHost(flag_system_seqcst);
-    } else if (allocator == UM) {
-        cudaFree(flag_thread_relaxed);
-        cudaFree(flag_device_relaxed);
-        cudaFree(flag_system_relaxed);
-
-        cudaFree(flag_thread_acqrel);
-        cudaFree(flag_device_acqrel);
-        cudaFree(flag_system_acqrel);
-
-        cudaFree(flag_thread_seqcst);
-        cudaFree(flag_device_seqcst);
-        cudaFree(flag_system_seqcst);
-    }
-
-    if (allocator == MALLOC) {
-        free(sig);
-    } else if (allocator == CUDA_MALLOC_HOST) {
-        cudaFreeHost(sig);
-    } else if (allocator == UM) {
-        cudaFree(sig);
-    }
-}
-
-void host_ping_device_pong_assymetric(Allocator allocator) {
-
-    cuda::atomic<uint16_t, cuda::thread_scope_thread> *flag_thread_relaxed;
-    cuda::atomic<uint16_t, cuda::thread_scope_device> *flag_device_relaxed;
-    cuda::atomic<uint16_t, cuda::thread_scope_system> *flag_system_relaxed;
-
-    if (allocator == CUDA_MALLOC_HOST) {
-        cudaMallocHost(&flag_thread_relaxed, sizeof(cuda::atomic<uint16_t, cuda::thread_scope_thread>));
-        cudaMallocHost(&flag_device_relaxed, sizeof(cuda::atomic<uint16_t, cuda::thread_scope_device>));
-        cudaMallocHost(&flag_system_relaxed, sizeof(cuda::atomic<uint16_t, cuda::thread_scope_system>));
-    } else if (allocator == MALLOC) {
-        flag_thread_relaxed = (cuda::atomic<uint16_t, cuda::thread_scope_thread> *) malloc(sizeof(cuda::atomic<uint16_t, cuda::thread_scope_thread>));
-        flag_device_relaxed = (cuda::atomic<uint16_t, cuda::thread_scope_device> *) malloc(sizeof(cuda::atomic<uint16_t, cuda::thread_scope_device>));
-        flag_system_relaxed = (cuda::atomic<uint16_t, cuda::thread_scope_system> *) malloc(sizeof(cuda::atomic<uint16_t, cuda::thread_scope_system>));
-    } else if (allocator == UM) {
-        cudaMallocManaged(&flag_thread_relaxed, sizeof(cuda::atomic<uint16_t, cuda::thread_scope_thread>));
-        cudaMallocManaged(&flag_device_relaxed, sizeof(cuda::atomic<uint16_t, cuda::thread_scope_device>));
-        cudaMallocManaged(&flag_system_relaxed, sizeof(cuda::atomic<uint16_t, cuda::thread_scope_system>));
-    }
-
-    cpu_set_t cpuset;
-
-    uint64_t cpu_time_system;
-    std::thread t_system(host_ping_function_relaxed_base, (std::atomic<uint16_t> *) flag_system_relaxed, &cpu_time_system);
-    CPU_ZERO(&cpuset);
-    CPU_SET(0, &cpuset);
-    pthread_setaffinity_np(t_system.native_handle(), sizeof(cpu_set_t), &cpuset);
-    device_pong_kernel_relaxed_decoupled<<<1,1>>>(flag_system_relaxed);
-    t_system.join();
-    cudaDeviceSynchronize();
+// sync phase: a traced decoupled ping/pong across the core pair, offset maps the second core's clock onto the first's
+ClockOffset host_host_clock_offset(Arena &arena) {
+    uint32_t *flag = arena.slot<uint32_t>();
+    uint64_t *ping_trace = arena.slot<uint64_t>(TRACE_EVENTS);
+    uint64_t *pong_trace = arena.slot<uint64_t>(TRACE_EVENTS);
 
-    std::cout << "Host-PING Device-PONG (System, Relaxed, CPU-CAS GPU-Decoupled) | Host : " << ((double) (cpu_time_system / 10000)) / ((double) get_cpu_freq() / 1000.) * 1000000. << std::endl;
+    uint64_t cpu_time;
+    std::thread t_ping = pinned_thread(core_pair().first, host_ping_function<ACQ_REL, DECOUPLED>, flag, &cpu_time, ping_trace, PINGPONG_ITERATIONS);
+    std::thread t_pong = pinned_thread(core_pair().second, host_pong_function<ACQ_REL, DECOUPLED>, flag, pong_trace, PINGPONG_ITERATIONS);
+    t_ping.join();
+    t_pong.join();
 
-    uint64_t cpu_time_device;
-    std::thread t_device(host_ping_function_relaxed_base, (std::atomic<uint16_t> *) flag_device_relaxed, &cpu_time_device);
-    CPU_ZERO(&cpuset);
-    CPU_SET(0, &cpuset);
-    pthread_setaffinity_np(t_device.native_handle(), sizeof(cpu_set_t), &cpuset);
-    device_pong_kernel_relaxed_decoupled<<<1,1>>>(flag_device_relaxed);
-    t_device.join();
-    cudaDeviceSynchronize();
+    return pingpong_offset(read_trace(arena, ping_trace, "Host-PING", host_ns_per_tick()), read_trace(arena, pong_trace, "Host-PONG", host_ns_per_tick()));
+}
 
-    std::cout << "Host-PING Device-PONG (Device, Relaxed, CPU-CAS GPU-Decoupled) | Host : " << ((double) (cpu_time_device / 10000)) / ((double) get_cpu_freq() / 1000.) * 1000000. << std::endl;
-
-    // uint64_t cpu_time_thread;
-    // std::thread t_thread(host_ping_function_relaxed_base, (std::atomic<uint16_t> *) flag_thread_relaxed, &cpu_time_thread);
-    // CPU_ZERO(&cpuset);
-    // CPU_SET(0, &cpuset);
-    // pthread_setaffinity_np(t_thread.native_handle(), sizeof(cpu_set_t), &cpuset);
-    // device_pong_kernel_relaxed_decoupled<<<1,1>>>(flag_thread_relaxed);
-    // t_thread.join();
-    // cudaDeviceSynchronize();
-
-    // std::cout << "Host-PING Device-PONG (Thread, Relaxed, CPU-CAS GPU-Decoupled) | Host : " << ((double) (cpu_time_thread / 10000)) / ((double) get_cpu_freq() / 1000.) * 1000000. << std::endl;
-
-    cuda::atomic<uint16_t, cuda::thread_scope_thread> *flag_thread_acqrel;
-    cuda::atomic<uint16_t, cuda::thread_scope_device> *flag_device_acqrel;
-    cuda::atomic<uint16_t, cuda::thread_scope_system> *flag_system_acqrel;
-
-    if (allocator == CUDA_MALLOC_HOST) {
-        cudaMallocHost(&flag_thread_acqrel, sizeof(cuda::atomic<uint16_t, cuda::thread_scope_thread>));
-        cudaMallocHost(&flag_device_acqrel, sizeof(cuda::atomic<uint16_t, cuda::thread_scope_device>));
-        cudaMallocHost(&flag_system_acqrel, sizeof(cuda::atomic<uint16_t, cuda::thread_scope_system>));
-    } else if (allocator == MALLOC) {
-        flag_thread_acqrel = (cuda::atomic<uint16_t, cuda::thread_scope_thread> *) malloc(sizeof(cuda::atomic<uint16_t, cuda::thread_scope_thread>));
-        flag_device_acqrel = (cuda::atomic<uint16_t, cuda::thread_scope_device> *) malloc(sizeof(cuda::atomic<uint16_t, cuda::thread_scope_device>));
-        flag_system_acqrel = (cuda::atomic<uint16_t, cuda::thread_scope_system> *) malloc(sizeof(cuda::atomic<uint16_t, cuda::thread_scope_system>));
-    } else if (allocator == UM) {
-        cudaMallocManaged(&flag_thread_acqrel, sizeof(cuda::atomic<uint16_t, cuda::thread_scope_thread>));
-        cudaMallocManaged(&flag_device_acqrel, sizeof(cuda::atomic<uint16_t, cuda::thread_scope_device>));
-        cudaMallocManaged(&flag_system_acqrel, sizeof(cuda::atomic<uint16_t, cuda::thread_scope_system>));
-    }
-
-    uint64_t cpu_time_system_acqrel;
-
-    std::thread t_system_acqrel(host_ping_function_acqrel_base, (std::atomic<uint16_t> *) flag_system_acqrel, &cpu_time_system_acqrel);
-    CPU_ZERO(&cpuset);
-    CPU_SET(0, &cpuset);
-    pthread_setaffinity_np(t_system_acqrel.native_handle(), sizeof(cpu_set_t), &cpuset);
-    device_pong_kernel_acqrel_decoupled<<<1,1>>>(flag_system_acqrel);
-    t_system_acqrel.join();
+// sync phase against the device, offset maps globaltimer onto the host clock
+template <cuda::thread_scope Scope>
+ClockOffset host_device_clock_offset(Arena &arena) {
+    uint32_t *flag = arena.slot<uint32_t>();
+    uint64_t *ping_trace = arena.slot<uint64_t>(TRACE_EVENTS);
+    uint64_t *pong_trace = arena.slot<uint64_t>(TRACE_EVENTS);
+
+    uint64_t cpu_time;
+    std::thread t = pinned_thread(core_pair().first, host_ping_function<ACQ_REL, DECOUPLED>, flag, &cpu_time, ping_trace, PINGPONG_ITERATIONS);
+    device_pong_kernel<Scope, ACQ_REL, DECOUPLED><<<1,1>>>(flag, pong_trace, PINGPONG_ITERATIONS);
+    t.join();
     cudaDeviceSynchronize();
 
-    std::cout << "Host-PING Device-PONG (System, Acq-Rel, CPU-CAS GPU-Decoupled) | Host : " << ((double) (cpu_time_system_acqrel / 10000)) / ((double) get_cpu_freq() / 1000.) * 1000000. << std::endl;
-
-    uint64_t cpu_time_device_acqrel;
-    std::thread t_device_acqrel(host_ping_function_acqrel_base, (std::atomic<uint16_t> *) flag_device_acqrel, &cpu_time_device_acqrel);
-    CPU_ZERO(&cpuset);
-    CPU_SET(0, &cpuset);
-    pthread_setaffinity_np(t_device_acqrel.native_handle(), sizeof(cpu_set_t), &cpuset);
-    device_pong_kernel_acqrel_decoupled<<<1,1>>>(flag_device_acqrel);
-    t_device_acqrel.join();
-    cudaDeviceSynchronize();
+    return pingpong_offset(read_trace(arena, ping_trace, "Host-PING", host_ns_per_tick()), read_trace(arena, pong_trace, "Device-PONG", device_ns_per_tick()));
+}
 
-    std::cout << "Host-PING Device-PONG (Device, Acq-Rel, CPU-CAS GPU-Decoupled) | Host : " << ((double) (cpu_time_device_acqrel / 10000)) / ((double) get_cpu_freq() / 1000.) * 1000000. << std::endl;
-
-    // uint64_t cpu_time_thread_acqrel;
-    // std::thread t_thread_acqrel(host_ping_function_acqrel_base, (std::atomic<uint16_t> *) flag_thread_acqrel, &cpu_time_thread_acqrel);
-    // CPU_ZERO(&cpuset);
-    // CPU_SET(0, &cpuset);
-    // pthread_setaffinity_np(t_thread_acqrel.native_handle(), sizeof(cpu_set_t), &cpuset);
-    // device_pong_kernel_acqrel_decoupled<<<1,1>>>(flag_thread_acqrel);
-    // t_thread_acqrel.join();
-    // cudaDeviceSynchronize();
-
-    // std::cout << "Host-PING Device-PONG (Thread, Acq-Rel, CPU-CAS GPU-Decoupled) | Host : " << ((double) (cpu_time_thread_acqrel / 10000)) / ((double) get_cpu_freq() / 1000.) * 1000000. << std::endl;
-
-    cuda::atomic<uint16_t, cuda::thread_scope_thread> *flag_relaxed_thread;
-    cuda::atomic<uint16_t, cuda::thread_scope_device> *flag_relaxed_device;
-    cuda::atomic<uint16_t, cuda::thread_scope_system> *flag_relaxed_system;
-
-    if (allocator == CUDA_MALLOC_HOST) {
-        cudaMallocHost(&flag_relaxed_thread, sizeof(cuda::atomic<uint16_t, cuda::thread_scope_thread>));
-        cudaMallocHost(&flag_relaxed_device, sizeof(cuda::atomic<uint16_t, cuda::thread_scope_device>));
-        cudaMallocHost(&flag_relaxed_system, sizeof(cuda::atomic<uint16_t, cuda::thread_scope_system>));
-    } else if (allocator == MALLOC) {
-        flag_relaxed_thread = (cuda::atomic<uint16_t, cuda::thread_scope_thread> *) malloc(sizeof(cuda::atomic<uint16_t, cuda::thread_scope_thread>));
-        flag_relaxed_device = (cuda::atomic<uint16_t, cuda::thread_scope_device> *) malloc(sizeof(cuda::atomic<uint16_t, cuda::thread_scope_device>));
-        flag_relaxed_system = (cuda::atomic<uint16_t, cuda::thread_scope_system> *) malloc(sizeof(cuda::atomic<uint16_t, cuda::thread_scope_system>));
-    } else if (allocator == UM) {
-        cudaMallocManaged(&flag_relaxed_thread, sizeof(cuda::atomic<uint16_t, cuda::thread_scope_thread>));
-        cudaMallocManaged(&flag_relaxed_device, sizeof(cuda::atomic<uint16_t, cuda::thread_scope_device>));
-        cudaMallocManaged(&flag_relaxed_system, sizeof(cuda::atomic<uint16_t, cuda::thread_scope_system>));
-    }
-
-    uint64_t cpu_time_relaxed_system;
-
-    std::thread t_system_relaxed(host_ping_function_relaxed_decoupled, (std::atomic<uint16_t> *) flag_relaxed_system, &cpu_time_relaxed_system);
-    CPU_ZERO(&cpuset);
-    CPU_SET(0, &cpuset);
-    pthread_setaffinity_np(t_system_relaxed.native_handle(), sizeof(cpu_set_t), &cpuset);
-    device_pong_kernel_relaxed_base<<<1,1>>>(flag_relaxed_system);
-    t_system_relaxed.join();
-    cudaDeviceSynchronize();
+void report_one_way(const std::string &experiment, Arena &arena, const uint64_t *ping_arrivals, double ping_ns_per_tick, const uint64_t *pong_arrivals, double pong_ns_per_tick, const ClockSync &sync) {
+    std::vector<uint64_t> ping(TRACE_EVENTS), pong(TRACE_EVENTS);
+    arena.read(ping_arrivals, TRACE_EVENTS, ping.data());
+    arena.read(pong_arrivals, TRACE_EVENTS, pong.data());
 
-    std::cout << "Host-PING Device-PONG (System, Relaxed, CPU-Decoupled GPU-CAS) | Host : " << ((double) (cpu_time_relaxed_system / 10000)) / ((double) get_cpu_freq() / 1000.) * 1000000. << std::endl;
+    OneWayLatency latency = one_way_latency(ping, ping_ns_per_tick, pong, pong_ns_per_tick, sync);
+    report_result(experiment, {{"Ping->Pong", latency.ping_to_pong_ns}, {"Pong->Ping", latency.pong_to_ping_ns}, {"Error", sync.error_ns}, {"Drift ppm", sync.drift * 1000000., DESCRIPTIVE}});
+}
 
-    uint64_t cpu_time_relaxed_device;
-    std::thread t_device_relaxed(host_ping_function_relaxed_decoupled, (std::atomic<uint16_t> *) flag_relaxed_device, &cpu_time_relaxed_device);
-    CPU_ZERO(&cpuset);
-    CPU_SET(0, &cpuset);
-    pthread_setaffinity_np(t_device_relaxed.native_handle(), sizeof(cpu_set_t), &cpuset);
-    device_pong_kernel_relaxed_base<<<1,1>>>(flag_relaxed_device);
-    t_device_relaxed.join();
-    cudaDeviceSynchronize();
+void host_host_one_way_cell(Arena &arena) {
+    std::string experiment = "Host-PING Host-PONG (One-Way)";
+    if (!select_cell(experiment, {nullptr, order_name(ACQ_REL), "One-Way"})) return;
 
-    std::cout << "Host-PING Device-PONG (Device, Relaxed, CPU-Decoupled GPU-CAS) | Host : " << ((double) (cpu_time_relaxed_device / 10000)) / ((double) get_cpu_freq() / 1000.) * 1000000. << std::endl;
-
-    // uint64_t cpu_time_relaxed_thread;
-    // std::thread t_thread_relaxed(host_ping_function_relaxed_decoupled, (std::atomic<uint16_t> *) flag_relaxed_thread, &cpu_time_relaxed_thread);
-    // CPU_ZERO(&cpuset);
-    // CPU_SET(0, &cpuset);
-    // pthread_setaffinity_np(t_thread_relaxed.native_handle(), sizeof(cpu_set_t), &cpuset);
-    // device_pong_kernel_relaxed_base<<<1,1>>>(flag_relaxed_thread);
-    // t_thread_relaxed.join();
-    // cudaDeviceSynchronize();
-
-    // std::cout << "Host-PING Device-PONG (Thread, Relaxed, CPU-Decoupled GPU-CAS) | Host : " << ((double) (cpu_time_relaxed_thread / 10000)) / ((double) get_cpu_freq() / 1000.) * 1000000. << std::endl;
-
-    cuda::atomic<uint16_t, cuda::thread_scope_thread> *flag_acqrel_thread;
-    cuda::atomic<uint16_t, cuda::thread_scope_device> *flag_acqrel_device;
-    cuda::atomic<uint16_t, cuda::thread_scope_system> *flag_acqrel_system;
-
-    if (allocator == CUDA_MALLOC_HOST) {
-        cudaMallocHost(&flag_acqrel_thread, sizeof(cuda::atomic<uint16_t, cuda::thread_scope_thread>));
-        cudaMallocHost(&flag_acqrel_device, sizeof(cuda::atomic<uint16_t, cuda::thread_scope_device>));
-        cudaMallocHost(&flag_acqrel_system, sizeof(cuda::atomic<uint16_t, cuda::thread_scope_system>));
-    } else if (allocator == MALLOC) {
-        flag_acqrel_thread = (cuda::atomic<uint16_t, cuda::thread_scope_thread> *) malloc(sizeof(cuda::atomic<uint16_t, cuda::thread_scope_thread>));
-        flag_acqrel_device = (cuda::atomic<uint16_t, cuda::thread_scope_device> *) malloc(sizeof(cuda::atomic<uint16_t, cuda::thread_scope_device>));
-        flag_acqrel_system = (cuda::atomic<uint16_t, cuda::thread_scope_system> *) malloc(sizeof(cuda::atomic<uint16_t, cuda::thread_scope_system>));
-    } else if (allocator == UM) {
-        cudaMallocManaged(&flag_acqrel_thread, sizeof(cuda::atomic<uint16_t, cuda::thread_scope_thread>));
-        cudaMallocManaged(&flag_acqrel_device, sizeof(cuda::atomic<uint16_t, cuda::thread_scope_device>));
-        cudaMallocManaged(&flag_acqrel_system, sizeof(cuda::atomic<uint16_t, cuda::thread_scope_system>));
-    }
-
-    uint64_t cpu_time_acqrel_system;
-
-    std::thread t_acqrel_system(host_ping_function_acqrel_decoupled, (std::atomic<uint16_t> *) flag_acqrel_system, &cpu_time_acqrel_system);
-    CPU_ZERO(&cpuset);
-    CPU_SET(0, &cpuset);
-    pthread_setaffinity_np(t_acqrel_system.native_handle(), sizeof(cpu_set_t), &cpuset);
-    device_pong_kernel_acqrel_base<<<1,1>>>(flag_acqrel_system);
-    t_acqrel_system.join();
-    cudaDeviceSynchronize();
+    arena.reset();
+    ClockOffset before = host_host_clock_offset(arena);
 
-    std::cout << "Host-PING Device-PONG (System, Acq-Rel, CPU-Decoupled GPU-CAS) | Host : " << ((double) (cpu_time_acqrel_system / 10000)) / ((double) get_cpu_freq() / 1000.) * 1000000. << std::endl;
+    uint32_t *flag = arena.slot<uint32_t>();
+    uint64_t *message = arena.slot<uint64_t>(2);
+    uint64_t *ping_arrivals = arena.slot<uint64_t>(TRACE_EVENTS);
+    uint64_t *pong_arrivals = arena.slot<uint64_t>(TRACE_EVENTS);
 
-    uint64_t cpu_time_acqrel_device;
-    std::thread t_acqrel_device(host_ping_function_acqrel_decoupled, (std::atomic<uint16_t> *) flag_acqrel_device, &cpu_time_acqrel_device);
-    CPU_ZERO(&cpuset);
-    CPU_SET(0, &cpuset);
-    pthread_setaffinity_np(t_acqrel_device.native_handle(), sizeof(cpu_set_t), &cpuset);
-    device_pong_kernel_acqrel_base<<<1,1>>>(flag_acqrel_device);
-    t_acqrel_device.join();
-    cudaDeviceSynchronize();
+    std::thread t_ping = pinned_thread(core_pair().first, host_ping_one_way_function, flag, message, ping_arrivals);
+    std::thread t_pong = pinned_thread(core_pair().second, host_pong_one_way_function, flag, message, pong_arrivals);
+    t_ping.join();
+    t_pong.join();
 
-    std::cout << "Host-PING Device-PONG (Device, Acq-Rel, CPU-Decoupled GPU-CAS) | Host : " << ((double) (cpu_time_acqrel_device / 10000)) / ((double) get_cpu_freq() / 1000.) * 1000000. << std::endl;
-
-    // uint64_t cpu_time_acqrel_thread;
-
-    // std::thread t_acqrel_thread(host_ping_function_acqrel_decoupled, (std::atomic<uint16_t> *) flag_acqrel_thread, &cpu_time_acqrel_thread);
-    // CPU_ZERO(&cpuset);
-    // CPU_SET(0, &cpuset);
-    // pthread_setaffinity_np(t_acqrel_thread.native_handle(), sizeof(cpu_set_t), &cpuset);
-    // device_pong_kernel_acqrel_base<<<1,1>>>(flag_acqrel_thread);
-    // t_acqrel_thread.join();
-    // cudaDeviceSynchronize();
-
-    // std::cout << "Host-PING Device-PONG (Thread, Acq-Rel, CPU-Decoupled GPU-CAS) | Host : " << ((double) (cpu_time_acqrel_thread / 10000)) / ((double) get_cpu_freq() / 1000.) * 1000000. << std::endl;
-
-    if (allocator == MALLOC) {
-        free(flag_thread_relaxed);
-        free(flag_device_relaxed);
-        free(flag_system_relaxed);
-
-        free(flag_thread_acqrel);
-        free(flag_device_acqrel);
-        free(flag_system_acqrel);
-
-        free(flag_relaxed_thread);
-        free(flag_relaxed_device);
-        free(flag_relaxed_system);
-
-        free(flag_acqrel_thread);
-        free(flag_acqrel_device);
-        free(flag_acqrel_system);
-    } else if (allocator == CUDA_MALLOC_HOST) {
-        cudaFreeHost(flag_thread_relaxed);
-        cudaFreeHost(flag_device_relaxed);
-        cudaFreeHost(flag_system_relaxed);
-
-        cudaFreeHost(flag_thread_acqrel);
-        cudaFreeHost(flag_device_acqrel);
-        cudaFreeHost(flag_system_acqrel);
-
-        cudaFreeHost(flag_relaxed_thread);
-        cudaFreeHost(flag_relaxed_device);
-        cudaFreeHost(flag_relaxed_system);
-
-        cudaFreeHost(flag_acqrel_thread);
-        cudaFreeHost(flag_acqrel_device);
-        cudaFreeHost(flag_acqrel_system);
-    } else if (allocator == UM) {
-        cudaFree(flag_thread_relaxed);
-        cudaFree(flag_device_relaxed);
-        cudaFree(flag_system_relaxed);
-
-        cudaFree(flag_thread_acqrel);
-        cudaFree(flag_device_acqrel);
-        cudaFree(flag_system_acqrel);
-
-        cudaFree(flag_relaxed_thread);
-        cudaFree(flag_relaxed_device);
-        cudaFree(flag_relaxed_system);
-
-        cudaFree(flag_acqrel_thread);
-        cudaFree(flag_acqrel_device);
-        cudaFree(flag_acqrel_system);
-    }
-}
-
-void device_ping_host_pong_assymetric(Allocator allocator) {
-    cuda::atomic<uint16_t, cuda::thread_scope_thread> *flag_thread_relaxed;
-    cuda::atomic<uint16_t, cuda::thread_scope_device> *flag_device_relaxed;
-    cuda::atomic<uint16_t, cuda::thread_scope_system> *flag_system_relaxed;
-
-    if (allocator == CUDA_MALLOC_HOST) {
-        cudaMallocHost(&flag_thread_relaxed, sizeof(cuda::atomic<uint16_t, cuda::thread_scope_thread>));
-        cudaMallocHost(&flag_device_relaxed, sizeof(cuda::atomic<uint16_t, cuda::thread_scope_device>));
-        cudaMallocHost(&flag_system_relaxed, sizeof(cuda::atomic<uint16_t, cuda::thread_scope_system>));
-    } else if (allocator == MALLOC) {
-        flag_thread_relaxed = (cuda::atomic<uint16_t, cuda::thread_scope_thread> *) malloc(sizeof(cuda::atomic<uint16_t, cuda::thread_scope_thread>));
-        flag_device_relaxed = (cuda::atomic<uint16_t, cuda::thread_scope_device> *) malloc(sizeof(cuda::atomic<uint16_t, cuda::thread_scope_device>));
-        flag_system_relaxed = (cuda::atomic<uint16_t, cuda::thread_scope_system> *) malloc(sizeof(cuda::atomic<uint16_t, cuda::thread_scope_system>));
-    } else if (allocator == UM) {
-        cudaMallocManaged(&flag_thread_relaxed, sizeof(cuda::atomic<uint16_t, cuda::thread_scope_thread>));
-        cudaMallocManaged(&flag_device_relaxed, sizeof(cuda::atomic<uint16_t, cuda::thread_scope_device>));
-        cudaMallocManaged(&flag_system_relaxed, sizeof(cuda::atomic<uint16_t, cuda::thread_scope_system>));
-    }
-
-    cpu_set_t cpuset;
-
-    std::thread t_system(host_pong_function_relaxed_base, (std::atomic<uint16_t> *) flag_system_relaxed);
-    CPU_ZERO(&cpuset);
-    CPU_SET(0, &cpuset);
-    pthread_setaffinity_np(t_system.native_handle(), sizeof(cpu_set_t), &cpuset);
-
-    clock_t time_system_relaxed;
-    device_ping_kernel_relaxed_decoupled<<<1,1>>>(flag_system_relaxed, &time_system_relaxed);
-
-    t_system.join();
-    cudaDeviceSynchronize();
+    ClockOffset after = host_host_clock_offset(arena);
 
-    std::cout << "Device-PING Host-PONG (System, Relaxed, CPU-CAS GPU-Decoupled) | Device : " << ((double) (time_system_relaxed / 10000)) / ((double) get_gpu_freq()) * 1000000. << std::endl;
+    report_one_way(experiment, arena, ping_arrivals, host_ns_per_tick(), pong_arrivals, host_ns_per_tick(), combine_clock_offsets(before, after));
+}
 
+template <cuda::thread_scope Scope>
+void host_device_one_way_cell(Arena &arena) {
+    std::string experiment = std::string("Host-PING Device-PONG (") + scope_name(Scope) + ", One-Way)";
+    if (!select_cell(experiment, {scope_name(Scope), order_name(ACQ_REL), "One-Way"})) return;
 
-    std::thread t_device(host_pong_function_relaxed_base, (std::atomic<uint16_t> *) flag_device_relaxed);
-    CPU_ZERO(&cpuset);
-    CPU_SET(0, &cpuset);
-    pthread_setaffinity_np(t_device.native_handle(), sizeof(cpu_set_t), &cpuset);
+    arena.reset();
+    ClockOffset before = host_device_clock_offset<Scope>(arena);
 
-    clock_t time_device_relaxed;
-    device_ping_kernel_relaxed_decoupled<<<1,1>>>(flag_device_relaxed, &time_device_relaxed);
+    uint32_t *flag = arena.slot<uint32_t>();
+    uint64_t *message = arena.slot<uint64_t>(2);
+    uint64_t *ping_arrivals = arena.slot<uint64_t>(TRACE_EVENTS);
+    uint64_t *pong_arrivals = arena.slot<uint64_t>(TRACE_EVENTS);
 
-    t_device.join();
+    std::thread t = pinned_thread(core_pair().first, host_ping_one_way_function, flag, message, ping_arrivals);
+    device_pong_one_way_kernel<Scope><<<1,1>>>(flag, message, pong_arrivals);
+    t.join();
     cudaDeviceSynchronize();
 
-    std::cout << "Device-PING Host-PONG (Device, Relaxed, CPU-CAS GPU-Decoupled) | Device : " << ((double) (time_device_relaxed / 10000)) / ((double) get_gpu_freq()) * 1000000. << std::endl;
-
-
-    // std::thread t_thread(host_pong_function_relaxed_base, (std::atomic<uint16_t> *) flag_thread_relaxed);
-    // CPU_ZERO(&cpuset);
-    // CPU_SET(0, &cpuset);
-    // pthread_setaffinity_np(t_thread.native_handle(), sizeof(cpu_set_t), &cpuset);
-
-    // clock_t time_thread_relaxed;
-    // device_ping_kernel_relaxed_decoupled<<<1,1>>>(flag_thread_relaxed, &time_thread_relaxed);
+    ClockOffset after = host_device_clock_offset<Scope>(arena);
 
-    // t_thread.join();
-    // cudaDeviceSynchronize();
-
-    // std::cout << "Device-PING Host-PONG (Thread, Relaxed, CPU-CAS GPU-Decoupled) | Device : " << ((double) (time_thread_relaxed / 10000)) / ((double) get_gpu_freq()) * 1000000. << std::endl;
-
-    cuda::atomic<uint16_t, cuda::thread_scope_thread> *flag_thread_acqrel;
-    cuda::atomic<uint16_t, cuda::thread_scope_device> *flag_device_acqrel;
-    cuda::atomic<uint16_t, cuda::thread_scope_system> *flag_system_acqrel;
-
-    if (allocator == CUDA_MALLOC_HOST) {
-        cudaMallocHost(&flag_thread_acqrel, sizeof(cuda::atomic<uint16_t, cuda::thread_scope_thread>));
-        cudaMallocHost(&flag_device_acqrel, sizeof(cuda::atomic<uint16_t, cuda::thread_scope_device>));
-        cudaMallocHost(&flag_system_acqrel, sizeof(cuda::atomic<uint16_t, cuda::thread_scope_system>));
-    } else if (allocator == MALLOC) {
-        flag_thread_acqrel = (cuda::atomic<uint16_t, cuda::thread_scope_thread> *) malloc(sizeof(cuda::atomic<uint16_t, cuda::thread_scope_thread>));
-        flag_device_acqrel = (cuda::atomic<uint16_t, cuda::thread_scope_device> *) malloc(sizeof(cuda::atomic<uint16_t, cuda::thread_scope_device>));
-        flag_system_acqrel = (cuda::atomic<uint16_t, cuda::thread_scope_system> *) malloc(sizeof(cuda::atomic<uint16_t, cuda::thread_scope_system>));
-    } else if (allocator == UM) {
-        cudaMallocManaged(&flag_thread_acqrel, sizeof(cuda::atomic<uint16_t, cuda::thread_scope_thread>));
-        cudaMallocManaged(&flag_device_acqrel, sizeof(cuda::atomic<uint16_t, cuda::thread_scope_device>));
-        cudaMallocManaged(&flag_system_acqrel, sizeof(cuda::atomic<uint16_t, cuda::thread_scope_system>));
-    }
+    report_one_way(experiment, arena, ping_arrivals, host_ns_per_tick(), pong_arrivals, device_ns_per_tick(), combine_clock_offsets(before, after));
+}
 
-    std::thread t_system_acqrel(host_pong_function_acqrel_base, (std::atomic<uint16_t> *) flag_system_acqrel);
-    CPU_ZERO(&cpuset);
-    CPU_SET(0, &cpuset);
-    pthread_setaffinity_np(t_system_acqrel.native_handle(), sizeof(cpu_set_t), &cpuset);
+void device_device_fetch_add(Arena &arena) {
+    device_device_fetch_add_cell<cuda::thread_scope_system, RELAXED>(arena);
+    device_device_fetch_add_cell<cuda::thread_scope_device, RELAXED>(arena);
+    device_device_fetch_add_cell<cuda::thread_scope_thread, RELAXED>(arena);
 
-    clock_t time_system_acqrel;
-    device_ping_kernel_acqrel_decoupled<<<1,1>>>(flag_system_acqrel, &time_system_acqrel);
+    device_device_fetch_add_cell<cuda::thread_scope_system, ACQ_REL>(arena);
+    device_device_fetch_add_cell<cuda::thread_scope_device, ACQ_REL>(arena);
+    device_device_fetch_add_cell<cuda::thread_scope_thread, ACQ_REL>(arena);
 
-    t_system_acqrel.join();
-    cudaDeviceSynchronize();
+    device_device_fetch_add_cell<cuda::thread_scope_system, SEQ_CST>(arena);
+    device_device_fetch_add_cell<cuda::thread_scope_device, SEQ_CST>(arena);
+    device_device_fetch_add_cell<cuda::thread_scope_thread, SEQ_CST>(arena);
+}
 
-    std::cout << "Device-PING Host-PONG (System, Acq-Rel, CPU-CAS GPU-Decoupled) | Device : " << ((double) (time_system_acqrel / 10000)) / ((double) get_gpu_freq()) * 1000000. << std::endl;
+void host_device_fetch_add(Arena &arena) {
+    host_device_fetch_add_cell<cuda::thread_scope_system, RELAXED>(arena);
+    host_device_fetch_add_cell<cuda::thread_scope_device, RELAXED>(arena);
+    host_device_fetch_add_cell<cuda::thread_scope_thread, RELAXED>(arena);
 
-    std::thread t_device_acqrel(host_pong_function_acqrel_base, (std::atomic<uint16_t> *) flag_device_acqrel);
-    CPU_ZERO(&cpuset);
-    CPU_SET(0, &cpuset);
-    pthread_setaffinity_np(t_device_acqrel.native_handle(), sizeof(cpu_set_t), &cpuset);
+    host_device_fetch_add_cell<cuda::thread_scope_system, ACQ_REL>(arena);
+    host_device_fetch_add_cell<cuda::thread_scope_device, ACQ_REL>(arena);
+    host_device_fetch_add_cell<cuda::thread_scope_thread, ACQ_REL>(arena);
 
-    clock_t time_device_acqrel;
-    device_ping_kernel_acqrel_decoupled<<<1,1>>>(flag_device_acqrel, &time_device_acqrel);
+    host_device_fetch_add_cell<cuda::thread_scope_system, SEQ_CST>(arena);
+    host_device_fetch_add_cell<cuda::thread_scope_device, SEQ_CST>(arena);
+    host_device_fetch_add_cell<cuda::thread_scope_thread, SEQ_CST>(arena);
+}
 
-    t_device_acqrel.join();
-    cudaDeviceSynchronize();
+void host_ping_device_pong_assymetric(Arena &arena) {
+    host_ping_device_pong_cell<cuda::thread_scope_system, RELAXED, BASE, DECOUPLED>(arena);
+    host_ping_device_pong_cell<cuda::thread_scope_device, RELAXED, BASE, DECOUPLED>(arena);
+    // host_ping_device_pong_cell<cuda::thread_scope_thread, RELAXED, BASE, DECOUPLED>(arena);
 
-    std::cout << "Device-PING Host-PONG (Device, Acq-Rel, CPU-CAS GPU-Decoupled) | Device : " << ((double) (time_device_acqrel / 10000)) / ((double) get_gpu_freq()) * 1000000. << std::endl;
+    host_ping_device_pong_cell<cuda::thread_scope_system, ACQ_REL, BASE, DECOUPLED>(arena);
+    host_ping_device_pong_cell<cuda::thread_scope_device, ACQ_REL, BASE, DECOUPLED>(arena);
+    // host_ping_device_pong_cell<cuda::thread_scope_thread, ACQ_REL, BASE, DECOUPLED>(arena);
 
+    host_ping_device_pong_cell<cuda::thread_scope_system, RELAXED, DECOUPLED, BASE>(arena);
+    host_ping_device_pong_cell<cuda::thread_scope_device, RELAXED, DECOUPLED, BASE>(arena);
+    // host_ping_device_pong_cell<cuda::thread_scope_thread, RELAXED, DECOUPLED, BASE>(arena);
 
-    // std::thread t_thread_acqrel(host_pong_function_acqrel_base, (std::atomic<uint16_t> *) flag_thread_acqrel);
-    // CPU_ZERO(&cpuset);
-    // CPU_SET(0, &cpuset);
-    // pthread_setaffinity_np(t_thread_acqrel.native_handle(), sizeof(cpu_set_t), &cpuset);
+    host_ping_device_pong_cell<cuda::thread_scope_system, ACQ_REL, DECOUPLED, BASE>(arena);
+    host_ping_device_pong_cell<cuda::thread_scope_device, ACQ_REL, DECOUPLED, BASE>(arena);
+    // host_ping_device_pong_cell<cuda::thread_scope_thread, ACQ_REL, DECOUPLED, BASE>(arena);
+}
 
-    // clock_t time_thread_acqrel;
-    // device_ping_kernel_acqrel_decoupled<<<1,1>>>(flag_thread_acqrel, &time_thread_acqrel);
+void device_ping_host_pong_assymetric(Arena &arena) {
+    device_ping_host_pong_cell<cuda::thread_scope_system, RELAXED, BASE, DECOUPLED>(arena);
+    device_ping_host_pong_cell<cuda::thread_scope_device, RELAXED, BASE, DECOUPLED>(arena);
+    // device_ping_host_pong_cell<cuda::thread_scope_thread, RELAXED, BASE, DECOUPLED>(arena);
 
-    // t_thread_acqrel.join();
-    // cudaDeviceSynchronize();
+    device_ping_host_pong_cell<cuda::thread_scope_system, ACQ_REL, BASE, DECOUPLED>(arena);
+    device_ping_host_pong_cell<cuda::thread_scope_device, ACQ_REL, BASE, DECOUPLED>(arena);
+    // device_ping_host_pong_cell<cuda::thread_scope_thread, ACQ_REL, BASE, DECOUPLED>(arena);
 
-    // std::cout << "Device-PING Host-PONG (Thread, Acq-Rel, CPU-CAS GPU-Decoupled) | Device : " << ((double) (time_thread_acqrel / 10000)) / ((double) get_gpu_freq()) * 1000000. << std::endl;
+    device_ping_host_pong_cell<cuda::thread_scope_system, RELAXED, DECOUPLED, BASE>(arena);
+    device_ping_host_pong_cell<cuda::thread_scope_device, RELAXED, DECOUPLED, BASE>(arena);
+    // device_ping_host_pong_cell<cuda::thread_scope_thread, RELAXED, DECOUPLED, BASE>(arena);
 
-    cuda::atomic<uint16_t, cuda::thread_scope_thread> *flag_relaxed_thread;
-    cuda::atomic<uint16_t, cuda::thread_scope_device> *flag_relaxed_device;
-    cuda::atomic<uint16_t, cuda::thread_scope_system> *flag_relaxed_system;
+    device_ping_host_pong_cell<cuda::thread_scope_system, ACQ_REL, DECOUPLED, BASE>(arena);
+    device_ping_host_pong_cell<cuda::thread_scope_device, ACQ_REL, DECOUPLED, BASE>(arena);
+    // device_ping_host_pong_cell<cuda::thread_scope_thread, ACQ_REL, DECOUPLED, BASE>(arena);
+}
 
-    if (allocator == CUDA_MALLOC_HOST) {
-        cudaMallocHost(&flag_relaxed_thread, sizeof(cuda::atomic<uint16_t, cuda::thread_scope_thread>));
-        cudaMallocHost(&flag_relaxed_device, sizeof(cuda::atomic<uint16_t, cuda::thread_scope_device>));
-        cudaMallocHost(&flag_relaxed_system, sizeof(cuda::atomic<uint16_t, cuda::thread_scope_system>));
-    } else if (allocator == MALLOC) {
-        flag_relaxed_thread = (cuda::atomic<uint16_t, cuda::thread_scope_thread> *) malloc(sizeof(cuda::atomic<uint16_t, cuda::thread_scope_thread>));
-        flag_relaxed_device = (cuda::atomic<uint16_t, cuda::thread_scope_device> *) malloc(sizeof(cuda::atomic<uint16_t, cuda::thread_scope_device>));
-        flag_relaxed_system = (cuda::atomic<uint16_t, cuda::thread_scope_system> *) malloc(sizeof(cuda::atomic<uint16_t, cuda::thread_scope_system>));
-    } else if (allocator == UM) {
-        cudaMallocManaged(&flag_relaxed_thread, sizeof(cuda::atomic<uint16_t, cuda::thread_scope_thread>));
-        cudaMallocManaged(&flag_relaxed_device, sizeof(cuda::atomic<uint16_t, cuda::thread_scope_device>));
-        cudaMallocManaged(&flag_relaxed_system, sizeof(cuda::atomic<uint16_t, cuda::thread_scope_system>));
-    }
+void host_ping_device_pong_base(Arena &arena) {
+    host_ping_device_pong_cell<cuda::thread_scope_system, RELAXED, BASE, BASE>(arena);
+    host_ping_device_pong_cell<cuda::thread_scope_device, RELAXED, BASE, BASE>(arena);
+    host_ping_device_pong_cell<cuda::thread_scope_thread, RELAXED, BASE, BASE>(arena);
 
-    std::thread t_system_relaxed(host_pong_function_relaxed_decoupled, (std::atomic<uint16_t> *) flag_relaxed_system);
-    CPU_ZERO(&cpuset);
-    CPU_SET(0, &cpuset);
-    pthread_setaffinity_np(t_system_relaxed.native_handle(), sizeof(cpu_set_t), &cpuset);
+    host_ping_device_pong_cell<cuda::thread_scope_system, ACQ_REL, BASE, BASE>(arena);
+    host_ping_device_pong_cell<cuda::thread_scope_device, ACQ_REL, BASE, BASE>(arena);
+    host_ping_device_pong_cell<cuda::thread_scope_thread, ACQ_REL, BASE, BASE>(arena);
+}
 
-    clock_t time_relaxed_system;
-    device_ping_kernel_relaxed_base<<<1,1>>>(flag_relaxed_system, &time_relaxed_system);
+void host_ping_device_pong_decoupled(Arena &arena) {
+    host_ping_device_pong_cell<cuda::thread_scope_system, RELAXED, DECOUPLED, DECOUPLED>(arena);
+    host_ping_device_pong_cell<cuda::thread_scope_device, RELAXED, DECOUPLED, DECOUPLED>(arena);
+    // host_ping_device_pong_cell<cuda::thread_scope_thread, RELAXED, DECOUPLED, DECOUPLED>(arena);
 
-    t_system_relaxed.join();
-    cudaDeviceSynchronize();
+    host_ping_device_pong_cell<cuda::thread_scope_system, ACQ_REL, DECOUPLED, DECOUPLED>(arena);
+    host_ping_device_pong_cell<cuda::thread_scope_device, ACQ_REL, DECOUPLED, DECOUPLED>(arena);
+    // host_ping_device_pong_cell<cuda::thread_scope_thread, ACQ_REL, DECOUPLED, DECOUPLED>(arena);
+}
 
-    std::cout << "Device-PING Host-PONG (System, Relaxed, CPU-Decoupled GPU-CAS) | Device : " << ((double) (time_relaxed_system / 10000)) / ((double) get_gpu_freq()) * 1000000. << std::endl;
+void device_ping_device_pong_decoupled(Arena &arena) {
+    // device_ping_device_pong_cell<cuda::thread_scope_system, ACQ_REL, DECOUPLED>(arena);
+    // device_ping_device_pong_cell<cuda::thread_scope_device, ACQ_REL, DECOUPLED>(arena);
+    // device_ping_device_pong_cell<cuda::thread_scope_thread, ACQ_REL, DECOUPLED>(arena);
 
+    device_ping_device_pong_cell<cuda::thread_scope_system, RELAXED, DECOUPLED>(arena);
+    device_ping_device_pong_cell<cuda::thread_scope_device, RELAXED, DECOUPLED>(arena);
+    // device_ping_device_pong_cell<cuda::thread_scope_thread, RELAXED, DECOUPLED>(arena);
+}
 
-    std::thread t_device_relaxed(host_pong_function_relaxed_decoupled, (std::atomic<uint16_t> *) flag_relaxed_device);
-    CPU_ZERO(&cpuset);
-    CPU_SET(0, &cpuset);
-    pthread_setaffinity_np(t_device_relaxed.native_handle(), sizeof(cpu_set_t), &cpuset);
+void device_ping_device_pong_base(Arena &arena) {
+    device_ping_device_pong_cell<cuda::thread_scope_system, RELAXED, BASE>(arena);
+    // device_ping_device_pong_cell<cuda::thread_scope_device, RELAXED, BASE>(arena);
+    // device_ping_device_pong_cell<cuda::thread_scope_thread, RELAXED, BASE>(arena);
 
-    clock_t time_relaxed_device;
-    device_ping_kernel_relaxed_base<<<1,1>>>(flag_relaxed_device, &time_relaxed_device);
+    // device_ping_device_pong_cell<cuda::thread_scope_system, ACQ_REL, BASE>(arena);
+    // device_ping_device_pong_cell<cuda::thread_scope_device, ACQ_REL, BASE>(arena);
+    // device_ping_device_pong_cell<cuda::thread_scope_thread, ACQ_REL, BASE>(arena);
+}
 
-    t_device_relaxed.join();
-    cudaDeviceSynchronize();
+void device_ping_host_pong_base(Arena &arena) {
+    device_ping_host_pong_cell<cuda::thread_scope_system, RELAXED, BASE, BASE>(arena);
+    device_ping_host_pong_cell<cuda::thread_scope_device, RELAXED, BASE, BASE>(arena);
+    device_ping_host_pong_cell<cuda::thread_scope_thread, RELAXED, BASE, BASE>(arena);
 
-    std::cout << "Device-PING Host-PONG (Device, Relaxed, CPU-Decoupled GPU-CAS) | Device : " << ((double) (time_relaxed_device / 10000)) / ((double) get_gpu_freq()) * 1000000. << std::endl;
+    device_ping_host_pong_cell<cuda::thread_scope_system, ACQ_REL, BASE, BASE>(arena);
+    device_ping_host_pong_cell<cuda::thread_scope_device, ACQ_REL, BASE, BASE>(arena);
+    device_ping_host_pong_cell<cuda::thread_scope_thread, ACQ_REL, BASE, BASE>(arena);
+}
 
+void device_ping_host_pong_decoupled(Arena &arena) {
+    device_ping_host_pong_cell<cuda::thread_scope_system, RELAXED, DECOUPLED, DECOUPLED>(arena);
+    device_ping_host_pong_cell<cuda::thread_scope_device, RELAXED, DECOUPLED, DECOUPLED>(arena);
+    // device_ping_host_pong_cell<cuda::thread_scope_thread, RELAXED, DECOUPLED, DECOUPLED>(arena);
 
-    // std::thread t_thread_relaxed(host_pong_function_relaxed_decoupled, (std::atomic<uint16_t> *) flag_relaxed_thread);
-    // CPU_ZERO(&cpuset);
-    // CPU_SET(0, &cpuset);
-    // pthread_setaffinity_np(t_thread_relaxed.native_handle(), sizeof(cpu_set_t), &cpuset);
+    device_ping_host_pong_cell<cuda::thread_scope_system, ACQ_REL, DECOUPLED, DECOUPLED>(arena);
+    device_ping_host_pong_cell<cuda::thread_scope_device, ACQ_REL, DECOUPLED, DECOUPLED>(arena);
+    // device_ping_host_pong_cell<cuda::thread_scope_thread, ACQ_REL, DECOUPLED, DECOUPLED>(arena);
+}
 
-    // clock_t time_relaxed_thread;
-    // device_ping_kernel_relaxed_base<<<1,1>>>(flag_relaxed_thread, &time_relaxed_thread);
-    
-    // t_thread_relaxed.join();
-    // cudaDeviceSynchronize();
+OpenLoopRing open_loop_ring(Arena &arena) {
+    OpenLoopRing ring;
+    ring.head = arena.slot<uint64_t>();
+    ring.done = arena.slot<uint64_t>();
+    ring.requests = arena.slot<uint64_t>(OPEN_LOOP_CAPACITY);
+    ring.responses = arena.slot<uint64_t>(OPEN_LOOP_CAPACITY);
+    ring.capacity = OPEN_LOOP_CAPACITY;
+    return ring;
+}
 
-    // std::cout << "Device-PING Host-PONG (Thread, Relaxed, CPU-Decoupled GPU-CAS) | Device : " << ((double) (time_relaxed_thread / 10000)) / ((double) get_gpu_freq()) * 1000000. << std::endl;
+std::string open_loop_label(const char *consumer, LoadSchedule schedule, double rate) {
+    return std::string("Open-Loop Host-Producer ") + consumer + " (" + schedule_name(schedule) + ", " + std::to_string((long long) rate) + "/s)";
+}
 
-    cuda::atomic<uint16_t, cuda::thread_scope_thread> *flag_acqrel_thread;
-    cuda::atomic<uint16_t, cuda::thread_scope_device> *flag_acqrel_device;
-    cuda::atomic<uint16_t, cuda::thread_scope_system> *flag_acqrel_system;
+void report_open_loop(const std::string &experiment, double rate, const std::vector<uint64_t> &latencies, uint64_t elapsed) {
+    double ns_per_tick = host_ns_per_tick();
 
-    if (allocator == CUDA_MALLOC_HOST) {
-        cudaMallocHost(&flag_acqrel_thread, sizeof(cuda::atomic<uint16_t, cuda::thread_scope_thread>));
-        cudaMallocHost(&flag_acqrel_device, sizeof(cuda::atomic<uint16_t, cuda::thread_scope_device>));
-        cudaMallocHost(&flag_acqrel_system, sizeof(cuda::atomic<uint16_t, cuda::thread_scope_system>));
-    } else if (allocator == MALLOC) {
-        flag_acqrel_thread = (cuda::atomic<uint16_t, cuda::thread_scope_thread> *) malloc(sizeof(cuda::atomic<uint16_t, cuda::thread_scope_thread>));
-        flag_acqrel_device = (cuda::atomic<uint16_t, cuda::thread_scope_device> *) malloc(sizeof(cuda::atomic<uint16_t, cuda::thread_scope_device>));
-        flag_acqrel_system = (cuda::atomic<uint16_t, cuda::thread_scope_system> *) malloc(sizeof(cuda::atomic<uint16_t, cuda::thread_scope_system>));
-    } else if (allocator == UM) {
-        cudaMallocManaged(&flag_acqrel_thread, sizeof(cuda::atomic<uint16_t, cuda::thread_scope_thread>));
-        cudaMallocManaged(&flag_acqrel_device, sizeof(cuda::atomic<uint16_t, cuda::thread_scope_device>));
-        cudaMallocManaged(&flag_acqrel_system, sizeof(cuda::atomic<uint16_t, cuda::thread_scope_system>));
+    std::vector<double> sorted;
+    for (uint64_t ticks : latencies) {
+        sorted.push_back((double) ticks * ns_per_tick);
     }
+    std::sort(sorted.begin(), sorted.end());
 
-    std::thread t_acqrel_system(host_pong_function_acqrel_decoupled, (std::atomic<uint16_t> *) flag_acqrel_system);
-    CPU_ZERO(&cpuset);
-    CPU_SET(0, &cpuset);
-    pthread_setaffinity_np(t_acqrel_system.native_handle(), sizeof(cpu_set_t), &cpuset);
-
-    clock_t time_acqrel_system;
-    device_ping_kernel_acqrel_base<<<1,1>>>(flag_acqrel_system, &time_acqrel_system);
-
-    t_acqrel_system.join();
-    cudaDeviceSynchronize();
-
-    std::cout << "Device-PING Host-PONG (System, Acq-Rel, CPU-Decoupled GPU-CAS) | Device : " << ((double) (time_acqrel_system / 10000)) / ((double) get_gpu_freq()) * 1000000. << std::endl;
-
-
-    std::thread t_acqrel_device(host_pong_function_acqrel_decoupled, (std::atomic<uint16_t> *) flag_acqrel_device);
-    CPU_ZERO(&cpuset);
-    CPU_SET(0, &cpuset);
-    pthread_setaffinity_np(t_acqrel_device.native_handle(), sizeof(cpu_set_t), &cpuset);
-
-    clock_t time_acqrel_device;
-    device_ping_kernel_acqrel_base<<<1,1>>>(flag_acqrel_device, &time_acqrel_device);
-
-    t_acqrel_device.join();
-    cudaDeviceSynchronize();
+    double achieved = (double) latencies.size() / ((double) elapsed * ns_per_tick / 1000000000.);
+    report_result(experiment, {{"Offered", rate, DESCRIPTIVE}, {"Achieved", achieved, HIGHER_IS_BETTER}, {"p50", percentile(sorted, 0.5)}, {"p99", percentile(sorted, 0.99)}, {"p99.9", percentile(sorted, 0.999)}, {"Max", sorted.back()}});
+}
 
-    std::cout << "Device-PING Host-PONG (Device, Acq-Rel, CPU-Decoupled GPU-CAS) | Device : " << ((double) (time_acqrel_device / 10000)) / ((double) get_gpu_freq()) * 1000000. << std::endl;
-
-
-    // std::thread t_acqrel_thread(host_pong_function_acqrel_decoupled, (std::atomic<uint16_t> *) flag_acqrel_thread);
-    // CPU_ZERO(&cpuset);
-    // CPU_SET(0, &cpuset);
-    // pthread_setaffinity_np(t_acqrel_thread.native_handle(), sizeof(cpu_set_t), &cpuset);
-
-    // clock_t time_acqrel_thread;
-    // device_ping_kernel_acqrel_base<<<1,1>>>(flag_acqrel_thread, &time_acqrel_thread);
-
-    // t_acqrel_thread.join();
-    // cudaDeviceSynchronize();
-
-    // std::cout << "Device-PING Host-PONG (Thread, Acq-Rel, CPU-Decoupled GPU-CAS) | Device : " << ((double) (time_acqrel_thread / 10000)) / ((double) get_gpu_freq()) * 1000000. << std::endl;
-
-    if (allocator == MALLOC) {
-        free(flag_thread_relaxed);
-        free(flag_device_relaxed);
-        free(flag_system_relaxed);
-
-        free(flag_thread_acqrel);
-        free(flag_device_acqrel);
-        free(flag_system_acqrel);
-
-        free(flag_relaxed_thread);
-        free(flag_relaxed_device);
-        free(flag_relaxed_system);
-
-        free(flag_acqrel_thread);
-        free(flag_acqrel_device);
-        free(flag_acqrel_system);
-    } else if (allocator == CUDA_MALLOC_HOST) {
-        cudaFreeHost(flag_thread_relaxed);
-        cudaFreeHost(flag_device_relaxed);
-        cudaFreeHost(flag_system_relaxed);
-
-        cudaFreeHost(flag_thread_acqrel);
-        cudaFreeHost(flag_device_acqrel);
-        cudaFreeHost(flag_system_acqrel);
-
-        cudaFreeHost(flag_relaxed_thread);
-        cudaFreeHost(flag_relaxed_device);
-        cudaFreeHost(flag_relaxed_system);
-
-        cudaFreeHost(flag_acqrel_thread);
-        cudaFreeHost(flag_acqrel_device);
-        cudaFreeHost(flag_acqrel_system);
-    } else if (allocator == UM) {
-        cudaFree(flag_thread_relaxed);
-        cudaFree(flag_device_relaxed);
-        cudaFree(flag_system_relaxed);
-
-        cudaFree(flag_thread_acqrel);
-        cudaFree(flag_device_acqrel);
-        cudaFree(flag_system_acqrel);
-
-        cudaFree(flag_relaxed_thread);
-        cudaFree(flag_relaxed_device);
-        cudaFree(flag_relaxed_system);
-
-        cudaFree(flag_acqrel_thread);
-        cudaFree(flag_acqrel_device);
-        cudaFree(flag_acqrel_system);
-    }
-}
-
-void host_ping_device_pong_base(Allocator allocator) {
-    cuda::atomic<uint16_t, cuda::thread_scope_thread> *flag_thread_relaxed;
-    cuda::atomic<uint16_t, cuda::thread_scope_device> *flag_device_relaxed;
-    cuda::atomic<uint16_t, cuda::thread_scope_system> *flag_system_relaxed;
-
-    if (allocator == CUDA_MALLOC_HOST) {
-        cudaMallocHost(&flag_thread_relaxed, sizeof(cuda::atomic<uint16_t, cuda::thread_scope_thread>));
-        cudaMallocHost(&flag_device_relaxed, sizeof(cuda::atomic<uint16_t, cuda::thread_scope_device>));
-        cudaMallocHost(&flag_system_relaxed, sizeof(cuda::atomic<uint16_t, cuda::thread_scope_system>));
-    } else if (allocator == MALLOC) {
-        flag_thread_relaxed = (cuda::atomic<uint16_t, cuda::thread_scope_thread> *) malloc(sizeof(cuda::atomic<uint16_t, cuda::thread_scope_thread>));
-        flag_device_relaxed = (cuda::atomic<uint16_t, cuda::thread_scope_device> *) malloc(sizeof(cuda::atomic<uint16_t, cuda::thread_scope_device>));
-        flag_system_relaxed = (cuda::atomic<uint16_t, cuda::thread_scope_system> *) malloc(sizeof(cuda::atomic<uint16_t, cuda::thread_scope_system>));
-    } else if (allocator == UM) {
-        cudaMallocManaged(&flag_thread_relaxed, sizeof(cuda::atomic<uint16_t, cuda::thread_scope_thread>));
-        cudaMallocManaged(&flag_device_relaxed, sizeof(cuda::atomic<uint16_t, cuda::thread_scope_device>));
-        cudaMallocManaged(&flag_system_relaxed, sizeof(cuda::atomic<uint16_t, cuda::thread_scope_system>));
-    } 
-
-    cpu_set_t cpuset;
-    
-    uint64_t cpu_time_system;
-    std::thread t_system(host_ping_function_relaxed_base, (std::atomic<uint16_t> *) flag_system_relaxed, &cpu_time_system);
-    CPU_ZERO(&cpuset);
-    CPU_SET(0, &cpuset);
-    pthread_setaffinity_np(t_system.native_handle(), sizeof(cpu_set_t), &cpuset);
-    device_pong_kernel_relaxed_base<<<1,1>>>(flag_system_relaxed);
-    t_system.join();
-    cudaDeviceSynchronize();
+void host_producer_host_consumer_cell(Arena &arena, LoadSchedule schedule, double rate) {
+    std::string experiment = open_loop_label("Host-Consumer", schedule, rate);
+    if (!select_cell(experiment, {nullptr, order_name(ACQ_REL), "Open-Loop"})) return;
 
-    std::cout << "Host-PING Device-PONG (System, Relaxed) | Host : " << ((double) (cpu_time_system / 10000)) / ((double) get_cpu_freq() / 1000.) * 1000000. << std::endl;
+    arena.reset();
+    OpenLoopRing ring = open_loop_ring(arena);
+    std::vector<uint64_t> intended = load_schedule(schedule, rate, OPEN_LOOP_MESSAGES);
 
+    std::vector<uint64_t> latencies;
+    uint64_t elapsed;
+    std::thread t_producer = pinned_thread(core_pair().first, open_loop_producer, ring, std::cref(intended), &latencies, &elapsed);
+    std::thread t_consumer = pinned_thread(core_pair().second, host_open_loop_consumer_function, ring.head, ring.done, ring.requests, ring.responses, ring.capacity, OPEN_LOOP_MESSAGES);
+    t_producer.join();
+    t_consumer.join();
 
-    uint64_t cpu_time_device;
-    std::thread t_device(host_ping_function_relaxed_base, (std::atomic<uint16_t> *) flag_device_relaxed, &cpu_time_device);
-    CPU_ZERO(&cpuset);
-    CPU_SET(0, &cpuset);
-    pthread_setaffinity_np(t_device.native_handle(), sizeof(cpu_set_t), &cpuset);
-    device_pong_kernel_relaxed_base<<<1,1>>>(flag_device_relaxed);
-    t_device.join();
-    cudaDeviceSynchronize();
+    report_open_loop(experiment, rate, latencies, elapsed);
+}
 
-    std::cout << "Host-PING Device-PONG (Device, Relaxed) | Host : " << ((double) (cpu_time_device / 10000)) / ((double) get_cpu_freq() / 1000.) * 1000000. << std::endl;
+template <cuda::thread_scope Scope>
+void host_producer_device_consumer_cell(Arena &arena, LoadSchedule schedule, double rate) {
+    std::string experiment = open_loop_label("Device-Consumer", schedule, rate);
+    if (!select_cell(experiment, {scope_name(Scope), order_name(ACQ_REL), "Open-Loop"})) return;
 
+    arena.reset();
+    OpenLoopRing ring = open_loop_ring(arena);
+    std::vector<uint64_t> intended = load_schedule(schedule, rate, OPEN_LOOP_MESSAGES);
 
-    uint64_t cpu_time_thread;
-    std::thread t_thread(host_ping_function_relaxed_base, (std::atomic<uint16_t> *) flag_thread_relaxed, &cpu_time_thread);
-    CPU_ZERO(&cpuset);
-    CPU_SET(0, &cpuset);
-    pthread_setaffinity_np(t_thread.native_handle(), sizeof(cpu_set_t), &cpuset);
-    device_pong_kernel_relaxed_base<<<1,1>>>(flag_thread_relaxed);
-    t_thread.join();
+    std::vector<uint64_t> latencies;
+    uint64_t elapsed;
+    std::thread t = pinned_thread(core_pair().first, open_loop_producer, ring, std::cref(intended), &latencies, &elapsed);
+    device_open_loop_consumer_kernel<Scope><<<1,1>>>(ring.head, ring.done, ring.requests, ring.responses, ring.capacity, OPEN_LOOP_MESSAGES);
+    t.join();
     cudaDeviceSynchronize();
 
-    std::cout << "Host-PING Device-PONG (Thread, Relaxed) | Host : " << ((double) (cpu_time_thread / 10000)) / ((double) get_cpu_freq() / 1000.) * 1000000. << std::endl;
-    
-    cuda::atomic<uint16_t, cuda::thread_scope_thread> *flag_thread_acqrel;
-    cuda::atomic<uint16_t, cuda::thread_scope_device> *flag_device_acqrel;
-    cuda::atomic<uint16_t, cuda::thread_scope_system> *flag_system_acqrel;
-
-    if (allocator == CUDA_MALLOC_HOST) {
-        cudaMallocHost(&flag_thread_acqrel, sizeof(cuda::atomic<uint16_t, cuda::thread_scope_thread>));
-        cudaMallocHost(&flag_device_acqrel, sizeof(cuda::atomic<uint16_t, cuda::thread_scope_device>));
-        cudaMallocHost(&flag_system_acqrel, sizeof(cuda::atomic<uint16_t, cuda::thread_scope_system>));
-    } else if (allocator == MALLOC) {
-        flag_thread_acqrel = (cuda::atomic<uint16_t, cuda::thread_scope_thread> *) malloc(sizeof(cuda::atomic<uint16_t, cuda::thread_scope_thread>));
-        flag_device_acqrel = (cuda::atomic<uint16_t, cuda::thread_scope_device> *) malloc(sizeof(cuda::atomic<uint16_t, cuda::thread_scope_device>));
-        flag_system_acqrel = (cuda::atomic<uint16_t, cuda::thread_scope_system> *) malloc(sizeof(cuda::atomic<uint16_t, cuda::thread_scope_system>));
-    } else if (allocator == UM) {
-        cudaMallocManaged(&flag_thread_acqrel, sizeof(cuda::atomic<uint16_t, cuda::thread_scope_thread>));
-        cudaMallocManaged(&flag_device_acqrel, sizeof(cuda::atomic<uint16_t, cuda::thread_scope_device>));
-        cudaMallocManaged(&flag_system_acqrel, sizeof(cuda::atomic<uint16_t, cuda::thread_scope_system>));
-    }
-
-    uint64_t cpu_time_system_acqrel;
-    std::thread t_system_acqrel(host_ping_function_acqrel_base, (std::atomic<uint16_t> *) flag_system_acqrel, &cpu_time_system_acqrel);
-    CPU_ZERO(&cpuset);
-    CPU_SET(0, &cpuset);
-    pthread_setaffinity_np(t_system_acqrel.native_handle(), sizeof(cpu_set_t), &cpuset);
-    device_pong_kernel_acqrel_base<<<1,1>>>(flag_system_acqrel);
-    t_system_acqrel.join();
-    cudaDeviceSynchronize();
+    report_open_loop(experiment, rate, latencies, elapsed);
+}
 
-    std::cout << "Host-PING Device-PONG (System, Acq-Rel) | Host : " << ((double) (cpu_time_system_acqrel / 10000)) / ((double) get_cpu_freq() / 1000.) * 1000000. << std::endl;
+// every round trip of a host/host decoupled ping/pong, ascending, from ping's receive stamps
+std::vector<double> host_host_round_trips(Arena &arena) {
+    arena.reset();
+    uint32_t *flag = arena.slot<uint32_t>();
+    uint64_t *ping_trace = arena.slot<uint64_t>(TRACE_EVENTS);
+
+    uint64_t cpu_time;
+    std::thread t_ping = pinned_thread(core_pair().first, host_ping_function<ACQ_REL, DECOUPLED>, flag, &cpu_time, ping_trace, PINGPONG_ITERATIONS);
+    std::thread t_pong = pinned_thread(core_pair().second, host_pong_function<ACQ_REL, DECOUPLED>, flag, nullptr, PINGPONG_ITERATIONS);
+    t_ping.join();
+    t_pong.join();
+
+    AgentTrace ping = read_trace(arena, ping_trace, "Host-PING", host_ns_per_tick());
+    std::vector<double> round_trips;
+    for (size_t i = 1; i < ping.rounds(); ++i) {
+        round_trips.push_back(ping.at(i, TRACE_RECEIVE) - ping.at(i - 1, TRACE_RECEIVE));
+    }
+    std::sort(round_trips.begin(), round_trips.end());
+    return round_trips;
+}
 
-    uint64_t cpu_time_device_acqrel;
-    std::thread t_device_acqrel(host_ping_function_acqrel_base, (std::atomic<uint16_t> *) flag_device_acqrel, &cpu_time_device_acqrel);
-    CPU_ZERO(&cpuset);
-    CPU_SET(0, &cpuset);
-    pthread_setaffinity_np(t_device_acqrel.native_handle(), sizeof(cpu_set_t), &cpuset);
-    device_pong_kernel_acqrel_base<<<1,1>>>(flag_device_acqrel);
-    t_device_acqrel.join();
-    cudaDeviceSynchronize();
+ResultFields tail_fields(const std::vector<double> &sorted) {
+    return {{"p50", percentile(sorted, 0.5)}, {"p99", percentile(sorted, 0.99)}, {"p99.9", percentile(sorted, 0.999)}, {"Max", sorted.back()}};
+}
 
-    std::cout << "Host-PING Device-PONG (Device, Acq-Rel) | Host : " << ((double) (cpu_time_device_acqrel / 10000)) / ((double) get_cpu_freq() / 1000.) * 1000000. << std::endl;
+// the same round trips under default and low-jitter scheduling, and what the mode bought when both ran
+void scheduling_jitter(Arena &arena) {
+    std::string normal_experiment = "Host-PING Host-PONG (Jitter, Default)";
+    std::string low_experiment = "Host-PING Host-PONG (Jitter, Low-Jitter)";
+    bool run_normal = select_cell(normal_experiment, {nullptr, order_name(ACQ_REL), "Jitter"});
+    bool run_low = select_cell(low_experiment, {nullptr, order_name(ACQ_REL), "Jitter"});
+    if (!run_normal && !run_low) return;
 
-    uint64_t cpu_time_thread_acqrel;
-    std::thread t_thread_acqrel(host_ping_function_acqrel_base, (std::atomic<uint16_t> *) flag_thread_acqrel, &cpu_time_thread_acqrel);
-    CPU_ZERO(&cpuset);
-    CPU_SET(0, &cpuset);
-    pthread_setaffinity_np(t_thread_acqrel.native_handle(), sizeof(cpu_set_t), &cpuset);
-    device_pong_kernel_acqrel_base<<<1,1>>>(flag_thread_acqrel);
-    t_thread_acqrel.join();
-    cudaDeviceSynchronize();
+    if (arena.kind() == CUDA_MALLOC) {
+        std::cout << "Jitter needs host-accessible memory" << std::endl;
+        return;
+    }
+    if (agent_priority() == 0) {
+        std::cout << "Jitter needs SCHED_FIFO agents on two online cores" << std::endl;
+        return;
+    }
 
-    std::cout << "Host-PING Device-PONG (Thread, Acq-Rel) | Host : " << ((double) (cpu_time_thread_acqrel / 10000)) / ((double) get_cpu_freq() / 1000.) * 1000000. << std::endl;
-
-    if (allocator == MALLOC) {
-        free(flag_thread_relaxed);
-        free(flag_device_relaxed);
-        free(flag_system_relaxed);
-
-        free(flag_thread_acqrel);
-        free(flag_device_acqrel);
-        free(flag_system_acqrel);
-    } else if (allocator == CUDA_MALLOC_HOST) {
-        cudaFreeHost(flag_thread_relaxed);
-        cudaFreeHost(flag_device_relaxed);
-        cudaFreeHost(flag_system_relaxed);
-
-        cudaFreeHost(flag_thread_acqrel);
-        cudaFreeHost(flag_device_acqrel);
-        cudaFreeHost(flag_system_acqrel);
-    } else if (allocator == UM) {
-        cudaFree(flag_thread_relaxed);
-        cudaFree(flag_device_relaxed);
-        cudaFree(flag_system_relaxed);
-
-        cudaFree(flag_thread_acqrel);
-        cudaFree(flag_device_acqrel);
-        cudaFree(flag_system_acqrel);
-    }
-}
-
-void host_ping_device_pong_decoupled(Allocator allocator) {
-    cuda::atomic<uint16_t, cuda::thread_scope_thread> *flag_thread_relaxed;
-    cuda::atomic<uint16_t, cuda::thread_scope_device> *flag_device_relaxed;
-    cuda::atomic<uint16_t, cuda::thread_scope_system> *flag_system_relaxed;
-
-    if (allocator == CUDA_MALLOC_HOST) {
-        cudaMallocHost(&flag_thread_relaxed, sizeof(cuda::atomic<uint16_t, cuda::thread_scope_thread>));
-        cudaMallocHost(&flag_device_relaxed, sizeof(cuda::atomic<uint16_t, cuda::thread_scope_device>));
-        cudaMallocHost(&flag_system_relaxed, sizeof(cuda::atomic<uint16_t, cuda::thread_scope_system>));
-    } else if (allocator == MALLOC) {
-        flag_thread_relaxed = (cuda::atomic<uint16_t, cuda::thread_scope_thread> *) malloc(sizeof(cuda::atomic<uint16_t, cuda::thread_scope_thread>));
-        flag_device_relaxed = (cuda::atomic<uint16_t, cuda::thread_scope_device> *) malloc(sizeof(cuda::atomic<uint16_t, cuda::thread_scope_device>));
-        flag_system_relaxed = (cuda::atomic<uint16_t, cuda::thread_scope_system> *) malloc(sizeof(cuda::atomic<uint16_t, cuda::thread_scope_system>));
-    } else if (allocator == UM) {
-        cudaMallocManaged(&flag_thread_relaxed, sizeof(cuda::atomic<uint16_t, cuda::thread_scope_thread>));
-        cudaMallocManaged(&flag_device_relaxed, sizeof(cuda::atomic<uint16_t, cuda::thread_scope_device>));
-        cudaMallocManaged(&flag_system_relaxed, sizeof(cuda::atomic<uint16_t, cuda::thread_scope_system>));
-    }
-
-    cpu_set_t cpuset;
-    
-    uint64_t cpu_time_system;
-    std::thread t_system(host_ping_function_relaxed_decoupled, (std::atomic<uint16_t> *) flag_system_relaxed, &cpu_time_system);
-    CPU_ZERO(&cpuset);
-    CPU_SET(0, &cpuset);
-    pthread_setaffinity_np(t_system.native_handle(), sizeof(cpu_set_t), &cpuset);
-    device_pong_kernel_relaxed_decoupled<<<1,1>>>(flag_system_relaxed);
-    t_system.join();
-    cudaDeviceSynchronize();
+    std::vector<double> normal, low;
+    if (run_normal) {
+        int priority = agent_priority();
+        agent_priority() = 0;
+        normal = host_host_round_trips(arena);
+        agent_priority() = priority;
+        report_result(normal_experiment, tail_fields(normal));
+    }
+    if (run_low) {
+        low = host_host_round_trips(arena);
+        report_result(low_experiment, tail_fields(low));
+    }
+    if (!run_normal || !run_low) return;
 
-    std::cout << "Host-PING Device-PONG (System, Relaxed, Decoupled) | Host : " << ((double) (cpu_time_system / 10000)) / ((double) get_cpu_freq() / 1000.) * 1000000. << std::endl;
+    auto delta = [](double from, double to) { return 100. * (to - from) / from; };
+    std::lock_guard<std::mutex> lock(output_mutex());
+    std::cout << "Info | Low-Jitter | Gain | p50 Delta % : " << delta(percentile(normal, 0.5), percentile(low, 0.5)) << " | p99 Delta % : " << delta(percentile(normal, 0.99), percentile(low, 0.99)) << " | p99.9 Delta % : " << delta(percentile(normal, 0.999), percentile(low, 0.999)) << std::endl;
+}
 
-    uint64_t cpu_time_device;
-    std::thread t_device(host_ping_function_relaxed_decoupled, (std::atomic<uint16_t> *) flag_device_relaxed, &cpu_time_device);
-    CPU_ZERO(&cpuset);
-    CPU_SET(0, &cpuset);
-    pthread_setaffinity_np(t_device.native_handle(), sizeof(cpu_set_t), &cpuset);
-    device_pong_kernel_relaxed_decoupled<<<1,1>>>(flag_device_relaxed);
-    t_device.join();
-    cudaDeviceSynchronize();
+void report_cold(const std::string &experiment, Arena &arena, const uint64_t *cold_stamps, const uint64_t *warm_stamps) {
+    std::vector<uint64_t> cold(COLD_EPISODES * COLD_EPISODE_STAMPS), warm(cold.size());
+    arena.read(cold_stamps, cold.size(), cold.data());
+    arena.read(warm_stamps, warm.size(), warm.data());
 
-    std::cout << "Host-PING Device-PONG (Device, Relaxed, Decoupled) | Host : " << ((double) (cpu_time_device / 10000)) / ((double) get_cpu_freq() / 1000.) * 1000000. << std::endl;
-
-    // uint64_t cpu_time_thread;
-    // std::thread t_thread(host_ping_function_relaxed_decoupled, (std::atomic<uint16_t> *) flag_thread_relaxed, &cpu_time_thread);
-    // CPU_ZERO(&cpuset);
-    // CPU_SET(0, &cpuset);
-    // pthread_setaffinity_np(t_thread.native_handle(), sizeof(cpu_set_t), &cpuset);
-    // device_pong_kernel_relaxed_decoupled<<<1,1>>>(flag_thread_relaxed);
-    // t_thread.join();
-    // cudaDeviceSynchronize();
-
-    // std::cout << "Host-PING Device-PONG (Thread, Relaxed, Decoupled) | Host : " << ((double) (cpu_time_thread / 10000)) / ((double) get_cpu_freq() / 1000.) * 1000000. << std::endl;
-    
-
-    cuda::atomic<uint16_t, cuda::thread_scope_thread> *flag_thread_acqrel;
-    cuda::atomic<uint16_t, cuda::thread_scope_device> *flag_device_acqrel;
-    cuda::atomic<uint16_t, cuda::thread_scope_system> *flag_system_acqrel;
-
-    if (allocator == CUDA_MALLOC_HOST) {
-        cudaMallocHost(&flag_thread_acqrel, sizeof(cuda::atomic<uint16_t, cuda::thread_scope_thread>));
-        cudaMallocHost(&flag_device_acqrel, sizeof(cuda::atomic<uint16_t, cuda::thread_scope_device>));
-        cudaMallocHost(&flag_system_acqrel, sizeof(cuda::atomic<uint16_t, cuda::thread_scope_system>));
-    } else if (allocator == MALLOC) {
-        flag_thread_acqrel = (cuda::atomic<uint16_t, cuda::thread_scope_thread> *) malloc(sizeof(cuda::atomic<uint16_t, cuda::thread_scope_thread>));
-        flag_device_acqrel = (cuda::atomic<uint16_t, cuda::thread_scope_device> *) malloc(sizeof(cuda::atomic<uint16_t, cuda::thread_scope_device>));
-        flag_system_acqrel = (cuda::atomic<uint16_t, cuda::thread_scope_system> *) malloc(sizeof(cuda::atomic<uint16_t, cuda::thread_scope_system>));
-    } else if (allocator == UM) {
-        cudaMallocManaged(&flag_thread_acqrel, sizeof(cuda::atomic<uint16_t, cuda::thread_scope_thread>));
-        cudaMallocManaged(&flag_device_acqrel, sizeof(cuda::atomic<uint16_t, cuda::thread_scope_device>));
-        cudaMallocManaged(&flag_system_acqrel, sizeof(cuda::atomic<uint16_t, cuda::thread_scope_system>));
-    }
-
-    uint64_t cpu_time_system_acqrel;
-    std::thread t_system_acqrel(host_ping_function_acqrel_decoupled, (std::atomic<uint16_t> *) flag_system_acqrel, &cpu_time_system_acqrel);
-    CPU_ZERO(&cpuset);
-    CPU_SET(0, &cpuset);
-    pthread_setaffinity_np(t_system_acqrel.native_handle(), sizeof(cpu_set_t), &cpuset);
-    device_pong_kernel_acqrel_decoupled<<<1,1>>>(flag_system_acqrel);
-    t_system_acqrel.join();
-    cudaDeviceSynchronize();
+    ColdLatency after_cooling = cold_latency(cold, host_ns_per_tick());
+    report_result(experiment, {{"First", after_cooling.first_ns}, {"First K", after_cooling.first_k_ns}, {"Steady", cold_latency(warm, host_ns_per_tick()).all_ns}});
+}
 
-    std::cout << "Host-PING Device-PONG (System, Acq-Rel, Decoupled) | Host : " << ((double) (cpu_time_system_acqrel / 10000)) / ((double) get_cpu_freq() / 1000.) * 1000000. << std::endl;
+void host_host_cold_cell(Arena &arena, const Cooling &cooling) {
+    std::string experiment = "Host-PING Host-PONG (Cold, " + cooling.spec + ")";
+    if (!select_cell(experiment, {nullptr, order_name(ACQ_REL), "Cold"})) return;
 
-    uint64_t cpu_time_device_acqrel; //-
-    std::thread t_device_acqrel(host_ping_function_acqrel_decoupled, (std::atomic<uint16_t> *) flag_device_acqrel, &cpu_time_device_acqrel); //-
-    CPU_ZERO(&cpuset); //-
-    CPU_SET(0, &cpuset); //-
-    pthread_setaffinity_np(t_device_acqrel.native_handle(), sizeof(cpu_set_t), &cpuset); //-
-    device_pong_kernel_acqrel_decoupled<<<1,1>>>(flag_device_acqrel); 
-    t_device_acqrel.join(); //-
-    cudaDeviceSynchronize();
+    // a fresh flag per run: the previous pong leaves PING behind
+    arena.reset();
+    uint64_t *stamps[2];
+    for (const Cooling *episode_cooling : {&cooling, (const Cooling *) nullptr}) {
+        uint32_t *flag = arena.slot<uint32_t>();
+        uint64_t *episode_stamps = arena.slot<uint64_t>(COLD_EPISODES * COLD_EPISODE_STAMPS);
+        stamps[episode_cooling == nullptr] = episode_stamps;
 
-    std::cout << "Host-PING Device-PONG (Device, Acq-Rel, Decoupled) | Host : " << ((double) (cpu_time_device_acqrel / 10000)) / ((double) get_cpu_freq() / 1000.) * 1000000. << std::endl;
-
-    // uint64_t cpu_time_thread_acqrel;
-    // std::thread t_thread_acqrel(host_ping_function_acqrel_decoupled, (std::atomic<uint16_t> *) flag_thread_acqrel, &cpu_time_thread_acqrel);
-    // CPU_ZERO(&cpuset);
-    // CPU_SET(0, &cpuset);
-    // pthread_setaffinity_np(t_thread_acqrel.native_handle(), sizeof(cpu_set_t), &cpuset);
-    // device_pong_kernel_acqrel_decoupled<<<1,1>>>(flag_thread_acqrel);
-    // t_thread_acqrel.join();
-    // cudaDeviceSynchronize();
-
-    // std::cout << "Host-PING Device-PONG (Thread, Acq-Rel, Decoupled) | Host : " << ((double) (cpu_time_thread_acqrel / 10000)) / ((double) get_cpu_freq() / 1000.) * 1000000. << std::endl;
-
-    if (allocator == MALLOC) {
-        free(flag_thread_relaxed);
-        free(flag_device_relaxed);
-        free(flag_system_relaxed);
-
-        free(flag_thread_acqrel);
-        free(flag_device_acqrel);
-        free(flag_system_acqrel);
-    } else if (allocator == CUDA_MALLOC_HOST) {
-        cudaFreeHost(flag_thread_relaxed);
-        cudaFreeHost(flag_device_relaxed);
-        cudaFreeHost(flag_system_relaxed);
-
-        cudaFreeHost(flag_thread_acqrel);
-        cudaFreeHost(flag_device_acqrel);
-        cudaFreeHost(flag_system_acqrel);
-    } else if (allocator == UM) {
-        cudaFree(flag_thread_relaxed);
-        cudaFree(flag_device_relaxed);
-        cudaFree(flag_system_relaxed);
-
-        cudaFree(flag_thread_acqrel);
-        cudaFree(flag_device_acqrel);
-        cudaFree(flag_system_acqrel);
-    }
-}
-
-void device_ping_device_pong_decoupled(Allocator allocator) {
-    cuda::atomic<uint16_t, cuda::thread_scope_thread> *flag_thread_acqrel;
-    cuda::atomic<uint16_t, cuda::thread_scope_device> *flag_device_acqrel;
-    cuda::atomic<uint16_t, cuda::thread_scope_system> *flag_system_acqrel;
-
-    if (allocator == CUDA_MALLOC_HOST) {
-        cudaMallocHost(&flag_thread_acqrel, sizeof(cuda::atomic<uint16_t, cuda::thread_scope_thread>));
-        cudaMallocHost(&flag_device_acqrel, sizeof(cuda::atomic<uint16_t, cuda::thread_scope_device>));
-        cudaMallocHost(&flag_system_acqrel, sizeof(cuda::atomic<uint16_t, cuda::thread_scope_system>));
-    } else if (allocator == MALLOC) {
-        flag_thread_acqrel = (cuda::atomic<uint16_t, cuda::thread_scope_thread> *) malloc(sizeof(cuda::atomic<uint16_t, cuda::thread_scope_thread>));
-        flag_device_acqrel = (cuda::atomic<uint16_t, cuda::thread_scope_device> *) malloc(sizeof(cuda::atomic<uint16_t, cuda::thread_scope_device>));
-        flag_system_acqrel = (cuda::atomic<uint16_t, cuda::thread_scope_system> *) malloc(sizeof(cuda::atomic<uint16_t, cuda::thread_scope_system>));
-    } else if (allocator == CUDA_MALLOC) {
-        cudaMalloc(&flag_thread_acqrel, sizeof(cuda::atomic<uint16_t, cuda::thread_scope_thread>));
-        cudaMalloc(&flag_device_acqrel, sizeof(cuda::atomic<uint16_t, cuda::thread_scope_device>));
-        cudaMalloc(&flag_system_acqrel, sizeof(cuda::atomic<uint16_t, cuda::thread_scope_system>));
-    } else if (allocator == UM) {
-        cudaMallocManaged(&flag_thread_acqrel, sizeof(cuda::atomic<uint16_t, cuda::thread_scope_thread>));
-        cudaMallocManaged(&flag_device_acqrel, sizeof(cuda::atomic<uint16_t, cuda::thread_scope_device>));
-        cudaMallocManaged(&flag_system_acqrel, sizeof(cuda::atomic<uint16_t, cuda::thread_scope_system>));
+        std::thread t_ping = pinned_thread(core_pair().first, host_cold_ping_function, flag, episode_stamps, episode_cooling, arena.page_size());
+        std::thread t_pong = pinned_thread(core_pair().second, host_pong_function<ACQ_REL, DECOUPLED>, flag, nullptr, COLD_EPISODES * (COLD_ROUNDS + 1));
+        t_ping.join();
+        t_pong.join();
     }
 
-    cudaStream_t stream_a, stream_b;
-    cudaStreamCreate(&stream_a);
-    cudaStreamCreate(&stream_b);
-
-    // clock_t time_system_acqrel;
-    // device_ping_kernel_acqrel_decoupled<<<1,1,0,stream_a>>>(flag_system_acqrel, &time_system_acqrel);
-    // device_pong_kernel_acqrel_decoupled<<<1,1,0,stream_b>>>(flag_system_acqrel);
-    // cudaDeviceSynchronize();
-
-    // std::cout << "Device-PING Device-PONG (System, Acq-Rel, Decoupled) | Device : " << ((double) (time_system_acqrel / 10000)) / ((double) get_gpu_freq()) * 1000000. << std::endl;
-
-
-    // clock_t time_device_acqrel;
-    // device_ping_kernel_acqrel_decoupled<<<1,1,0,stream_a>>>(flag_device_acqrel, &time_device_acqrel);
-    // device_pong_kernel_acqrel_decoupled<<<1,1,0,stream_b>>>(flag_device_acqrel);
-    // cudaDeviceSynchronize();
-
-    // std::cout << "Device-PING Device-PONG (Device, Acq-Rel, Decoupled) | Device : " << ((double) (time_device_acqrel / 10000)) / ((double) get_gpu_freq()) * 1000000. << std::endl;
-
-
-    // clock_t time_thread_acqrel;
-    // device_ping_kernel_acqrel_decoupled<<<1,1,0,stream_a>>>(flag_thread_acqrel, &time_thread_acqrel);
-    // device_pong_kernel_acqrel_decoupled<<<1,1,0,stream_b>>>(flag_thread_acqrel);
-    // cudaDeviceSynchronize();
-
-    // std::cout << "Device-PING Device-PONG (Thread, Acq-Rel, Decoupled) | Device : " << ((double) (time_thread_acqrel / 10000)) / ((double) get_gpu_freq()) * 1000000. << std::endl;
-    
-    cuda::atomic<uint16_t, cuda::thread_scope_thread> *flag_thread_relaxed;
-    cuda::atomic<uint16_t, cuda::thread_scope_device> *flag_device_relaxed;
-    cuda::atomic<uint16_t, cuda::thread_scope_system> *flag_system_relaxed;
-
-    if (allocator == CUDA_MALLOC_HOST) {
-        cudaMallocHost(&flag_thread_relaxed, sizeof(cuda::atomic<uint16_t, cuda::thread_scope_thread>));
-        cudaMallocHost(&flag_device_relaxed, sizeof(cuda::atomic<uint16_t, cuda::thread_scope_device>));
-        cudaMallocHost(&flag_system_relaxed, sizeof(cuda::atomic<uint16_t, cuda::thread_scope_system>));
-    } else if (allocator == MALLOC) {
-        flag_thread_relaxed = (cuda::atomic<uint16_t, cuda::thread_scope_thread> *) malloc(sizeof(cuda::atomic<uint16_t, cuda::thread_scope_thread>));
-        flag_device_relaxed = (cuda::atomic<uint16_t, cuda::thread_scope_device> *) malloc(sizeof(cuda::atomic<uint16_t, cuda::thread_scope_device>));
-        flag_system_relaxed = (cuda::atomic<uint16_t, cuda::thread_scope_system> *) malloc(sizeof(cuda::atomic<uint16_t, cuda::thread_scope_system>));
-    } else if (allocator == CUDA_MALLOC) {
-        cudaMalloc(&flag_thread_relaxed, sizeof(cuda::atomic<uint16_t, cuda::thread_scope_thread>));
-        cudaMalloc(&flag_device_relaxed, sizeof(cuda::atomic<uint16_t, cuda::thread_scope_device>));
-        cudaMalloc(&flag_system_relaxed, sizeof(cuda::atomic<uint16_t, cuda::thread_scope_system>));
-    } else if (allocator == UM) {
-        cudaMallocManaged(&flag_thread_relaxed, sizeof(cuda::atomic<uint16_t, cuda::thread_scope_thread>));
-        cudaMallocManaged(&flag_device_relaxed, sizeof(cuda::atomic<uint16_t, cuda::thread_scope_device>));
-        cudaMallocManaged(&flag_system_relaxed, sizeof(cuda::atomic<uint16_t, cuda::thread_scope_system>));
-    }
-
-    clock_t time_system_relaxed;
-    device_ping_kernel_relaxed_decoupled<<<1,1,0,stream_a>>>(flag_system_relaxed, &time_system_relaxed);
-    device_pong_kernel_relaxed_decoupled<<<1,1,0,stream_b>>>(flag_system_relaxed);
-    cudaDeviceSynchronize();
-
-    std::cout << "Device-PING Device-PONG (System, Relaxed, Decoupled) | Device : " << ((double) (time_system_relaxed / 10000)) / ((double) get_gpu_freq()) * 1000000. << std::endl;
+    report_cold(experiment, arena, stamps[0], stamps[1]);
+}
 
+template <cuda::thread_scope Scope>
+void host_device_cold_cell(Arena &arena, const Cooling &cooling) {
+    std::string experiment = std::string("Host-PING Device-PONG (") + scope_name(Scope) + ", Cold, " + cooling.spec + ")";
+    if (!select_cell(experiment, {scope_name(Scope), order_name(ACQ_REL), "Cold"})) return;
 
-    clock_t time_device_relaxed;
-    device_ping_kernel_relaxed_decoupled<<<1,1,0,stream_a>>>(flag_device_relaxed, &time_device_relaxed);
-    device_pong_kernel_relaxed_decoupled<<<1,1,0,stream_b>>>(flag_device_relaxed);
-    cudaDeviceSynchronize();
+    // a fresh flag per run: the previous pong leaves PING behind
+    arena.reset();
+    uint64_t *stamps[2];
+    for (const Cooling *episode_cooling : {&cooling, (const Cooling *) nullptr}) {
+        uint32_t *flag = arena.slot<uint32_t>();
+        uint64_t *episode_stamps = arena.slot<uint64_t>(COLD_EPISODES * COLD_EPISODE_STAMPS);
+        stamps[episode_cooling == nullptr] = episode_stamps;
 
-    std::cout << "Device-PING Device-PONG (Device, Relaxed, Decoupled) | Device : " << ((double) (time_device_relaxed / 10000)) / ((double) get_gpu_freq()) * 1000000. << std::endl;
-
-
-    // clock_t time_thread_relaxed;
-    // device_ping_kernel_relaxed_decoupled<<<1,1,0,stream_a>>>(flag_thread_relaxed, &time_thread_relaxed);
-    // device_pong_kernel_relaxed_decoupled<<<1,1,0,stream_b>>>(flag_thread_relaxed);
-    // cudaDeviceSynchronize();
-
-    // std::cout << "Device-PING Device-PONG (Thread, Relaxed, Decoupled) | Device : " << ((double) (time_thread_relaxed / 10000)) / ((double) get_gpu_freq()) * 1000000. << std::endl;
-
-    if (allocator == MALLOC) {
-        free(flag_thread_relaxed);
-        free(flag_device_relaxed);
-        free(flag_system_relaxed);
-
-        free(flag_thread_acqrel);
-        free(flag_device_acqrel);
-        free(flag_system_acqrel);
-    } else if (allocator == CUDA_MALLOC_HOST) {
-        cudaFreeHost(flag_thread_relaxed);
-        cudaFreeHost(flag_device_relaxed);
-        cudaFreeHost(flag_system_relaxed);
-
-        cudaFreeHost(flag_thread_acqrel);
-        cudaFreeHost(flag_device_acqrel);
-        cudaFreeHost(flag_system_acqrel);
-    } else if (allocator == CUDA_MALLOC || allocator == UM) {
-        cudaFree(flag_thread_relaxed);
-        cudaFree(flag_device_relaxed);
-        cudaFree(flag_system_relaxed);
-
-        cudaFree(flag_thread_acqrel);
-        cudaFree(flag_device_acqrel);
-        cudaFree(flag_system_acqrel);
-    }
-}
-
-void device_ping_device_pong_base(Allocator allocator) {
-    cuda::atomic<uint16_t, cuda::thread_scope_thread> *flag_thread_relaxed;
-    cuda::atomic<uint16_t, cuda::thread_scope_device> *flag_device_relaxed;
-    cuda::atomic<uint16_t, cuda::thread_scope_system> *flag_system_relaxed;
-
-    if (allocator == CUDA_MALLOC_HOST) {
-        cudaMallocHost(&flag_thread_relaxed, sizeof(cuda::atomic<uint16_t, cuda::thread_scope_thread>));
-        cudaMallocHost(&flag_device_relaxed, sizeof(cuda::atomic<uint16_t, cuda::thread_scope_device>));
-        cudaMallocHost(&flag_system_relaxed, sizeof(cuda::atomic<uint16_t, cuda::thread_scope_system>));
-    } else if (allocator == MALLOC) {
-        flag_thread_relaxed = (cuda::atomic<uint16_t, cuda::thread_scope_thread> *) malloc(sizeof(cuda::atomic<uint16_t, cuda::thread_scope_thread>));
-        flag_device_relaxed = (cuda::atomic<uint16_t, cuda::thread_scope_device> *) malloc(sizeof(cuda::atomic<uint16_t, cuda::thread_scope_device>));
-        flag_system_relaxed = (cuda::atomic<uint16_t, cuda::thread_scope_system> *) malloc(sizeof(cuda::atomic<uint16_t, cuda::thread_scope_system>));
-    } else if (allocator == CUDA_MALLOC) {
-        cudaMalloc(&flag_thread_relaxed, sizeof(cuda::atomic<uint16_t, cuda::thread_scope_thread>));
-        cudaMalloc(&flag_device_relaxed, sizeof(cuda::atomic<uint16_t, cuda::thread_scope_device>));
-        cudaMalloc(&flag_system_relaxed, sizeof(cuda::atomic<uint16_t, cuda::thread_scope_system>));
-    } else if (allocator == UM) {
-        cudaMallocManaged(&flag_thread_relaxed, sizeof(cuda::atomic<uint16_t, cuda::thread_scope_thread>));
-        cudaMallocManaged(&flag_device_relaxed, sizeof(cuda::atomic<uint16_t, cuda::thread_scope_device>));
-        cudaMallocManaged(&flag_system_relaxed, sizeof(cuda::atomic<uint16_t, cuda::thread_scope_system>));
+        std::thread t = pinned_thread(core_pair().first, host_cold_ping_function, flag, episode_stamps, episode_cooling, arena.page_size());
+        device_pong_kernel<Scope, ACQ_REL, DECOUPLED><<<1,1>>>(flag, nullptr, COLD_EPISODES * (COLD_ROUNDS + 1));
+        t.join();
+        cudaDeviceSynchronize();
     }
 
-    cudaStream_t stream_a, stream_b;
-    cudaStreamCreate(&stream_a);
-    cudaStreamCreate(&stream_b);
-
-    // clock_t time_system_relaxed;
-    clock_t *time_system_relaxed;
+    report_cold(experiment, arena, stamps[0], stamps[1]);
+}
 
-    if (allocator == CUDA_MALLOC_HOST) {
-        cudaMallocHost(&time_system_relaxed, sizeof(clock_t));
-    } else if (allocator == MALLOC) {
-        time_system_relaxed = (clock_t *) malloc(sizeof(clock_t));
-    } else if (allocator == CUDA_MALLOC) {
-        cudaMalloc(&time_system_relaxed, sizeof(clock_t));
-    } else if (allocator == UM) {
-        cudaMallocManaged(&time_system_relaxed, sizeof(clock_t));
+// first-message against steady-state latency, per cooling action
+void cold_start(Arena &arena, const std::vector<Cooling> &coolings) {
+    if (arena.kind() == CUDA_MALLOC) {
+        std::cout << "Cold-start latency needs host-accessible memory" << std::endl;
+        return;
     }
 
-    device_ping_kernel_relaxed_base<<<1,1,0,stream_a>>>(flag_system_relaxed, time_system_relaxed);
-    device_pong_kernel_relaxed_base<<<1,1,0,stream_b>>>(flag_system_relaxed);
+    for (const Cooling &cooling : coolings) {
+        if (cooling.action == COOL_UM && arena.kind() != UM) {
+            std::cout << "Cooling um needs a UM arena" << std::endl;
+            continue;
+        }
+        if (cooling.action != COOL_UM) {
+            host_host_cold_cell(arena, cooling);
+        }
+        if (platform().has_device) {
+            host_device_cold_cell<cuda::thread_scope_system>(arena, cooling);
+        }
+    }
+}
 
-    cudaStreamSynchronize(stream_a);
-    cudaStreamSynchronize(stream_b);
+void host_idle_cell(Arena &arena, IdleWait wait, double gap_us) {
+    std::ostringstream gap;
+    gap << gap_us;
+    std::string experiment = std::string("Host-PING Host-PONG (Idle, ") + idle_wait_name(wait) + ", " + gap.str() + " us)";
+    if (!select_cell(experiment, {nullptr, order_name(ACQ_REL), "Idle"})) return;
 
-    cudaDeviceSynchronize();
+    arena.reset();
+    uint32_t *request = arena.slot<uint32_t>();
+    uint32_t *reply = arena.slot<uint32_t>();
+    size_t rounds = idle_rounds(gap_us);
 
-    if (allocator == CUDA_MALLOC) {
-        clock_t time;
+    int responder = core_pair().second;
+    std::vector<IdleState> before = read_idle_states(responder);
+    double start_ms = monotonic_ms();
 
-        cudaMemcpy(&time, time_system_relaxed, sizeof(clock_t), cudaMemcpyDeviceToHost);
-        std::cout << "Device-PING Device-PONG (System, Relaxed) | Device : " << ((double) (time / 10000)) / ((double) get_gpu_freq()) * 1000000. << std::endl;
-    } else {
-        std::cout << "Device-PING Device-PONG (System, Relaxed) | Device : " << ((double) (*time_system_relaxed / 10000)) / ((double) get_gpu_freq()) * 1000000. << std::endl;
+    std::vector<uint64_t> latencies;
+    // the sender sleeps through long gaps whatever the wait; a spinning responder must not switch
+    contamination().allow_blocking(core_pair().first);
+    if (wait != WAIT_SPIN) {
+        contamination().allow_blocking(responder);
     }
+    std::thread t_sender = pinned_thread(core_pair().first, idle_sender, request, reply, wait, gap_us, rounds, &latencies);
+    std::thread t_responder = pinned_thread(responder, idle_responder, request, reply, wait, rounds);
+    t_sender.join();
+    t_responder.join();
 
+    double elapsed_us = (monotonic_ms() - start_ms) * 1000.;
+    std::vector<IdleState> after = read_idle_states(responder);
 
+    std::vector<double> sorted;
+    for (uint64_t ticks : latencies) {
+        sorted.push_back((double) ticks * host_ns_per_tick());
+    }
+    std::sort(sorted.begin(), sorted.end());
 
-    // clock_t time_device_relaxed;
-    // device_ping_kernel_relaxed_base<<<1,1,0,stream_a>>>(flag_device_relaxed, &time_device_relaxed);
-    // device_pong_kernel_relaxed_base<<<1,1,0,stream_b>>>(flag_device_relaxed);
-    // cudaDeviceSynchronize();
-
-    // std::cout << "Device-PING Device-PONG (Device, Relaxed) | Device : " << ((double) (time_device_relaxed / 10000)) / ((double) get_gpu_freq()) * 1000000. << std::endl;
+    ResultFields fields = {{"p50", percentile(sorted, 0.5)}, {"p99", percentile(sorted, 0.99)}, {"Max", sorted.back()}};
+    for (size_t i = 0; i < before.size() && i < after.size(); ++i) {
+        fields.push_back({after[i].name + " Residency %", 100. * (double) (after[i].time_us - before[i].time_us) / elapsed_us, DESCRIPTIVE});
+        fields.push_back({after[i].name + " Entries", (double) (after[i].usage - before[i].usage), DESCRIPTIVE});
+    }
+    report_result(experiment, fields);
+}
 
+// response latency against idle gap, one curve per wait strategy
+void idle_gap(Arena &arena, const std::vector<IdleSweep> &sweeps) {
+    if (arena.kind() == CUDA_MALLOC) {
+        std::cout << "Idle-gap latency needs host-accessible memory" << std::endl;
+        return;
+    }
 
-    // clock_t time_thread_relaxed;
-    // device_ping_kernel_relaxed_base<<<1,1,0,stream_a>>>(flag_thread_relaxed, &time_thread_relaxed);
-    // device_pong_kernel_relaxed_base<<<1,1,0,stream_b>>>(flag_thread_relaxed);
-    // cudaDeviceSynchronize();
+    for (const IdleSweep &sweep : sweeps) {
+        for (double gap_us : sweep.gaps_us) {
+            host_idle_cell(arena, sweep.wait, gap_us);
+        }
+    }
+}
 
-    // std::cout << "Device-PING Device-PONG (Thread, Relaxed) | Device : " << ((double) (time_thread_relaxed / 10000)) / ((double) get_gpu_freq()) * 1000000. << std::endl;
+void token_ring_cell(Arena &arena, size_t agents, size_t tokens) {
+    std::vector<CpuPlacement> cpus = ring_placements(agents);
+    std::set<int> llcs, nodes;
+    for (const CpuPlacement &placement : cpus) {
+        llcs.insert(placement.llc);
+        nodes.insert(placement.node);
+    }
 
+    std::string experiment = "Token-Ring (" + std::to_string(agents) + " Agents, " + std::to_string(tokens) + (tokens == 1 ? " Token, " : " Tokens, ")
+                           + std::to_string(llcs.size()) + (llcs.size() == 1 ? " LLC, " : " LLCs, ") + std::to_string(nodes.size()) + (nodes.size() == 1 ? " Node)" : " Nodes)");
+    if (!select_cell(experiment, {nullptr, order_name(ACQ_REL), "Ring"})) return;
 
-    cuda::atomic<uint16_t, cuda::thread_scope_thread> *flag_thread_acqrel;
-    cuda::atomic<uint16_t, cuda::thread_scope_device> *flag_device_acqrel;
-    cuda::atomic<uint16_t, cuda::thread_scope_system> *flag_system_acqrel;
+    if (cpus.size() < agents) {
+        std::cout << "Token ring of " << agents << " needs as many CPUs, have " << cpus.size() << std::endl;
+        return;
+    }
 
-    if (allocator == CUDA_MALLOC_HOST) {
-        cudaMallocHost(&flag_thread_acqrel, sizeof(cuda::atomic<uint16_t, cuda::thread_scope_thread>));
-        cudaMallocHost(&flag_device_acqrel, sizeof(cuda::atomic<uint16_t, cuda::thread_scope_device>));
-        cudaMallocHost(&flag_system_acqrel, sizeof(cuda::atomic<uint16_t, cuda::thread_scope_system>));
-    } else if (allocator == MALLOC) {
-        flag_thread_acqrel = (cuda::atomic<uint16_t, cuda::thread_scope_thread> *) malloc(sizeof(cuda::atomic<uint16_t, cuda::thread_scope_thread>));
-        flag_device_acqrel = (cuda::atomic<uint16_t, cuda::thread_scope_device> *) malloc(sizeof(cuda::atomic<uint16_t, cuda::thread_scope_device>));
-        flag_system_acqrel = (cuda::atomic<uint16_t, cuda::thread_scope_system> *) malloc(sizeof(cuda::atomic<uint16_t, cuda::thread_scope_system>));
-    } else if (allocator == CUDA_MALLOC) {
-        cudaMalloc(&flag_thread_acqrel, sizeof(cuda::atomic<uint16_t, cuda::thread_scope_thread>));
-        cudaMalloc(&flag_device_acqrel, sizeof(cuda::atomic<uint16_t, cuda::thread_scope_device>));
-        cudaMalloc(&flag_system_acqrel, sizeof(cuda::atomic<uint16_t, cuda::thread_scope_system>));
-    } else if (allocator == UM) {
-        cudaMallocManaged(&flag_thread_acqrel, sizeof(cuda::atomic<uint16_t, cuda::thread_scope_thread>));
-        cudaMallocManaged(&flag_device_acqrel, sizeof(cuda::atomic<uint16_t, cuda::thread_scope_device>));
-        cudaMallocManaged(&flag_system_acqrel, sizeof(cuda::atomic<uint16_t, cuda::thread_scope_system>));
+    arena.reset();
+    std::vector<uint64_t *> flags;
+    for (size_t i = 0; i < agents; ++i) {
+        flags.push_back(arena.slot<uint64_t>());
     }
 
-    // clock_t time_system_acqrel;
-    // device_ping_kernel_acqrel_base<<<1,1,0,stream_a>>>(flag_system_acqrel, &time_system_acqrel);
-    // device_pong_kernel_acqrel_base<<<1,1,0,stream_b>>>(flag_system_acqrel);
-    // cudaDeviceSynchronize();
+    std::vector<uint64_t> sends, returns;
+    uint64_t elapsed;
+    std::vector<std::thread> threads;
+    threads.push_back(pinned_thread(cpus[0].cpu, ring_origin, flags[0], flags[1], RING_PASSES, tokens, &sends, &returns, &elapsed));
+    for (size_t i = 1; i < agents; ++i) {
+        threads.push_back(pinned_thread(cpus[i].cpu, ring_relay, flags[i], flags[(i + 1) % agents], RING_PASSES));
+    }
+    for (std::thread &t : threads) {
+        t.join();
+    }
 
-    // std::cout << "Device-PING Device-PONG (System, Acq-Rel) | Device : " << ((double) (time_system_acqrel / 10000)) / ((double) get_gpu_freq()) * 1000000. << std::endl;
+    double ns_per_tick = host_ns_per_tick();
+    std::vector<double> hops;
+    for (size_t k = 0; k < RING_PASSES; ++k) {
+        hops.push_back((double) (returns[k] - sends[k]) * ns_per_tick / (double) agents);
+    }
+    std::sort(hops.begin(), hops.end());
 
+    double seconds = (double) elapsed * ns_per_tick / 1000000000.;
+    report_result(experiment, {{"Hop p50", percentile(hops, 0.5)}, {"Hop p99", percentile(hops, 0.99)}, {"Mhops/s", (double) (RING_PASSES * agents) / seconds / 1000000., HIGHER_IS_BETTER}});
+}
 
-    // clock_t time_device_acqrel;
-    // device_ping_kernel_acqrel_base<<<1,1,0,stream_a>>>(flag_device_acqrel, &time_device_acqrel);
-    // device_pong_kernel_acqrel_base<<<1,1,0,stream_b>>>(flag_device_acqrel);
-    // cudaDeviceSynchronize();
+// per-hop latency and throughput as the ring grows across LLCs and nodes
+void token_ring(Arena &arena, const RingSweep &sweep) {
+    if (arena.kind() == CUDA_MALLOC) {
+        std::cout << "Token ring needs host-accessible memory" << std::endl;
+        return;
+    }
 
-    // std::cout << "Device-PING Device-PONG (Device, Acq-Rel) | Device : " << ((double) (time_device_acqrel / 10000)) / ((double) get_gpu_freq()) * 1000000. << std::endl;
+    for (size_t agents : sweep.agents) {
+        token_ring_cell(arena, agents, sweep.tokens);
+    }
+}
 
+void fan_cell(Arena &arena, size_t workers, FanSignal signal) {
+    std::string experiment = "Fan-Out Fan-In (" + std::to_string(workers) + (workers == 1 ? " Worker, " : " Workers, ") + fan_signal_name(signal) + ")";
+    if (!select_cell(experiment, {nullptr, order_name(ACQ_REL), "Fan"})) return;
 
-    // clock_t time_thread_acqrel;
-    // device_ping_kernel_acqrel_base<<<1,1,0,stream_a>>>(flag_thread_acqrel, &time_thread_acqrel);
-    // device_pong_kernel_acqrel_base<<<1,1,0,stream_b>>>(flag_thread_acqrel);
-    // cudaDeviceSynchronize();
+    std::vector<CpuPlacement> cpus = ring_placements(workers + 1);
+    if (cpus.size() < workers + 1) {
+        std::cout << "Fan-out to " << workers << " workers needs " << workers + 1 << " CPUs, have " << cpus.size() << std::endl;
+        return;
+    }
 
-    // std::cout << "Device-PING Device-PONG (Thread, Acq-Rel) | Device : " << ((double) (time_thread_acqrel / 10000)) / ((double) get_gpu_freq()) * 1000000. << std::endl;
+    arena.reset();
+    uint64_t *go = arena.slot<uint64_t>();
+    uint64_t *counter = arena.slot<uint64_t>();
+    std::vector<uint64_t *> own;
+    for (size_t i = 0; i < workers; ++i) {
+        own.push_back(arena.slot<uint64_t>(FAN_SLOTS));
+    }
 
+    std::vector<FanRound> rounds;
+    std::vector<std::thread> threads;
+    threads.push_back(pinned_thread(cpus[0].cpu, fan_coordinator, go, std::cref(own), counter, signal, FAN_ROUNDS, &rounds));
+    for (size_t i = 0; i < workers; ++i) {
+        threads.push_back(pinned_thread(cpus[i + 1].cpu, fan_worker, go, own[i], counter, signal, FAN_ROUNDS));
+    }
+    for (std::thread &t : threads) {
+        t.join();
+    }
 
-    if (allocator == MALLOC) {
-        free(flag_thread_relaxed);
-        free(flag_device_relaxed);
-        free(flag_system_relaxed);
+    double ns_per_tick = host_ns_per_tick();
+    std::vector<double> out, in, collected;
+    for (const FanRound &round : rounds) {
+        out.push_back((double) round.last_seen * ns_per_tick);
+        in.push_back((double) (round.collected - round.first_seen) * ns_per_tick);
+        collected.push_back((double) round.collected * ns_per_tick);
+    }
+    std::sort(collected.begin(), collected.end());
 
-        free(flag_thread_acqrel);
-        free(flag_device_acqrel);
-        free(flag_system_acqrel);
-    } else if (allocator == CUDA_MALLOC_HOST) {
-        cudaFreeHost(flag_thread_relaxed);
-        cudaFreeHost(flag_device_relaxed);
-        cudaFreeHost(flag_system_relaxed);
+    report_result(experiment, {{"Fan-Out", median(out)}, {"Fan-In", median(in)}, {"Collected", percentile(collected, 0.5)}, {"Collected p99", percentile(collected, 0.99)}});
+}
 
-        cudaFreeHost(flag_thread_acqrel);
-        cudaFreeHost(flag_device_acqrel);
-        cudaFreeHost(flag_system_acqrel);
-    } else if (allocator == CUDA_MALLOC || allocator == UM) {
-        cudaFree(flag_thread_relaxed);
-        cudaFree(flag_device_relaxed);
-        cudaFree(flag_system_relaxed);
+// one-to-many notification and many-to-one gather as the worker count grows
+void fan(Arena &arena, const std::vector<size_t> &workers) {
+    if (arena.kind() == CUDA_MALLOC) {
+        std::cout << "Fan-out needs host-accessible memory" << std::endl;
+        return;
+    }
 
-        cudaFree(flag_thread_acqrel);
-        cudaFree(flag_device_acqrel);
-        cudaFree(flag_system_acqrel);
+    for (size_t count : workers) {
+        fan_cell(arena, count, FAN_FLAGS);
+        fan_cell(arena, count, FAN_COUNTER);
     }
 }
 
-void device_ping_host_pong_base(Allocator allocator) {
-    cuda::atomic<uint16_t, cuda::thread_scope_thread> *flag_thread_relaxed;
-    cuda::atomic<uint16_t, cuda::thread_scope_device> *flag_device_relaxed;
-    cuda::atomic<uint16_t, cuda::thread_scope_system> *flag_system_relaxed;
+void mailbox_cell(Arena &arena, size_t channels, MailboxScan scan) {
+    std::string experiment = "Mailbox (" + std::to_string(channels) + " Channels, " + mailbox_scan_name(scan) + ")";
+    if (!select_cell(experiment, {nullptr, order_name(ACQ_REL), "Mailbox"})) return;
+
+    arena.reset();
+    Mailbox box;
+    box.channels = (channels + 63) / 64 * 64;
+    box.sequences = arena.slot<uint32_t>(box.channels);
+    box.doorbells = arena.slot<uint64_t>(box.channels / 64);
+    box.ack = arena.slot<uint64_t>();
+
+    std::vector<uint64_t> sends, detects;
+    double scan_ticks;
+    std::thread t_producer = pinned_thread(core_pair().first, mailbox_producer, box, scan, channels, MAILBOX_ROUNDS, &sends);
+    std::thread t_consumer = pinned_thread(core_pair().second, mailbox_consumer, box, scan, MAILBOX_ROUNDS, &detects, &scan_ticks);
+    t_producer.join();
+    t_consumer.join();
+
+    double ns_per_tick = host_ns_per_tick();
+    std::vector<double> detection;
+    for (size_t i = 0; i < MAILBOX_ROUNDS; ++i) {
+        detection.push_back((double) (int64_t) (detects[i] - sends[i]) * ns_per_tick);
+    }
+    std::sort(detection.begin(), detection.end());
+
+    double scan_ns = scan_ticks * ns_per_tick;
+    report_result(experiment, {{"Detect p50", percentile(detection, 0.5)}, {"Detect p99", percentile(detection, 0.99)}, {"Scan ns", scan_ns}, {"Scan ns/Channel", scan_ns / (double) box.channels}});
+}
 
-    if (allocator == CUDA_MALLOC_HOST) {
-        cudaMallocHost(&flag_thread_relaxed, sizeof(cuda::atomic<uint16_t, cuda::thread_scope_thread>));
-        cudaMallocHost(&flag_device_relaxed, sizeof(cuda::atomic<uint16_t, cuda::thread_scope_device>));
-        cudaMallocHost(&flag_system_relaxed, sizeof(cuda::atomic<uint16_t, cuda::thread_scope_system>));
-    } else if (allocator == MALLOC) {
-        flag_thread_relaxed = (cuda::atomic<uint16_t, cuda::thread_scope_thread> *) malloc(sizeof(cuda::atomic<uint16_t, cuda::thread_scope_thread>));
-        flag_device_relaxed = (cuda::atomic<uint16_t, cuda::thread_scope_device> *) malloc(sizeof(cuda::atomic<uint16_t, cuda::thread_scope_device>));
-        flag_system_relaxed = (cuda::atomic<uint16_t, cuda::thread_scope_system> *) malloc(sizeof(cuda::atomic<uint16_t, cuda::thread_scope_system>));
-    } else if (allocator == UM) {
-        cudaMallocManaged(&flag_thread_relaxed, sizeof(cuda::atomic<uint16_t, cuda::thread_scope_thread>));
-        cudaMallocManaged(&flag_device_relaxed, sizeof(cuda::atomic<uint16_t, cuda::thread_scope_device>));
-        cudaMallocManaged(&flag_system_relaxed, sizeof(cuda::atomic<uint16_t, cuda::thread_scope_system>));
-    } 
-
-    cpu_set_t cpuset;
-
-    std::thread t_system_relaxed(host_pong_function_relaxed_base, (std::atomic<uint16_t> *) flag_system_relaxed);
-    CPU_ZERO(&cpuset);
-    CPU_SET(0, &cpuset);
-    pthread_setaffinity_np(t_system_relaxed.native_handle(), sizeof(cpu_set_t), &cpuset);
-
-    clock_t time_system_relaxed;
-    device_ping_kernel_relaxed_base<<<1,1>>>(flag_system_relaxed, &time_system_relaxed);
-
-    t_system_relaxed.join();
-    cudaDeviceSynchronize();
+// detection latency and polling cost of each scan as the channel count grows
+void mailbox(Arena &arena, const std::vector<size_t> &channels) {
+    if (arena.kind() == CUDA_MALLOC) {
+        std::cout << "Mailbox polling needs host-accessible memory" << std::endl;
+        return;
+    }
 
-    std::cout << "Device-PING Host-PONG (System, Relaxed) | Device : " << ((double) (time_system_relaxed / 10000)) / ((double) get_gpu_freq()) * 1000000. << std::endl;
+    for (size_t count : channels) {
+        mailbox_cell(arena, count, SCAN_SCALAR);
+        mailbox_cell(arena, count, SCAN_VECTOR);
+        mailbox_cell(arena, count, SCAN_DOORBELL);
+    }
+}
 
+std::string grain_label(double grain_ns) {
+    std::ostringstream label;
+    label << grain_ns << " ns";
+    return label.str();
+}
 
-    std::thread t_device_relaxed(host_pong_function_relaxed_base, (std::atomic<uint16_t> *) flag_device_relaxed);
-    CPU_ZERO(&cpuset);
-    CPU_SET(0, &cpuset);
-    pthread_setaffinity_np(t_device_relaxed.native_handle(), sizeof(cpu_set_t), &cpuset);
+template <MemOrder Order>
+void work_stealing_cell(Arena &arena, double grain_ns, size_t thieves) {
+    std::string experiment = std::string("Work-Stealing (") + order_name(Order) + ", " + grain_label(grain_ns) + ", " + std::to_string(thieves) + (thieves == 1 ? " Thief)" : " Thieves)");
+    if (!select_cell(experiment, {nullptr, order_name(Order), "Steal"})) return;
 
-    clock_t time_device_relaxed;
-    device_ping_kernel_relaxed_base<<<1,1>>>(flag_device_relaxed, &time_device_relaxed);
+    std::vector<CpuPlacement> cpus = ring_placements(thieves + 1);
+    if (cpus.size() < thieves + 1) {
+        std::cout << "Work stealing with " << thieves << " thieves needs " << thieves + 1 << " CPUs, have " << cpus.size() << std::endl;
+        return;
+    }
 
-    t_device_relaxed.join();
-    cudaDeviceSynchronize();
+    arena.reset();
+    WorkDeque deque;
+    deque.top = arena.slot<int64_t>();
+    deque.bottom = arena.slot<int64_t>();
+    deque.tasks = arena.slot<uint64_t>(WS_CAPACITY);
+    uint64_t *go = arena.slot<uint64_t>();
+    std::vector<uint64_t *> own;
+    for (size_t i = 0; i < thieves; ++i) {
+        own.push_back(arena.slot<uint64_t>(STEAL_SLOTS));
+    }
 
-    std::cout << "Device-PING Host-PONG (Device, Relaxed) | Device : " << ((double) (time_device_relaxed / 10000)) / ((double) get_gpu_freq()) * 1000000. << std::endl;
+    uint64_t grain_ticks = (uint64_t) (grain_ns / host_ns_per_tick());
+    StealRun run;
+    std::vector<std::thread> threads;
+    threads.push_back(pinned_thread(cpus[0].cpu, steal_owner<Order>, deque, go, std::cref(own), grain_ticks, &run));
+    for (size_t i = 0; i < thieves; ++i) {
+        threads.push_back(pinned_thread(cpus[i + 1].cpu, steal_thief<Order>, deque, go, own[i], grain_ticks));
+    }
+    for (std::thread &t : threads) {
+        t.join();
+    }
 
+    double stolen = 0., attempts = 0.;
+    for (uint64_t *slots : own) {
+        stolen += (double) slots[STEAL_EXECUTED];
+        attempts += (double) slots[STEAL_ATTEMPTS];
+    }
 
-    std::thread t_thread_relaxed(host_pong_function_relaxed_base, (std::atomic<uint16_t> *) flag_thread_relaxed);
-    CPU_ZERO(&cpuset);
-    CPU_SET(0, &cpuset);
-    pthread_setaffinity_np(t_thread_relaxed.native_handle(), sizeof(cpu_set_t), &cpuset);
+    double ns_per_tick = host_ns_per_tick();
+    double seconds = (double) run.elapsed * ns_per_tick / 1000000000.;
+    ResultFields fields = {{"Mtasks/s", (double) WS_TASKS / seconds / 1000000., HIGHER_IS_BETTER}, {"Push ns", (double) run.push_ticks * ns_per_tick / (double) WS_CAPACITY}, {"Pop ns", (double) run.pop_ticks * ns_per_tick / (double) WS_CAPACITY}};
+    if (thieves > 0) {
+        fields.push_back({"Steal Success %", attempts > 0. ? 100. * stolen / attempts : 0., HIGHER_IS_BETTER});
+        fields.push_back({"Stolen %", 100. * stolen / (double) WS_TASKS, HIGHER_IS_BETTER});
+    }
+    report_result(experiment, fields);
+}
 
-    clock_t time_thread_relaxed;
-    device_ping_kernel_relaxed_base<<<1,1>>>(flag_thread_relaxed, &time_thread_relaxed);
+// the same tasks split evenly up front, for comparison
+void static_partition_cell(Arena &arena, double grain_ns, size_t workers) {
+    std::string experiment = "Static-Partition (" + grain_label(grain_ns) + ", " + std::to_string(workers) + (workers == 1 ? " Worker)" : " Workers)");
+    if (!select_cell(experiment, {nullptr, nullptr, "Steal"})) return;
 
-    t_thread_relaxed.join();
-    cudaDeviceSynchronize();
+    std::vector<CpuPlacement> cpus = ring_placements(workers);
+    if (cpus.size() < workers) {
+        return;
+    }
 
-    std::cout << "Device-PING Host-PONG (Thread, Relaxed) | Device : " << ((double) (time_thread_relaxed / 10000)) / ((double) get_gpu_freq()) * 1000000. << std::endl;
+    arena.reset();
+    uint64_t *go = arena.slot<uint64_t>();
+    uint64_t grain_ticks = (uint64_t) (grain_ns / host_ns_per_tick());
+    std::vector<uint64_t> finished(workers);
+    std::vector<std::thread> threads;
+    for (size_t i = 0; i < workers; ++i) {
+        threads.push_back(pinned_thread(cpus[i].cpu, static_worker, i, workers, grain_ticks, go, &finished[i]));
+    }
+    uint64_t start = get_cpu_clock();
+    std::atomic_ref<uint64_t>(*go).store(1, std::memory_order_release);
+    for (std::thread &t : threads) {
+        t.join();
+    }
 
+    double seconds = (double) (*std::max_element(finished.begin(), finished.end()) - start) * host_ns_per_tick() / 1000000000.;
+    report_result(experiment, {{"Mtasks/s", (double) WS_TASKS / seconds / 1000000., HIGHER_IS_BETTER}});
+}
 
-    cuda::atomic<uint16_t, cuda::thread_scope_thread> *flag_thread_acqrel;
-    cuda::atomic<uint16_t, cuda::thread_scope_device> *flag_device_acqrel;
-    cuda::atomic<uint16_t, cuda::thread_scope_system> *flag_system_acqrel;
+// task throughput and steal behaviour per grain as thieves are added
+void work_stealing(Arena &arena, const StealSweep &sweep) {
+    if (arena.kind() == CUDA_MALLOC) {
+        std::cout << "Work stealing needs host-accessible memory" << std::endl;
+        return;
+    }
 
-    if (allocator == CUDA_MALLOC_HOST) {
-        cudaMallocHost(&flag_thread_acqrel, sizeof(cuda::atomic<uint16_t, cuda::thread_scope_thread>));
-        cudaMallocHost(&flag_device_acqrel, sizeof(cuda::atomic<uint16_t, cuda::thread_scope_device>));
-        cudaMallocHost(&flag_system_acqrel, sizeof(cuda::atomic<uint16_t, cuda::thread_scope_system>));
-    } else if (allocator == MALLOC) {
-        flag_thread_acqrel = (cuda::atomic<uint16_t, cuda::thread_scope_thread> *) malloc(sizeof(cuda::atomic<uint16_t, cuda::thread_scope_thread>));
-        flag_device_acqrel = (cuda::atomic<uint16_t, cuda::thread_scope_device> *) malloc(sizeof(cuda::atomic<uint16_t, cuda::thread_scope_device>));
-        flag_system_acqrel = (cuda::atomic<uint16_t, cuda::thread_scope_system> *) malloc(sizeof(cuda::atomic<uint16_t, cuda::thread_scope_system>));
-    } else if (allocator == UM) {
-        cudaMallocManaged(&flag_thread_acqrel, sizeof(cuda::atomic<uint16_t, cuda::thread_scope_thread>));
-        cudaMallocManaged(&flag_device_acqrel, sizeof(cuda::atomic<uint16_t, cuda::thread_scope_device>));
-        cudaMallocManaged(&flag_system_acqrel, sizeof(cuda::atomic<uint16_t, cuda::thread_scope_system>));
+    size_t max_thieves = sweep.max_thieves > 0 ? sweep.max_thieves : std::max<size_t>(1, ring_placements(~(size_t) 0).size()) - 1;
+    for (double grain_ns : sweep.grains_ns) {
+        for (size_t thieves : thief_counts(max_thieves)) {
+            work_stealing_cell<ACQ_REL>(arena, grain_ns, thieves);
+            work_stealing_cell<SEQ_CST>(arena, grain_ns, thieves);
+            static_partition_cell(arena, grain_ns, thieves + 1);
+        }
     }
+}
 
-    std::thread t_system_acqrel(host_pong_function_acqrel_base, (std::atomic<uint16_t> *) flag_system_acqrel);
-    CPU_ZERO(&cpuset);
-    CPU_SET(0, &cpuset); 
-    pthread_setaffinity_np(t_system_acqrel.native_handle(), sizeof(cpu_set_t), &cpuset);
-    
-    clock_t time_system_acqrel;
-    device_ping_kernel_acqrel_base<<<1,1>>>(flag_system_acqrel, &time_system_acqrel);
+std::string rpc_label(const char *clients, size_t count, size_t slots) {
+    return std::string("RPC Host-Server ") + clients + " (" + std::to_string(count) + (count == 1 ? " Client, " : " Clients, ") + std::to_string(slots) + (slots == 1 ? " Slot)" : " Slots)");
+}
 
-    t_system_acqrel.join();
-    cudaDeviceSynchronize();
+void report_rpc(const std::string &experiment, Arena &arena, const uint64_t *latencies, size_t clients, double ns_per_tick, uint64_t elapsed, size_t wrong) {
+    if (wrong > 0) {
+        std::cout << experiment << " got " << wrong << " wrong answers" << std::endl;
+    }
 
-    std::cout << "Device-PING Host-PONG (System, Acq-Rel) | Device : " << ((double) (time_system_acqrel / 10000)) / ((double) get_gpu_freq()) * 1000000. << std::endl;
+    std::vector<uint64_t> ticks(clients * RPC_CALLS);
+    arena.read(latencies, ticks.size(), ticks.data());
+    std::vector<double> sorted;
+    for (uint64_t t : ticks) {
+        sorted.push_back((double) t * ns_per_tick);
+    }
+    std::sort(sorted.begin(), sorted.end());
 
+    double seconds = (double) elapsed * host_ns_per_tick() / 1000000000.;
+    report_result(experiment, {{"p50", percentile(sorted, 0.5)}, {"p99", percentile(sorted, 0.99)}, {"p99.9", percentile(sorted, 0.999)}, {"Mcalls/s", (double) ticks.size() / seconds / 1000000., HIGHER_IS_BETTER}});
+}
 
-    std::thread t_device_acqrel(host_pong_function_acqrel_base, (std::atomic<uint16_t> *) flag_device_acqrel);
-    CPU_ZERO(&cpuset);
-    CPU_SET(0, &cpuset);
-    pthread_setaffinity_np(t_device_acqrel.native_handle(), sizeof(cpu_set_t), &cpuset);
+void rpc_host_clients_cell(Arena &arena, size_t clients, size_t slots) {
+    std::string experiment = rpc_label("Host-Clients", clients, slots);
+    if (!select_cell(experiment, {nullptr, order_name(ACQ_REL), "RPC"})) return;
 
-    clock_t time_device_acqrel;
-    device_ping_kernel_acqrel_base<<<1,1>>>(flag_device_acqrel, &time_device_acqrel);
+    std::vector<CpuPlacement> cpus = ring_placements(clients + 1);
+    if (cpus.size() < clients + 1) {
+        std::cout << "RPC with " << clients << " host clients needs " << clients + 1 << " CPUs, have " << cpus.size() << std::endl;
+        return;
+    }
 
-    t_device_acqrel.join();
-    cudaDeviceSynchronize();
+    arena.reset();
+    RpcSlot *table = arena.slot<RpcSlot>(slots);
+    uint64_t *latencies = arena.slot<uint64_t>(clients * RPC_CALLS);
 
-    std::cout << "Device-PING Host-PONG (Device, Acq-Rel) | Device : " << ((double) (time_device_acqrel / 10000)) / ((double) get_gpu_freq()) * 1000000. << std::endl;
+    uint64_t elapsed;
+    std::vector<size_t> wrong(clients);
+    std::vector<std::thread> threads;
+    threads.push_back(pinned_thread(cpus[0].cpu, rpc_server, table, slots, clients * RPC_CALLS, &elapsed));
+    for (size_t i = 0; i < clients; ++i) {
+        threads.push_back(pinned_thread(cpus[i + 1].cpu, host_rpc_client_function, table, slots, i, latencies + i * RPC_CALLS, &wrong[i]));
+    }
+    for (std::thread &t : threads) {
+        t.join();
+    }
 
+    size_t total_wrong = 0;
+    for (size_t w : wrong) total_wrong += w;
+    report_rpc(experiment, arena, latencies, clients, host_ns_per_tick(), elapsed, total_wrong);
+}
 
-    std::thread t_thread_acqrel(host_pong_function_acqrel_base, (std::atomic<uint16_t> *) flag_thread_acqrel);
-    CPU_ZERO(&cpuset);
-    CPU_SET(0, &cpuset);
-    pthread_setaffinity_np(t_thread_acqrel.native_handle(), sizeof(cpu_set_t), &cpuset);
+void rpc_device_clients_cell(Arena &arena, size_t clients, size_t slots) {
+    std::string experiment = rpc_label("Device-Clients", clients, slots);
+    if (!select_cell(experiment, {scope_name(cuda::thread_scope_system), order_name(ACQ_REL), "RPC"})) return;
 
-    clock_t time_thread_acqrel;
-    device_ping_kernel_acqrel_base<<<1,1>>>(flag_thread_acqrel, &time_thread_acqrel);
+    arena.reset();
+    RpcSlot *table = arena.slot<RpcSlot>(slots);
+    uint64_t *latencies = arena.slot<uint64_t>(clients * RPC_CALLS);
+    unsigned long long *wrong = arena.slot<unsigned long long>();
 
-    t_thread_acqrel.join();
+    uint64_t elapsed;
+    std::thread t = pinned_thread(core_pair().first, rpc_server, table, slots, clients * RPC_CALLS, &elapsed);
+    device_rpc_client_kernel<<<clients, 1>>>(table, slots, latencies, wrong);
+    t.join();
     cudaDeviceSynchronize();
 
-    std::cout << "Device-PING Host-PONG (Thread, Acq-Rel) | Device : " << ((double) (time_thread_acqrel / 10000)) / ((double) get_gpu_freq()) * 1000000. << std::endl;
-
-    if (allocator == MALLOC) {
-        free(flag_thread_relaxed);
-        free(flag_device_relaxed);
-        free(flag_system_relaxed);
-
-        free(flag_thread_acqrel);
-        free(flag_device_acqrel);
-        free(flag_system_acqrel);
-    } else if (allocator == CUDA_MALLOC_HOST) {
-        cudaFreeHost(flag_thread_relaxed);
-        cudaFreeHost(flag_device_relaxed);
-        cudaFreeHost(flag_system_relaxed);
+    report_rpc(experiment, arena, latencies, clients, device_ns_per_tick(), elapsed, (size_t) arena.read(wrong));
+}
 
-        cudaFreeHost(flag_thread_acqrel);
-        cudaFreeHost(flag_device_acqrel);
-        cudaFreeHost(flag_system_acqrel);
-    } else if (allocator == UM) {
-        cudaFree(flag_thread_relaxed);
-        cudaFree(flag_device_relaxed);
-        cudaFree(flag_system_relaxed);
+// call latency and throughput of one host service thread against client and slot counts
+void rpc(Arena &arena, const RpcSweep &sweep) {
+    if (arena.kind() == CUDA_MALLOC) {
+        std::cout << "RPC needs host-accessible memory" << std::endl;
+        return;
+    }
 
-        cudaFree(flag_thread_acqrel);
-        cudaFree(flag_device_acqrel);
-        cudaFree(flag_system_acqrel);
+    for (size_t clients : sweep.clients) {
+        std::vector<size_t> slot_counts = sweep.slots.empty() ? std::vector<size_t>{clients} : sweep.slots;
+        for (size_t slots : slot_counts) {
+            rpc_host_clients_cell(arena, clients, slots);
+            if (platform().has_device) {
+                rpc_device_clients_cell(arena, clients, slots);
+            }
+        }
     }
 }
 
-void device_ping_host_pong_decoupled(Allocator allocator) {
-    cuda::atomic<uint16_t, cuda::thread_scope_thread> *flag_thread_relaxed;
-    cuda::atomic<uint16_t, cuda::thread_scope_device> *flag_device_relaxed;
-    cuda::atomic<uint16_t, cuda::thread_scope_system> *flag_system_relaxed;
+CommandRing command_ring(Arena &arena) {
+    CommandRing ring;
+    ring.doorbell = arena.slot<uint64_t>();
+    ring.done = arena.slot<uint64_t>();
+    ring.commands = arena.slot<uint64_t>(CQ_CAPACITY);
+    ring.results = arena.slot<uint64_t>(CQ_CAPACITY);
+    return ring;
+}
 
-    if (allocator == CUDA_MALLOC_HOST) {
-        cudaMallocHost(&flag_thread_relaxed, sizeof(cuda::atomic<uint16_t, cuda::thread_scope_thread>));
-        cudaMallocHost(&flag_device_relaxed, sizeof(cuda::atomic<uint16_t, cuda::thread_scope_device>));
-        cudaMallocHost(&flag_system_relaxed, sizeof(cuda::atomic<uint16_t, cuda::thread_scope_system>));
-    } else if (allocator == MALLOC) {
-        flag_thread_relaxed = (cuda::atomic<uint16_t, cuda::thread_scope_thread> *) malloc(sizeof(cuda::atomic<uint16_t, cuda::thread_scope_thread>));
-        flag_device_relaxed = (cuda::atomic<uint16_t, cuda::thread_scope_device> *) malloc(sizeof(cuda::atomic<uint16_t, cuda::thread_scope_device>));
-        flag_system_relaxed = (cuda::atomic<uint16_t, cuda::thread_scope_system> *) malloc(sizeof(cuda::atomic<uint16_t, cuda::thread_scope_system>));
-    } else if (allocator == UM) {
-        cudaMallocManaged(&flag_thread_relaxed, sizeof(cuda::atomic<uint16_t, cuda::thread_scope_thread>));
-        cudaMallocManaged(&flag_device_relaxed, sizeof(cuda::atomic<uint16_t, cuda::thread_scope_device>));
-        cudaMallocManaged(&flag_system_relaxed, sizeof(cuda::atomic<uint16_t, cuda::thread_scope_system>));
+void report_command_queue(const std::string &experiment, const std::vector<uint64_t> &latencies, uint64_t elapsed, size_t doorbells) {
+    double ns_per_tick = host_ns_per_tick();
+    std::vector<double> sorted;
+    for (uint64_t ticks : latencies) {
+        sorted.push_back((double) ticks * ns_per_tick);
     }
+    std::sort(sorted.begin(), sorted.end());
 
-    cpu_set_t cpuset;
-
-    clock_t time_system_relaxed;
-    device_ping_kernel_relaxed_decoupled<<<1,1>>>(flag_system_relaxed, &time_system_relaxed);
-    std::thread t_system_relaxed(host_pong_function_relaxed_decoupled, (std::atomic<uint16_t> *) flag_system_relaxed);
-    CPU_ZERO(&cpuset);
-    CPU_SET(0, &cpuset);
-    pthread_setaffinity_np(t_system_relaxed.native_handle(), sizeof(cpu_set_t), &cpuset);
+    double seconds = (double) elapsed * ns_per_tick / 1000000000.;
+    report_result(experiment, {{"p50", percentile(sorted, 0.5)}, {"p99", percentile(sorted, 0.99)}, {"Mcmds/s", (double) latencies.size() / seconds / 1000000., HIGHER_IS_BETTER}, {"Cmds/Doorbell", (double) latencies.size() / (double) doorbells, DESCRIPTIVE}});
+}
 
+void host_command_queue_cell(Arena &arena, const DoorbellPolicy &policy) {
+    std::string experiment = "Command-Queue Host-Producer Host-Consumer (" + doorbell_name(policy) + ")";
+    if (!select_cell(experiment, {nullptr, order_name(ACQ_REL), "Queue"})) return;
 
-    cudaDeviceSynchronize();
-    t_system_relaxed.join();
+    arena.reset();
+    CommandRing ring = command_ring(arena);
 
-    std::cout << "Device-PING Host-PONG (System, Relaxed, Decoupled) | Device : " << ((double) (time_system_relaxed / 10000)) / ((double) get_gpu_freq()) * 1000000. << std::endl;
+    std::vector<uint64_t> latencies;
+    uint64_t elapsed;
+    size_t doorbells;
+    std::thread t_producer = pinned_thread(core_pair().first, command_producer, ring, policy, CQ_COMMANDS, &latencies, &elapsed, &doorbells);
+    std::thread t_consumer = pinned_thread(core_pair().second, host_command_consumer_function, ring, CQ_COMMANDS);
+    t_producer.join();
+    t_consumer.join();
 
+    report_command_queue(experiment, latencies, elapsed, doorbells);
+}
 
-    clock_t time_device_relaxed;
-    device_ping_kernel_relaxed_decoupled<<<1,1>>>(flag_device_relaxed, &time_device_relaxed);
-    std::thread t_device_relaxed(host_pong_function_relaxed_decoupled, (std::atomic<uint16_t> *) flag_device_relaxed);
-    CPU_ZERO(&cpuset);
-    CPU_SET(0, &cpuset);
-    pthread_setaffinity_np(t_device_relaxed.native_handle(), sizeof(cpu_set_t), &cpuset);
+template <cuda::thread_scope Scope>
+void device_command_queue_cell(Arena &arena, const DoorbellPolicy &policy) {
+    std::string experiment = std::string("Command-Queue Host-Producer Device-Consumer (") + scope_name(Scope) + ", " + doorbell_name(policy) + ")";
+    if (!select_cell(experiment, {scope_name(Scope), order_name(ACQ_REL), "Queue"})) return;
 
+    arena.reset();
+    CommandRing ring = command_ring(arena);
 
+    std::vector<uint64_t> latencies;
+    uint64_t elapsed;
+    size_t doorbells;
+    std::thread t = pinned_thread(core_pair().first, command_producer, ring, policy, CQ_COMMANDS, &latencies, &elapsed, &doorbells);
+    device_command_consumer_kernel<Scope><<<1,1>>>(ring.doorbell, ring.done, ring.commands, ring.results, CQ_COMMANDS);
+    t.join();
     cudaDeviceSynchronize();
-    t_device_relaxed.join();
-
-    std::cout << "Device-PING Host-PONG (Device, Relaxed, Decoupled) | Device : " << ((double) (time_device_relaxed / 10000)) / ((double) get_gpu_freq()) * 1000000. << std::endl;
 
+    report_command_queue(experiment, latencies, elapsed, doorbells);
+}
 
-    // std::thread t_thread_relaxed(host_pong_function_relaxed_decoupled, (std::atomic<uint16_t> *) flag_thread_relaxed);
-    // CPU_ZERO(&cpuset);
-    // CPU_SET(0, &cpuset);
-    // pthread_setaffinity_np(t_thread_relaxed.native_handle(), sizeof(cpu_set_t), &cpuset);
-
-    // clock_t time_thread_relaxed;
-    // device_ping_kernel_relaxed_decoupled<<<1,1>>>(flag_thread_relaxed, &time_thread_relaxed);
-
-    // t_thread_relaxed.join();
-    // cudaDeviceSynchronize();
-
-    // std::cout << "Device-PING Host-PONG (Thread, Relaxed, Decoupled) | Device : " << ((double) (time_thread_relaxed / 10000)) / ((double) get_gpu_freq()) * 1000000. << std::endl;
-
-
-    cuda::atomic<uint16_t, cuda::thread_scope_thread> *flag_thread_acqrel;
-    cuda::atomic<uint16_t, cuda::thread_scope_device> *flag_device_acqrel;
-    cuda::atomic<uint16_t, cuda::thread_scope_system> *flag_system_acqrel;
-
-    if (allocator == CUDA_MALLOC_HOST) {
-        cudaMallocHost(&flag_thread_acqrel, sizeof(cuda::atomic<uint16_t, cuda::thread_scope_thread>));
-        cudaMallocHost(&flag_device_acqrel, sizeof(cuda::atomic<uint16_t, cuda::thread_scope_device>));
-        cudaMallocHost(&flag_system_acqrel, sizeof(cuda::atomic<uint16_t, cuda::thread_scope_system>));
-    } else if (allocator == MALLOC) {
-        flag_thread_acqrel = (cuda::atomic<uint16_t, cuda::thread_scope_thread> *) malloc(sizeof(cuda::atomic<uint16_t, cuda::thread_scope_thread>));
-        flag_device_acqrel = (cuda::atomic<uint16_t, cuda::thread_scope_device> *) malloc(sizeof(cuda::atomic<uint16_t, cuda::thread_scope_device>));
-        flag_system_acqrel = (cuda::atomic<uint16_t, cuda::thread_scope_system> *) malloc(sizeof(cuda::atomic<uint16_t, cuda::thread_scope_system>));
-    } else if (allocator == UM) {
-        cudaMallocManaged(&flag_thread_acqrel, sizeof(cuda::atomic<uint16_t, cuda::thread_scope_thread>));
-        cudaMallocManaged(&flag_device_acqrel, sizeof(cuda::atomic<uint16_t, cuda::thread_scope_device>));
-        cudaMallocManaged(&flag_system_acqrel, sizeof(cuda::atomic<uint16_t, cuda::thread_scope_system>));
+// dispatch latency and throughput per doorbell policy, device consumer when there is one
+void command_queue(Arena &arena, const std::vector<DoorbellPolicy> &policies) {
+    if (arena.kind() == CUDA_MALLOC) {
+        std::cout << "Command queue needs host-accessible memory" << std::endl;
+        return;
     }
 
-    clock_t time_system_acqrel;
-    device_ping_kernel_acqrel_decoupled<<<1,1>>>(flag_system_acqrel, &time_system_acqrel);
-    std::thread t_system_acqrel(host_pong_function_acqrel_decoupled, (std::atomic<uint16_t> *) flag_system_acqrel);
-    CPU_ZERO(&cpuset);
-    CPU_SET(0, &cpuset); 
-    pthread_setaffinity_np(t_system_acqrel.native_handle(), sizeof(cpu_set_t), &cpuset);
-    
-
-    cudaDeviceSynchronize();
-    t_system_acqrel.join();
-
-    std::cout << "Device-PING Host-PONG (System, Acq-Rel, Decoupled) | Device : " << ((double) (time_system_acqrel / 10000)) / ((double) get_gpu_freq()) * 1000000. << std::endl;
-
+    for (const DoorbellPolicy &policy : policies) {
+        host_command_queue_cell(arena, policy);
+        if (platform().has_device) {
+            device_command_queue_cell<cuda::thread_scope_system>(arena, policy);
+        }
+    }
+}
 
-    clock_t time_device_acqrel;
-    device_ping_kernel_acqrel_decoupled<<<1,1>>>(flag_device_acqrel, &time_device_acqrel);
-    std::thread t_device_acqrel(host_pong_function_acqrel_decoupled, (std::atomic<uint16_t> *) flag_device_acqrel);
-    CPU_ZERO(&cpuset);
-    CPU_SET(0, &cpuset);
-    pthread_setaffinity_np(t_device_acqrel.native_handle(), sizeof(cpu_set_t), &cpuset);
+void channels_cell(Arena &arena, size_t channels, bool coroutines) {
+    // thread-per-channel: pinger and ponger of channel i on CPUs 2i and 2i + 1 in ring order, wrapping once they run out
+    std::vector<CpuPlacement> cpus = ring_placements(2 * channels);
+    bool oversubscribed = !coroutines && cpus.size() < 2 * channels;
+
+    std::string experiment = std::string("Channels ") + (coroutines ? "Coroutine" : "Thread-Per-Channel") + " (" + std::to_string(channels) + (channels == 1 ? " Channel" : " Channels")
+        + (oversubscribed ? ", Oversubscribed " + std::to_string(cpus.size()) + (cpus.size() == 1 ? " CPU)" : " CPUs)") : ")");
+    if (!select_cell(experiment, {nullptr, order_name(ACQ_REL), "Multiplex"})) return;
+
+    arena.reset();
+    uint64_t *go = arena.slot<uint64_t>();
+    std::vector<uint32_t *> flags;
+    for (size_t i = 0; i < channels; ++i) {
+        flags.push_back(arena.slot<uint32_t>());
+    }
+
+    size_t rounds = channel_rounds(channels);
+    std::vector<uint64_t> latencies(channels * rounds);
+    std::vector<uint64_t> finished(channels, 0);
+    std::vector<std::thread> threads;
+    if (coroutines) {
+        threads.push_back(pinned_thread(core_pair().first, coroutine_pinger, go, std::cref(flags), rounds, latencies.data(), &finished[0]));
+        threads.push_back(pinned_thread(core_pair().second, coroutine_ponger, go, std::cref(flags), rounds));
+    } else {
+        for (size_t i = 0; i < channels; ++i) {
+            threads.push_back(pinned_thread(cpus[2 * i % cpus.size()].cpu, threaded_pinger, go, flags[i], rounds, latencies.data() + i * rounds, &finished[i]));
+            threads.push_back(pinned_thread(cpus[(2 * i + 1) % cpus.size()].cpu, threaded_ponger, go, flags[i], rounds));
+        }
+    }
 
+    uint64_t start = get_cpu_clock();
+    std::atomic_ref<uint64_t>(*go).store(1, std::memory_order_release);
+    for (std::thread &t : threads) {
+        t.join();
+    }
 
-    cudaDeviceSynchronize();
-    t_device_acqrel.join();
+    double ns_per_tick = host_ns_per_tick();
+    std::vector<double> sorted;
+    for (uint64_t ticks : latencies) {
+        sorted.push_back((double) ticks * ns_per_tick);
+    }
+    std::sort(sorted.begin(), sorted.end());
 
-    std::cout << "Device-PING Host-PONG (Device, Acq-Rel, Decoupled) | Device : " << ((double) (time_device_acqrel / 10000)) / ((double) get_gpu_freq()) * 1000000. << std::endl;
+    double seconds = (double) (*std::max_element(finished.begin(), finished.end()) - start) * ns_per_tick / 1000000000.;
+    report_result(experiment, {{"p50", percentile(sorted, 0.5)}, {"p99", percentile(sorted, 0.99)}, {"Mtrips/s", (double) latencies.size() / seconds / 1000000., HIGHER_IS_BETTER}});
+}
 
+// round-trip latency and throughput against channel count, coroutines on one thread per side versus a thread per channel
+void channels(Arena &arena, const std::vector<size_t> &counts) {
+    if (arena.kind() == CUDA_MALLOC) {
+        std::cout << "Channels need host-accessible memory" << std::endl;
+        return;
+    }
 
-    // std::thread t_thread_acqrel(host_pong_function_acqrel_decoupled, (std::atomic<uint16_t> *) flag_thread_acqrel);
-    // CPU_ZERO(&cpuset);
-    // CPU_SET(0, &cpuset);
-    // pthread_setaffinity_np(t_thread_acqrel.native_handle(), sizeof(cpu_set_t), &cpuset);
+    for (size_t count : counts) {
+        channels_cell(arena, count, true);
+        if (count <= CORO_MAX_THREADED) {
+            channels_cell(arena, count, false);
+        }
+    }
+}
 
-    // clock_t time_thread_acqrel;
-    // device_ping_kernel_acqrel_decoupled<<<1,1>>>(flag_thread_acqrel, &time_thread_acqrel);
+// one latency-vs-throughput curve per consumer
+void open_loop(Arena &arena, const LoadSweep &sweep) {
+    if (arena.kind() == CUDA_MALLOC) {
+        std::cout << "Open-loop load needs host-accessible memory" << std::endl;
+        return;
+    }
 
-    // t_thread_acqrel.join();
-    // cudaDeviceSynchronize();
+    for (double rate : sweep.rates) {
+        host_producer_host_consumer_cell(arena, sweep.schedule, rate);
+    }
 
-    // std::cout << "Device-PING Host-PONG (Thread, Acq-Rel, Decoupled) | Device : " << ((double) (time_thread_acqrel / 10000)) / ((double) get_gpu_freq()) * 1000000. << std::endl;
+    if (platform().has_device) {
+        for (double rate : sweep.rates) {
+            host_producer_device_consumer_cell<cuda::thread_scope_system>(arena, sweep.schedule, rate);
+        }
+    }
+}
 
-    if (allocator == MALLOC) {
-        free(flag_thread_relaxed);
-        free(flag_device_relaxed);
-        free(flag_system_relaxed);
+// one-way latency needs both agents to see the flag and the stamps from the host side
+void one_way(Arena &arena) {
+    if (arena.kind() == CUDA_MALLOC) {
+        std::cout << "One-way latency needs host-accessible memory" << std::endl;
+        return;
+    }
 
-        free(flag_thread_acqrel);
-        free(flag_device_acqrel);
-        free(flag_system_acqrel);
-    } else if (allocator == CUDA_MALLOC_HOST) {
-        cudaFreeHost(flag_thread_relaxed);
-        cudaFreeHost(flag_device_relaxed);
-        cudaFreeHost(flag_system_relaxed);
+    host_host_one_way_cell(arena);
 
-        cudaFreeHost(flag_thread_acqrel);
-        cudaFreeHost(flag_device_acqrel);
-        cudaFreeHost(flag_system_acqrel);
-    } else if (allocator == UM) {
-        cudaFree(flag_thread_relaxed);
-        cudaFree(flag_device_relaxed);
-        cudaFree(flag_system_relaxed);
+    if (platform().has_device) {
+        host_device_one_way_cell<cuda::thread_scope_system>(arena);
+    }
+}
 
-        cudaFree(flag_thread_acqrel);
-        cudaFree(flag_device_acqrel);
-        cudaFree(flag_system_acqrel);
+void host_ping_simulated_pong(Arena &arena, const LatencyModel &model) {
+    if (arena.kind() == CUDA_MALLOC) {
+        std::cout << "Host-PING Simulated-PONG needs host-accessible memory" << std::endl;
+        return;
     }
+
+    host_ping_simulated_pong_cell<RELAXED, BASE>(arena, model);
+    host_ping_simulated_pong_cell<ACQ_REL, BASE>(arena, model);
+    host_ping_simulated_pong_cell<RELAXED, DECOUPLED>(arena, model);
+    host_ping_simulated_pong_cell<ACQ_REL, DECOUPLED>(arena, model);
 }
 
-#endif // CPU_PINGPONG_HPP
\ No newline at end of file
+#endif // CPU_PINGPONG_HPP
@@ -3,22 +3,55 @@
 
 #include <iostream>
 
+#if defined(__x86_64__)
+#include <time.h>
+#include <x86intrin.h>
+#endif
+
 constexpr size_t cpu_cacheline = 64;
 constexpr size_t gpu_cacheline = 128;
 
+#if defined(__x86_64__)
+// the TSC rate is not architecturally visible, so it is measured against CLOCK_MONOTONIC_RAW
+uint64_t calibrate_tsc_freq() {
+    timespec start_ts, end_ts;
+    clock_gettime(CLOCK_MONOTONIC_RAW, &start_ts);
+    uint64_t start = __rdtsc();
+
+    do {
+        clock_gettime(CLOCK_MONOTONIC_RAW, &end_ts);
+    } while ((end_ts.tv_sec - start_ts.tv_sec) * 1000000000ll + (end_ts.tv_nsec - start_ts.tv_nsec) < 50000000ll);
+
+    uint64_t end = __rdtsc();
+    double ns = (double) ((end_ts.tv_sec - start_ts.tv_sec) * 1000000000ll + (end_ts.tv_nsec - start_ts.tv_nsec));
+
+    return (uint64_t) ((double) (end - start) * 1000000000. / ns);
+}
+#endif
+
 __attribute__((always_inline)) inline uint64_t get_cpu_clock() {
     uint64_t tsc;
 
+#if defined(__x86_64__)
+    _mm_lfence();
+    tsc = __rdtsc();
+    _mm_lfence();
+#else
     asm volatile("isb" : : : "memory");
     asm volatile("mrs %0, cntvct_el0" : "=r"(tsc) :: "memory"); // alternative is cntpct_el0
+#endif
 
     return tsc;
 }
 
 __attribute__((always_inline)) inline uint64_t get_cpu_freq() {
+#if defined(__x86_64__)
+    static const uint64_t freq = calibrate_tsc_freq();
+#else
     uint64_t freq;
 
     asm volatile("mrs %0, cntfrq_el0" : "=r"(freq) :: "memory");
+#endif
 
     return freq;
 }
@@ -31,11 +64,19 @@ __attribute__((always_inline)) __device__ inline clock_t get_gpu_clock() {
     return tsc;
 }
 
-int get_gpu_freq() {
-    cudaDeviceProp deviceProperties;
-    cudaGetDeviceProperties(&deviceProperties, 0);
+// queried once; every result line used to call cudaGetDeviceProperties
+const cudaDeviceProp &get_device_properties() {
+    static cudaDeviceProp deviceProperties = [] {
+        cudaDeviceProp properties = {};
+        cudaGetDeviceProperties(&properties, 0);
+        return properties;
+    }();
 
-    return deviceProperties.clockRate;
+    return deviceProperties;
+}
+
+int get_gpu_freq() {
+    return get_device_properties().clockRate;
 }
 
 #endif
\ No newline at end of file
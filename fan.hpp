@@ -0,0 +1,107 @@
+#ifndef FAN_HPP
+#define FAN_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "cpu_utils.hpp"
+
+/**
+ * Broadcast and gather across N host workers.
+ *
+ * Each round the coordinator bumps one shared go flag and waits until all N
+ * workers have signalled back, each into its own line (Flags) or through a
+ * fetch_add on one shared counter (Counter). From the go store, the last
+ * worker's stamp is the fan-out time and the last signal seen the total;
+ * fan-in runs from the first worker's stamp to the last signal seen.
+ * */
+
+constexpr size_t FAN_ROUNDS = 1000;
+
+enum FanSignal {
+    FAN_FLAGS,
+    FAN_COUNTER
+};
+
+const char *fan_signal_name(FanSignal signal) {
+    return signal == FAN_FLAGS ? "Flags" : "Counter";
+}
+
+bool parse_fan_sweep(const char *spec, std::vector<size_t> *workers) {
+    workers->clear();
+    std::istringstream list(spec);
+    std::string count;
+    while (std::getline(list, count, ',')) {
+        int value = atoi(count.c_str());
+        if (value < 1) {
+            return false;
+        }
+        workers->push_back((size_t) value);
+    }
+    return !workers->empty();
+}
+
+// a worker's own line: when it saw each round, and (FAN_FLAGS) the last round it signalled
+enum FanSlot {
+    FAN_SEEN,
+    FAN_ACK,
+    FAN_SLOTS
+};
+
+void fan_worker(uint64_t *go_ptr, uint64_t *own, uint64_t *counter_ptr, FanSignal signal, size_t rounds) {
+    std::atomic_ref<uint64_t> go(*go_ptr);
+    std::atomic_ref<uint64_t> ack(own[FAN_ACK]);
+    std::atomic_ref<uint64_t> counter(*counter_ptr);
+
+    for (uint64_t round = 1; round <= rounds; ++round) {
+        while (go.load(std::memory_order_acquire) < round);
+        own[FAN_SEEN] = get_cpu_clock();
+        if (signal == FAN_FLAGS) {
+            ack.store(round, std::memory_order_release);
+        } else {
+            counter.fetch_add(1, std::memory_order_acq_rel);
+        }
+    }
+}
+
+// CPU ticks after the go store; a stamp taken on another core can come out slightly negative
+struct FanRound {
+    int64_t first_seen;
+    int64_t last_seen;
+    int64_t collected;
+};
+
+void fan_coordinator(uint64_t *go_ptr, const std::vector<uint64_t *> &workers, uint64_t *counter_ptr, FanSignal signal, size_t rounds, std::vector<FanRound> *results) {
+    std::atomic_ref<uint64_t> go(*go_ptr);
+    std::atomic_ref<uint64_t> counter(*counter_ptr);
+    results->assign(rounds, {});
+
+    for (uint64_t round = 1; round <= rounds; ++round) {
+        uint64_t start = get_cpu_clock();
+        go.store(round, std::memory_order_release);
+
+        if (signal == FAN_FLAGS) {
+            for (uint64_t *own : workers) {
+                std::atomic_ref<uint64_t> ack(own[FAN_ACK]);
+                while (ack.load(std::memory_order_acquire) < round);
+            }
+        } else {
+            while (counter.load(std::memory_order_acquire) < round * workers.size());
+        }
+        uint64_t collected = get_cpu_clock();
+
+        uint64_t first = ~0ull, last = 0;
+        for (uint64_t *own : workers) {
+            first = std::min(first, own[FAN_SEEN]);
+            last = std::max(last, own[FAN_SEEN]);
+        }
+        (*results)[round - 1] = {(int64_t) (first - start), (int64_t) (last - start), (int64_t) (collected - start)};
+    }
+}
+
+#endif // FAN_HPP
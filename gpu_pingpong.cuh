@@ -3,272 +3,75 @@
 
 // #include "gpu_data_functions.cuh"
 #include "structs.cuh"
+#include "command_queue.cuh"
+#include "pingpong_protocols.cuh"
+#include "rpc.cuh"
 
-#define PING 1
-#define PONG 0
-#define PANG 2
-
-template <typename T, typename S>
-__global__ void device_fetch_add_relaxed(T *flag, S *sig, clock_t *time) {
-    // sig->store(PING);
-
-    sig->fetch_add(PING);
-    while(sig->load() != PANG);
-
-    clock_t start = clock64();
-    for (size_t i = 0; i < 10000; ++i) {
-        flag->fetch_add(1, cuda::memory_order_relaxed);
-    }
-    clock_t end = clock64();
-
-    *time = end - start;
-}
-
-template <typename T, typename S>
-__global__ void device_fetch_add_acqrel(T *flag, S *sig, clock_t *time) {
-    // sig->store(PING);
-
-    sig->fetch_add(PING);
-    while(sig->load() != PANG);
-
-    clock_t start = clock64();
-    for (size_t i = 0; i < 10000; ++i) {
-        flag->fetch_add(1, cuda::memory_order_acq_rel);
-    }
-    clock_t end = clock64();
-
-    *time = end - start;
-}
-
-template <typename T, typename S>
-__global__ void device_fetch_add_seqcst(T *flag, S *sig, clock_t *time) {
-    // sig->store(PING);
-
-    sig->fetch_add(PING);
-    while(sig->load() != PANG);
-
-    clock_t start = clock64();
-    for (size_t i = 0; i < 10000; ++i) {
-        flag->fetch_add(1, cuda::memory_order_seq_cst);
-    }
-    clock_t end = clock64();
-
-    *time = end - start;
-}
-template <typename T, typename S>
-__global__ void device_fetch_add_relaxed_store(T *flag, S *sig, clock_t *time) {
-    sig->store(PING);
-
-    // sig->fetch_add(PING);
-    // while(sig->load() != PANG);
-
-    clock_t start = clock64();
-    for (size_t i = 0; i < 10000; ++i) {
-        flag->fetch_add(1, cuda::memory_order_relaxed);
-    }
-    clock_t end = clock64();
-
-    *time = end - start;
-}
-
-template <typename T, typename S>
-__global__ void device_fetch_add_acqrel_store(T *flag, S *sig, clock_t *time) {
-    sig->store(PING);
-
-    // sig->fetch_add(PING);
-    // while(sig->load() != PANG);
-
-    clock_t start = clock64();
-    for (size_t i = 0; i < 10000; ++i) {
-        flag->fetch_add(1, cuda::memory_order_acq_rel);
-    }
-    clock_t end = clock64();
-
-    *time = end - start;
-}
-
-template <typename T, typename S>
-__global__ void device_fetch_add_seqcst_store(T *flag, S *sig, clock_t *time) {
-    sig->store(PING);
-
-    // sig->fetch_add(PING);
-    // while(sig->load() != PANG);
-
-    clock_t start = clock64();
-    for (size_t i = 0; i < 10000; ++i) {
-        flag->fetch_add(1, cuda::memory_order_seq_cst);
-    }
-    clock_t end = clock64();
-
-    *time = end - start;
+template <cuda::thread_scope Scope, MemOrder Order, FetchAddStart Start>
+__global__ void device_fetch_add_kernel(uint32_t *flag, uint32_t *sig, clock_t *time, size_t iterations) {
+    DeviceAgent<Scope> agent;
+    agent.iterations = iterations;
+    fetch_add_protocol<DeviceAgent<Scope>, Order, Start>(agent, flag, sig, time);
 }
-template <typename T, typename S>
-__global__ void device_fetch_add_relaxed_wait(T *flag, S *sig, clock_t *time) {
-    // sig->store(PING);
-
-    while(sig->load() != PING);
 
-    // sig->fetch_add(PING);
-    // while(sig->load() != PANG);
-
-    clock_t start = clock64();
-    for (size_t i = 0; i < 10000; ++i) {
-        flag->fetch_add(1, cuda::memory_order_relaxed);
-    }
-    clock_t end = clock64();
-
-    *time = end - start;
-}
-
-template <typename T, typename S>
-__global__ void device_fetch_add_acqrel_wait(T *flag, S *sig, clock_t *time) {
-    // sig->store(PING);
-
-    while(sig->load() != PING);
-
-    // sig->fetch_add(PING);
-    // while(sig->load() != PANG);
-
-    clock_t start = clock64();
-    for (size_t i = 0; i < 10000; ++i) {
-        flag->fetch_add(1, cuda::memory_order_acq_rel);
-    }
-    clock_t end = clock64();
-
-    *time = end - start;
-}
-
-template <typename T, typename S>
-__global__ void device_fetch_add_seqcst_wait(T *flag, S *sig, clock_t *time) {
-    // sig->store(PING);
-
-    while(sig->load() != PING);
-
-    // sig->fetch_add(PING);
-    // while(sig->load() != PANG);
-
-    clock_t start = clock64();
-    for (size_t i = 0; i < 10000; ++i) {
-        flag->fetch_add(1, cuda::memory_order_seq_cst);
-    }
-    clock_t end = clock64();
-
-    *time = end - start;
+// change ping to pong
+template <cuda::thread_scope Scope, MemOrder Order, PingPongProtocol Protocol>
+__global__ void device_ping_kernel(uint32_t *flag, clock_t *time, uint64_t *trace, size_t iterations) {
+    DeviceAgent<Scope> agent;
+    agent.trace = trace;
+    agent.iterations = iterations;
+    ping_protocol<DeviceAgent<Scope>, Order, Protocol>(agent, flag, time);
 }
 
 // change pong to ping
-template <typename T>
-__global__ void device_pong_kernel_relaxed_base(T *flag) {
-    flag->store(PING, cuda::memory_order_relaxed);
-    uint16_t expected = PONG;
-    for (size_t i = 0; i < 10000; ++i) {
-        while( !flag->compare_exchange_strong(expected, PING, cuda::std::memory_order_relaxed, cuda::std::memory_order_relaxed)) {
-            expected = PONG;
-        }
-    }
-}
-
-// https://stackoverflow.com/questions/60624189/atomic-compare-exchange-strong-explicit-what-do-the-various-combinations
-template <typename T>
-__global__ void device_pong_kernel_acqrel_base(T *flag) {
-    flag->store(PING, cuda::memory_order_relaxed);
-    uint16_t expected = PONG;
-    for (size_t i = 0; i < 10000; ++i) {
-        while( !flag->compare_exchange_strong(expected, PING, cuda::std::memory_order_acq_rel, cuda::std::memory_order_acquire)) {
-            expected = PONG;
-        }
-    }
+template <cuda::thread_scope Scope, MemOrder Order, PingPongProtocol Protocol>
+__global__ void device_pong_kernel(uint32_t *flag, uint64_t *trace, size_t iterations) {
+    DeviceAgent<Scope> agent;
+    agent.trace = trace;
+    agent.iterations = iterations;
+    pong_protocol<DeviceAgent<Scope>, Order, Protocol>(agent, flag);
 }
 
-template <typename T>
-__global__ void device_pong_kernel_relaxed_decoupled(T *flag) {
-    flag->store(PING, cuda::memory_order_relaxed);
-    uint16_t expected = PONG;
-    for (size_t i = 0; i < 10000; ++i) {
-        while (flag->load(cuda::memory_order_relaxed) != expected) {
-            expected = PONG;
-        }
-        // *data = i * 32;
-        flag->store(PING, cuda::memory_order_relaxed);
-    }
+template <cuda::thread_scope Scope>
+__global__ void device_ping_one_way_kernel(uint32_t *flag, uint64_t *message, uint64_t *arrivals) {
+    DeviceAgent<Scope> agent;
+    ping_one_way_protocol<DeviceAgent<Scope>>(agent, flag, message, arrivals);
 }
 
-template <typename T>
-__global__ void device_pong_kernel_acqrel_decoupled(T* flag) {
-    flag->store(PING, cuda::memory_order_relaxed);
-    uint16_t expected = PONG;
-    for (size_t i = 0; i < 10000; ++i) {
-        while (flag->load(cuda::memory_order_acquire) != expected) {
-            expected = PONG;
-        }
-        // *data = i * 32;
-        flag->store(PING, cuda::memory_order_release);
-    }
+template <cuda::thread_scope Scope>
+__global__ void device_pong_one_way_kernel(uint32_t *flag, uint64_t *message, uint64_t *arrivals) {
+    DeviceAgent<Scope> agent;
+    pong_one_way_protocol<DeviceAgent<Scope>>(agent, flag, message, arrivals);
 }
 
-
-template <typename T>
-__global__ void device_ping_kernel_relaxed_base(T *flag, clock_t *time) {
-    uint16_t expected = PING;
-    while (flag->load(cuda::memory_order_relaxed) == PONG);
-
-    clock_t start = clock64();
-    for (size_t i = 0; i < 10000; ++i) {
-        while (!flag->compare_exchange_strong(expected, PONG, cuda::std::memory_order_relaxed, cuda::std::memory_order_relaxed)) {
-            expected = PING;
-        }
-    }
-    clock_t end = clock64();
-    *time = end - start;
+template <cuda::thread_scope Scope>
+__global__ void device_open_loop_consumer_kernel(uint64_t *head, uint64_t *done, uint64_t *requests, uint64_t *responses, size_t capacity, size_t count) {
+    DeviceAgent<Scope> agent;
+    agent.iterations = count;
+    open_loop_consumer_protocol<DeviceAgent<Scope>>(agent, head, done, requests, responses, capacity);
 }
 
-template <typename T>
-__global__ void device_ping_kernel_acqrel_base(T *flag, clock_t *time) {
-    uint16_t expected = PING;
-    while (flag->load(cuda::memory_order_relaxed) == PONG); // S
-
-    clock_t start = clock64();
-    for (size_t i = 0; i < 10000; ++i) {
-        while (!flag->compare_exchange_strong(expected, PONG, cuda::std::memory_order_acq_rel, cuda::std::memory_order_acquire)) {
-            expected = PING;
-        }
-    }
-    clock_t end = clock64();
-    *time = end - start;
+// started once, serves every command of the run
+template <cuda::thread_scope Scope>
+__global__ void device_command_consumer_kernel(uint64_t *doorbell, uint64_t *done, uint64_t *commands, uint64_t *results, size_t count) {
+    DeviceAgent<Scope> agent;
+    agent.iterations = count;
+    command_consumer_protocol<DeviceAgent<Scope>>(agent, doorbell, done, commands, results);
 }
 
-template <typename T>
-__global__ void device_ping_kernel_relaxed_decoupled(T* flag, clock_t *time) {
-    uint16_t expected = PING;
-    while (flag->load(cuda::memory_order_relaxed) == PONG);
-
-    clock_t start = clock64();
-    for (size_t i = 0; i < 10000; ++i) {
-        while (flag->load(cuda::memory_order_relaxed) != expected) {
-            expected = PING;
-        }
-        // *data = i * 32;
-        flag->store(PONG, cuda::memory_order_relaxed);
-    }
-    clock_t end = clock64();
-    *time = end - start;
+// one RPC client per block; client b's latencies go to latencies[b * RPC_CALLS ...]
+__global__ void device_rpc_client_kernel(RpcSlot *table, size_t slots, uint64_t *latencies, unsigned long long *wrong) {
+    DeviceAgent<cuda::thread_scope_system> agent;
+    agent.iterations = RPC_CALLS;
+    size_t client = blockIdx.x;
+    atomicAdd(wrong, (unsigned long long) rpc_client_protocol(agent, table, slots, client, latencies + client * RPC_CALLS));
 }
 
-template <typename T>
-__global__ void device_ping_kernel_acqrel_decoupled(T *flag, clock_t *time) {
-    uint16_t expected = PING;
-    while (flag->load(cuda::memory_order_relaxed) == PONG);
-
-    clock_t start = clock64();
-    for (size_t i = 0; i < 10000; ++i) {
-        while (flag->load(cuda::memory_order_acquire) != expected) {
-            expected = PING;
-        }
-        // *data = i * 32;
-        flag->store(PONG, cuda::memory_order_release);
-    }
-    clock_t end = clock64();
-    *time = end - start;
+template <bool TraceClock>
+__global__ void device_clock_calibration_kernel(uint64_t *out, size_t reads, size_t iterations) {
+    DeviceAgent<cuda::thread_scope_system> agent;
+    agent.iterations = iterations;
+    clock_calibration_protocol<DeviceAgent<cuda::thread_scope_system>, TraceClock>(agent, out, reads);
 }
 
-#endif // GPU_PINGPONG_CUH  
\ No newline at end of file
+#endif // GPU_PINGPONG_CUH
@@ -0,0 +1,186 @@
+#ifndef IDLE_GAP_HPP
+#define IDLE_GAP_HPP
+
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "cpu_utils.hpp"
+#include "platform.hpp"
+
+/**
+ * Wake-up latency after an idle gap.
+ *
+ * A spinning agent never lets its core sleep, so the ping/pong cells never
+ * pay for waking one up. Here the responder waits for each request (spin,
+ * futex, nanosleep or monitor) and the sender sends one per gap. The
+ * sender naps through all but IDLE_SLEEP_MARGIN_US of a long gap whatever
+ * the wait, so only a spinning responder is held to zero voluntary
+ * switches.
+ * */
+
+constexpr size_t IDLE_ROUNDS = 200;
+constexpr size_t IDLE_MIN_ROUNDS = 10;
+constexpr double IDLE_BUDGET_US = 1000000.;
+constexpr double IDLE_SLEEP_MARGIN_US = 200.;      // the sender spins out the last of a gap
+constexpr long IDLE_NANOSLEEP_NS = 1000;
+const double IDLE_GAPS_US[] = {1., 10., 100., 1000., 10000., 100000.};
+
+enum IdleWait {
+    WAIT_SPIN,
+    WAIT_FUTEX,
+    WAIT_NANOSLEEP,
+    WAIT_MONITOR
+};
+
+struct IdleSweep {
+    IdleWait wait = WAIT_SPIN;
+    std::vector<double> gaps_us;
+};
+
+const char *idle_wait_name(IdleWait wait) {
+    switch (wait) {
+        case WAIT_SPIN: return "Spin";
+        case WAIT_FUTEX: return "Futex";
+        case WAIT_NANOSLEEP: return "Nanosleep";
+        case WAIT_MONITOR: return "Monitor";
+    }
+    return "Unknown";
+}
+
+#if defined(__aarch64__) || defined(__WAITPKG__)
+constexpr bool monitor_wait_available = true;
+#else
+constexpr bool monitor_wait_available = false;
+#endif
+
+bool parse_idle_sweep(const char *spec, IdleSweep *sweep) {
+    const char *gaps = strchr(spec, ':');
+    std::string wait(spec, gaps == nullptr ? strlen(spec) : (size_t) (gaps - spec));
+    if (wait == "spin") {
+        sweep->wait = WAIT_SPIN;
+    } else if (wait == "futex") {
+        sweep->wait = WAIT_FUTEX;
+    } else if (wait == "nanosleep") {
+        sweep->wait = WAIT_NANOSLEEP;
+    } else if (wait == "monitor" && monitor_wait_available) {
+        sweep->wait = WAIT_MONITOR;
+    } else {
+        return false;
+    }
+
+    sweep->gaps_us.clear();
+    if (gaps == nullptr) {
+        sweep->gaps_us.assign(std::begin(IDLE_GAPS_US), std::end(IDLE_GAPS_US));
+        return true;
+    }
+
+    std::istringstream list(gaps + 1);
+    std::string gap;
+    while (std::getline(list, gap, ',')) {
+        double value = atof(gap.c_str());
+        if (value <= 0.) {
+            return false;
+        }
+        sweep->gaps_us.push_back(value);
+    }
+    return !sweep->gaps_us.empty();
+}
+
+size_t idle_rounds(double gap_us) {
+    return std::max(IDLE_MIN_ROUNDS, std::min(IDLE_ROUNDS, (size_t) (IDLE_BUDGET_US / gap_us)));
+}
+
+// blocks until *word == value
+void idle_wait(IdleWait wait, uint32_t *word, uint32_t value) {
+    std::atomic_ref<uint32_t> ref(*word);
+    uint32_t seen;
+    while ((seen = ref.load(std::memory_order_acquire)) != value) {
+        if (wait == WAIT_FUTEX) {
+            syscall(SYS_futex, word, FUTEX_WAIT_PRIVATE, seen, nullptr, nullptr, 0);
+        } else if (wait == WAIT_NANOSLEEP) {
+            struct timespec poll = {0, IDLE_NANOSLEEP_NS};
+            nanosleep(&poll, nullptr);
+        } else if (wait == WAIT_MONITOR) {
+#if defined(__aarch64__)
+            // the exclusive load arms the monitor; the sender's store to the line is the event
+            asm volatile("ldaxr %w0, [%1]" : "=&r"(seen) : "r"(word) : "memory");
+            if (seen != value) asm volatile("wfe" ::: "memory");
+#elif defined(__WAITPKG__)
+            _umonitor(word);
+            if (ref.load(std::memory_order_acquire) != value) _umwait(0, get_cpu_clock() + get_cpu_freq() / 1000);
+#endif
+        }
+    }
+}
+
+// responder: answers requests 1..rounds by echoing their number
+void idle_responder(uint32_t *request, uint32_t *reply, IdleWait wait, size_t rounds) {
+    std::atomic_ref<uint32_t> answer(*reply);
+    for (uint32_t i = 1; i <= rounds; ++i) {
+        idle_wait(wait, request, i);
+        answer.store(i, std::memory_order_release);
+    }
+}
+
+/**
+ * Sender: idles gap_us (sleeping all but IDLE_SLEEP_MARGIN_US of it, then
+ * spinning to the deadline), sends, and spins for the answer. latencies[i]
+ * is in CPU ticks from the send to the answer being seen.
+ * */
+void idle_sender(uint32_t *request, uint32_t *reply, IdleWait wait, double gap_us, size_t rounds, std::vector<uint64_t> *latencies) {
+    std::atomic_ref<uint32_t> send(*request);
+    std::atomic_ref<uint32_t> answer(*reply);
+    uint64_t gap_ticks = (uint64_t) (gap_us * (double) get_cpu_freq() / 1000000.);
+    latencies->assign(rounds, 0);
+
+    for (uint32_t i = 1; i <= rounds; ++i) {
+        uint64_t deadline = get_cpu_clock() + gap_ticks;
+        if (gap_us > 2. * IDLE_SLEEP_MARGIN_US) {
+            long sleep_ns = (long) ((gap_us - IDLE_SLEEP_MARGIN_US) * 1000.);
+            struct timespec idle = {sleep_ns / 1000000000L, sleep_ns % 1000000000L};
+            nanosleep(&idle, nullptr);
+        }
+        while (get_cpu_clock() < deadline);
+
+        uint64_t start = get_cpu_clock();
+        send.store(i, std::memory_order_release);
+        if (wait == WAIT_FUTEX) {
+            syscall(SYS_futex, request, FUTEX_WAKE_PRIVATE, 1, nullptr, nullptr, 0);
+        }
+        while (answer.load(std::memory_order_acquire) != i);
+        (*latencies)[i - 1] = get_cpu_clock() - start;
+    }
+}
+
+struct IdleState {
+    std::string name;
+    long long usage;        // entries
+    long long time_us;      // residency
+};
+
+// cpuidle states of one CPU, empty without a cpuidle driver
+std::vector<IdleState> read_idle_states(int cpu) {
+    std::vector<IdleState> states;
+    for (int index = 0; ; ++index) {
+        std::string dir = "/sys/devices/system/cpu/cpu" + std::to_string(cpu) + "/cpuidle/state" + std::to_string(index) + "/";
+        std::string name = read_sysfs(dir + "name");
+        if (name.empty()) {
+            break;
+        }
+        states.push_back({name, atoll(read_sysfs(dir + "usage").c_str()), atoll(read_sysfs(dir + "time").c_str())});
+    }
+    return states;
+}
+
+#endif // IDLE_GAP_HPP
@@ -0,0 +1,161 @@
+#ifndef JSON_HPP
+#define JSON_HPP
+
+#include <cctype>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <string>
+#include <vector>
+
+/**
+ * Just enough JSON to read sweep files: objects, arrays, strings (with the
+ * common escapes), numbers, true/false/null. Numbers are kept as doubles.
+ * parse_json() returns false and sets an error with the offset on bad input.
+ * */
+struct JsonValue {
+    enum Kind { NUL, BOOL, NUMBER, STRING, ARRAY, OBJECT } kind = NUL;
+
+    bool boolean = false;
+    double number = 0.;
+    std::string string;
+    std::vector<JsonValue> array;
+    std::map<std::string, JsonValue> object;
+
+    const JsonValue *find(const std::string &key) const {
+        auto member = object.find(key);
+        return member == object.end() ? nullptr : &member->second;
+    }
+
+    // scalars as text, so "0" and 0 compare the same in a sweep
+    std::string text() const {
+        if (kind == STRING) {
+            return string;
+        } else if (kind == NUMBER) {
+            std::string printed = std::to_string(number);
+            printed.erase(printed.find_last_not_of('0') + 1);
+            if (printed.back() == '.') printed.pop_back();
+            return printed;
+        } else if (kind == BOOL) {
+            return boolean ? "true" : "false";
+        } else if (kind == ARRAY) {
+            std::string joined;
+            for (const JsonValue &item : array) {
+                joined += (joined.empty() ? "" : ",") + item.text();
+            }
+            return joined;
+        }
+        return "";
+    }
+};
+
+class JsonParser {
+public:
+    explicit JsonParser(const std::string &text) : text(text), at(0) {}
+
+    bool parse(JsonValue *value, std::string *error) {
+        if (!parse_value(value) || (skip_space(), at != text.size())) {
+            *error = "invalid JSON at offset " + std::to_string(at);
+            return false;
+        }
+        return true;
+    }
+
+private:
+    void skip_space() {
+        while (at < text.size() && isspace((unsigned char) text[at])) ++at;
+    }
+
+    bool consume(char c) {
+        skip_space();
+        if (at < text.size() && text[at] == c) {
+            ++at;
+            return true;
+        }
+        return false;
+    }
+
+    bool parse_literal(const char *word) {
+        size_t length = strlen(word);
+        if (text.compare(at, length, word) != 0) {
+            return false;
+        }
+        at += length;
+        return true;
+    }
+
+    bool parse_string(std::string *out) {
+        if (!consume('"')) {
+            return false;
+        }
+        while (at < text.size() && text[at] != '"') {
+            char c = text[at++];
+            if (c == '\\' && at < text.size()) {
+                char escaped = text[at++];
+                c = escaped == 'n' ? '\n' : escaped == 't' ? '\t' : escaped;
+            }
+            *out += c;
+        }
+        return at++ < text.size();
+    }
+
+    bool parse_value(JsonValue *value) {
+        skip_space();
+        if (at >= text.size()) {
+            return false;
+        }
+
+        char c = text[at];
+        if (c == '{') {
+            value->kind = JsonValue::OBJECT;
+            ++at;
+            if (consume('}')) return true;
+            do {
+                std::string key;
+                if (!parse_string(&key) || !consume(':') || !parse_value(&value->object[key])) {
+                    return false;
+                }
+            } while (consume(','));
+            return consume('}');
+        } else if (c == '[') {
+            value->kind = JsonValue::ARRAY;
+            ++at;
+            if (consume(']')) return true;
+            do {
+                value->array.emplace_back();
+                if (!parse_value(&value->array.back())) {
+                    return false;
+                }
+            } while (consume(','));
+            return consume(']');
+        } else if (c == '"') {
+            value->kind = JsonValue::STRING;
+            return parse_string(&value->string);
+        } else if (c == 't' || c == 'f') {
+            value->kind = JsonValue::BOOL;
+            value->boolean = c == 't';
+            return parse_literal(c == 't' ? "true" : "false");
+        } else if (c == 'n') {
+            value->kind = JsonValue::NUL;
+            return parse_literal("null");
+        }
+
+        char *end;
+        value->kind = JsonValue::NUMBER;
+        value->number = strtod(text.c_str() + at, &end);
+        if (end == text.c_str() + at) {
+            return false;
+        }
+        at = end - text.c_str();
+        return true;
+    }
+
+    const std::string &text;
+    size_t at;
+};
+
+bool parse_json(const std::string &text, JsonValue *value, std::string *error) {
+    return JsonParser(text).parse(value, error);
+}
+
+#endif // JSON_HPP
@@ -0,0 +1,175 @@
+#ifndef LATENCY_MODEL_HPP
+#define LATENCY_MODEL_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "cpu_utils.hpp"
+#include "pingpong_protocols.cuh"
+
+/**
+ * Latency injection for a host thread standing in for the device agent.
+ *
+ * On a GPU-less machine the "device" side of a ping/pong is just another
+ * core, so the peer would see cache-to-cache latency. The simulated agent
+ * delays each of its stores by a delay drawn from a LatencyModel, so the
+ * peer observes the flag change only after a realistic remote-agent
+ * latency. Empirical histograms are "<latency_ns> <count>" lines, '#'
+ * starting a comment.
+ * */
+
+enum LatencyDistribution {
+    NO_LATENCY,
+    FIXED_LATENCY,
+    UNIFORM_LATENCY,
+    EMPIRICAL_LATENCY
+};
+
+struct LatencyModel {
+    LatencyDistribution distribution = NO_LATENCY;
+    std::string spec = "none";
+
+    double fixed_ns = 0.;
+    double uniform_lo_ns = 0.;
+    double uniform_hi_ns = 0.;
+
+    // empirical: bin latencies and their (unnormalised) cumulative counts
+    std::vector<double> bin_ns;
+    std::vector<double> bin_cdf;
+};
+
+bool load_latency_histogram(const char *path, LatencyModel *model) {
+    std::ifstream in(path);
+    if (!in) {
+        std::cout << "Could not open latency histogram " << path << std::endl;
+        return false;
+    }
+
+    model->bin_ns.clear();
+    model->bin_cdf.clear();
+
+    double total = 0.;
+    std::string line;
+    while (std::getline(in, line)) {
+        size_t comment = line.find('#');
+        if (comment != std::string::npos) {
+            line.resize(comment);
+        }
+
+        std::istringstream fields(line);
+        double latency_ns, count;
+        if (!(fields >> latency_ns >> count) || latency_ns < 0. || count <= 0.) {
+            continue;
+        }
+
+        total += count;
+        model->bin_ns.push_back(latency_ns);
+        model->bin_cdf.push_back(total);
+    }
+
+    if (model->bin_ns.empty()) {
+        std::cout << "Latency histogram " << path << " has no bins" << std::endl;
+        return false;
+    }
+
+    return true;
+}
+
+bool parse_latency_model(const char *spec, LatencyModel *model) {
+    model->spec = spec;
+
+    if (strncmp(spec, "fixed:", 6) == 0) {
+        model->distribution = FIXED_LATENCY;
+        model->fixed_ns = atof(spec + 6);
+        return model->fixed_ns >= 0.;
+    } else if (strncmp(spec, "uniform:", 8) == 0) {
+        model->distribution = UNIFORM_LATENCY;
+        if (sscanf(spec + 8, "%lf:%lf", &model->uniform_lo_ns, &model->uniform_hi_ns) != 2) {
+            return false;
+        }
+        return model->uniform_lo_ns >= 0. && model->uniform_lo_ns <= model->uniform_hi_ns;
+    } else if (strncmp(spec, "empirical:", 10) == 0) {
+        model->distribution = EMPIRICAL_LATENCY;
+        return load_latency_histogram(spec + 10, model);
+    } else if (strcmp(spec, "none") == 0) {
+        model->distribution = NO_LATENCY;
+        return true;
+    }
+
+    return false;
+}
+
+/**
+ * Per-agent delay source. Delays are drawn up front and converted to CPU
+ * clock ticks so the hot loop only does an array read, never an RNG call.
+ * */
+class LatencyInjector {
+public:
+    LatencyInjector(const LatencyModel &model, size_t count, uint64_t seed = 0x5eed) : delays(count, 0), next(0) {
+        std::mt19937_64 rng(seed);
+        double ticks_per_ns = (double) get_cpu_freq() / 1000000000.;
+
+        std::uniform_real_distribution<double> uniform(model.uniform_lo_ns, model.uniform_hi_ns);
+        std::uniform_real_distribution<double> unit(0., model.bin_cdf.empty() ? 1. : model.bin_cdf.back());
+
+        for (size_t i = 0; i < count; ++i) {
+            double ns = 0.;
+
+            switch (model.distribution) {
+                case FIXED_LATENCY:
+                    ns = model.fixed_ns;
+                    break;
+                case UNIFORM_LATENCY:
+                    ns = uniform(rng);
+                    break;
+                case EMPIRICAL_LATENCY:
+                    ns = model.bin_ns[std::lower_bound(model.bin_cdf.begin(), model.bin_cdf.end(), unit(rng)) - model.bin_cdf.begin()];
+                    break;
+                case NO_LATENCY:
+                    break;
+            }
+
+            delays[i] = (uint64_t) (ns * ticks_per_ns);
+        }
+    }
+
+    __attribute__((always_inline)) inline uint64_t next_delay() {
+        uint64_t delay = delays[next];
+        next = (next + 1 == delays.size()) ? 0 : next + 1;
+        return delay;
+    }
+
+private:
+    std::vector<uint64_t> delays;
+    size_t next;
+};
+
+__attribute__((always_inline)) inline void inject_delay(LatencyInjector *injector) {
+    uint64_t release_at = get_cpu_clock() + injector->next_delay();
+    while (get_cpu_clock() < release_at);
+}
+
+// HostAgent whose flag changes become visible to the peer only after an injected delay
+struct SimulatedAgent : HostAgent {
+    LatencyInjector *injector;
+
+    explicit SimulatedAgent(LatencyInjector *injector) : injector(injector) {}
+
+    // the delay starts once the peer's change has been observed
+    template <typename R>
+    void before_publish(R &flag, uint32_t observed) {
+        while (flag.load(std::memory_order_relaxed) != observed);
+        inject_delay(injector);
+    }
+};
+
+#endif // LATENCY_MODEL_HPP
@@ -0,0 +1,157 @@
+#ifndef LOW_JITTER_HPP
+#define LOW_JITTER_HPP
+
+#include <pthread.h>
+#include <sched.h>
+#include <sys/mman.h>
+
+#include <atomic>
+#include <cctype>
+#include <cerrno>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <set>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "platform.hpp"
+
+/**
+ * Low-jitter mode: SCHED_FIFO host agents, locked memory, isolated cores.
+ *
+ * Arenas are written in full when they are created, so under mlockall their
+ * pages are faulted in once and then stay resident. Two SCHED_FIFO spinners
+ * on one core never yield to each other, so FIFO is only applied to an
+ * agent that really runs on its own requested core, and main refuses it for
+ * a pair that is not two distinct online cores.
+ * */
+
+struct LowJitter {
+    bool enabled = false;
+    int priority = 0;
+};
+
+LowJitter &low_jitter() {
+    static LowJitter config;
+    return config;
+}
+
+// SCHED_FIFO priority of agents this thread starts, 0 for SCHED_OTHER; the Jitter cell switches it per run
+int &agent_priority() {
+    thread_local int priority = low_jitter().priority;
+    return priority;
+}
+
+bool parse_low_jitter(const char *spec, LowJitter *config) {
+    int priority = atoi(spec);
+    if (priority < sched_get_priority_min(SCHED_FIFO) || priority > sched_get_priority_max(SCHED_FIFO)) {
+        return false;
+    }
+    config->enabled = true;
+    config->priority = priority;
+    return true;
+}
+
+bool enable_low_jitter() {
+    if (mlockall(MCL_CURRENT | MCL_FUTURE) != 0) {
+        std::cout << "Info | Low-Jitter | mlockall failed : " << strerror(errno) << std::endl;
+        return false;
+    }
+    return true;
+}
+
+// run by an agent on itself, after pinning, with the priority of the thread that started it
+void apply_agent_scheduling(int core, int priority) {
+    if (priority == 0 || sched_getcpu() != core) {
+        return;
+    }
+
+    sched_param param = {};
+    param.sched_priority = priority;
+    int error = pthread_setschedparam(pthread_self(), SCHED_FIFO, &param);
+
+    static std::atomic<bool> warned(false);
+    if (error != 0 && !warned.exchange(true)) {
+        std::cout << "Info | Low-Jitter | SCHED_FIFO unavailable : " << strerror(error) << std::endl;
+    }
+}
+
+std::vector<int> parse_cpu_list(const std::string &list) {
+    std::vector<int> cpus;
+    std::istringstream ranges(list);
+    std::string range;
+    while (std::getline(ranges, range, ',')) {
+        int lo, hi;
+        if (sscanf(range.c_str(), "%d-%d", &lo, &hi) == 2) {
+            for (int cpu = lo; cpu <= hi; ++cpu) cpus.push_back(cpu);
+        } else if (sscanf(range.c_str(), "%d", &lo) == 1) {
+            cpus.push_back(lo);
+        }
+    }
+    return cpus;
+}
+
+// one CPU per physical core that is isolated, nohz_full, or both; cores in both first
+std::vector<int> isolated_cores() {
+    const PlatformInfo &info = platform();
+    std::vector<int> isolated = parse_cpu_list(info.isolcpus), tickless = parse_cpu_list(info.nohz_full);
+    std::set<int> in_isolated(isolated.begin(), isolated.end()), in_tickless(tickless.begin(), tickless.end());
+
+    std::vector<int> both, either;
+    std::set<int> seen;
+    for (const CpuPlacement &placement : cpu_placements()) {
+        bool a = in_isolated.count(placement.cpu), b = in_tickless.count(placement.cpu);
+        if ((a || b) && seen.insert(placement.core).second) {
+            (a && b ? both : either).push_back(placement.cpu);
+        }
+    }
+    both.insert(both.end(), either.begin(), either.end());
+    return both;
+}
+
+// prints every device IRQ (numbered lines of /proc/interrupts) the core has served; returns how many
+int warn_device_interrupts(int core) {
+    std::ifstream in("/proc/interrupts");
+    std::string header;
+    std::getline(in, header);
+
+    std::istringstream columns(header);
+    std::string column;
+    int position = -1, index = 0;
+    while (columns >> column) {
+        if (column == "CPU" + std::to_string(core)) position = index;
+        index++;
+    }
+    if (position < 0) {
+        return 0;
+    }
+
+    int found = 0;
+    std::string line;
+    while (std::getline(in, line)) {
+        size_t colon = line.find(':');
+        size_t start = line.find_first_not_of(' ');
+        if (colon == std::string::npos || !isdigit((unsigned char) line[start])) {
+            continue;
+        }
+
+        std::istringstream fields(line.substr(colon + 1));
+        std::vector<long long> counts;
+        long long count;
+        while ((int) counts.size() < index && fields >> count) {
+            counts.push_back(count);
+        }
+        if ((int) counts.size() > position && counts[position] > 0) {
+            fields.clear();
+            std::string description;
+            std::getline(fields, description);
+            std::cout << "Info | Low-Jitter | Core " << core << " takes IRQ " << line.substr(start, colon - start) << " :" << description << std::endl;
+            found++;
+        }
+    }
+    return found;
+}
+
+#endif // LOW_JITTER_HPP
@@ -0,0 +1,194 @@
+#ifndef MAILBOX_HPP
+#define MAILBOX_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#if defined(__AVX512F__) || defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+#include "cpu_utils.hpp"
+
+/**
+ * One consumer watching M mailboxes.
+ *
+ * Every channel has a 32-bit sequence number in one packed array, so a line
+ * holds MAILBOX_LINE of them. The consumer finds the one bumped channel by
+ * scalar loads, by vector compares of whole lines against a last-seen copy,
+ * or through a doorbell bitmap the producer sets after the sequence number.
+ * Counts are rounded up to a multiple of 64; the padding never fires but is
+ * scanned.
+ * */
+
+constexpr size_t MAILBOX_ROUNDS = 1000;
+constexpr size_t MAILBOX_MAX_CHANNELS = 65536;
+constexpr size_t MAILBOX_LINE = cpu_cacheline / sizeof(uint32_t);
+constexpr size_t MAILBOX_SCAN_SLOTS = 1 << 24;      // channels scanned for the polling cost
+const size_t MAILBOX_CHANNELS[] = {64, 512, 4096, 32768, 65536};
+
+enum MailboxScan {
+    SCAN_SCALAR,
+    SCAN_VECTOR,
+    SCAN_DOORBELL
+};
+
+const char *mailbox_scan_name(MailboxScan scan) {
+    switch (scan) {
+        case SCAN_SCALAR: return "Scalar";
+        case SCAN_DOORBELL: return "Doorbell";
+        case SCAN_VECTOR:
+#if defined(__AVX512F__)
+            return "AVX-512";
+#elif defined(__AVX2__)
+            return "AVX2";
+#elif defined(__SSE2__)
+            return "SSE2";
+#elif defined(__ARM_NEON)
+            return "NEON";
+#else
+            return "Vector";
+#endif
+    }
+    return "Unknown";
+}
+
+bool parse_mailbox_sweep(const char *spec, std::vector<size_t> *channels) {
+    channels->clear();
+    if (*spec == '\0' || std::string(spec) == "default") {
+        channels->assign(std::begin(MAILBOX_CHANNELS), std::end(MAILBOX_CHANNELS));
+        return true;
+    }
+
+    std::istringstream list(spec);
+    std::string count;
+    while (std::getline(list, count, ',')) {
+        long value = atol(count.c_str());
+        if (value < 1 || (size_t) value > MAILBOX_MAX_CHANNELS) {
+            return false;
+        }
+        channels->push_back((size_t) value);
+    }
+    return !channels->empty();
+}
+
+struct Mailbox {
+    uint32_t *sequences;    // channels of them, packed
+    uint64_t *doorbells;    // channels / 64 words
+    uint64_t *ack;          // rounds the consumer is ready for, see mailbox_consumer
+    size_t channels;        // a multiple of 64
+};
+
+// true if any of the MAILBOX_LINE sequence numbers at line differ from seen
+inline bool line_changed(const uint32_t *line, const uint32_t *seen) {
+#if defined(__AVX512F__)
+    return _mm512_cmpneq_epi32_mask(_mm512_loadu_si512(line), _mm512_loadu_si512(seen)) != 0;
+#elif defined(__AVX2__)
+    __m256i a = _mm256_cmpeq_epi32(_mm256_loadu_si256((const __m256i *) line), _mm256_loadu_si256((const __m256i *) seen));
+    __m256i b = _mm256_cmpeq_epi32(_mm256_loadu_si256((const __m256i *) (line + 8)), _mm256_loadu_si256((const __m256i *) (seen + 8)));
+    return _mm256_movemask_epi8(_mm256_and_si256(a, b)) != -1;
+#elif defined(__SSE2__)
+    __m128i equal = _mm_set1_epi32(-1);
+    for (size_t i = 0; i < MAILBOX_LINE; i += 4) {
+        equal = _mm_and_si128(equal, _mm_cmpeq_epi32(_mm_loadu_si128((const __m128i *) (line + i)), _mm_loadu_si128((const __m128i *) (seen + i))));
+    }
+    return _mm_movemask_epi8(equal) != 0xffff;
+#elif defined(__ARM_NEON)
+    uint32x4_t equal = vdupq_n_u32(~0u);
+    for (size_t i = 0; i < MAILBOX_LINE; i += 4) {
+        equal = vandq_u32(equal, vceqq_u32(vld1q_u32(line + i), vld1q_u32(seen + i)));
+    }
+    return vminvq_u32(equal) != ~0u;
+#else
+    for (size_t i = 0; i < MAILBOX_LINE; ++i) {
+        if (line[i] != seen[i]) return true;
+    }
+    return false;
+#endif
+}
+
+// one pass; the first pending channel, or channels if none
+size_t mailbox_scan(const Mailbox &box, MailboxScan scan, const uint32_t *seen) {
+    if (scan == SCAN_DOORBELL) {
+        for (size_t word = 0; word < box.channels / 64; ++word) {
+            std::atomic_ref<uint64_t> bits(box.doorbells[word]);
+            if (bits.load(std::memory_order_relaxed) != 0) {
+                return word * 64 + (size_t) __builtin_ctzll(bits.exchange(0, std::memory_order_acquire));
+            }
+        }
+    } else if (scan == SCAN_VECTOR) {
+        for (size_t line = 0; line < box.channels; line += MAILBOX_LINE) {
+            if (line_changed(box.sequences + line, seen + line)) {
+                for (size_t channel = line; ; ++channel) {
+                    if (std::atomic_ref<uint32_t>(box.sequences[channel]).load(std::memory_order_relaxed) != seen[channel]) return channel;
+                }
+            }
+        }
+    } else {
+        for (size_t channel = 0; channel < box.channels; ++channel) {
+            if (std::atomic_ref<uint32_t>(box.sequences[channel]).load(std::memory_order_relaxed) != seen[channel]) return channel;
+        }
+    }
+    return box.channels;
+}
+
+/**
+ * Times idle passes first and publishes ack = 1, then for the n-th round
+ * finds the pending channel, stamps it into detects and publishes n + 1.
+ * The compiler barrier between passes keeps vector loads from being hoisted.
+ * */
+void mailbox_consumer(Mailbox box, MailboxScan scan, size_t rounds, std::vector<uint64_t> *detects, double *scan_ticks) {
+    std::atomic_ref<uint64_t> ack(*box.ack);
+    std::vector<uint32_t> seen(box.channels, 0);
+    detects->assign(rounds, 0);
+
+    size_t passes = std::max<size_t>(1, MAILBOX_SCAN_SLOTS / box.channels);
+    uint64_t start = get_cpu_clock();
+    for (size_t pass = 0; pass < passes; ++pass) {
+        mailbox_scan(box, scan, seen.data());
+        asm volatile("" ::: "memory");
+    }
+    *scan_ticks = (double) (get_cpu_clock() - start) / (double) passes;
+    ack.store(1, std::memory_order_release);
+
+    for (size_t round = 0; round < rounds; ++round) {
+        size_t channel;
+        while ((channel = mailbox_scan(box, scan, seen.data())) == box.channels) {
+            asm volatile("" ::: "memory");
+        }
+        (*detects)[round] = get_cpu_clock();
+        seen[channel] = std::atomic_ref<uint32_t>(box.sequences[channel]).load(std::memory_order_acquire);
+        ack.store(round + 2, std::memory_order_release);
+    }
+}
+
+// bumps one of the first channels at random per round, once the consumer is ready for it; sends[i] is the store time
+void mailbox_producer(Mailbox box, MailboxScan scan, size_t channels, size_t rounds, std::vector<uint64_t> *sends) {
+    std::atomic_ref<uint64_t> ack(*box.ack);
+    std::mt19937_64 rng(0x5eed);
+    std::uniform_int_distribution<size_t> pick(0, channels - 1);
+    sends->assign(rounds, 0);
+
+    for (size_t round = 0; round < rounds; ++round) {
+        size_t channel = pick(rng);
+        std::atomic_ref<uint32_t> sequence(box.sequences[channel]);
+        while (ack.load(std::memory_order_acquire) < round + 1);
+
+        (*sends)[round] = get_cpu_clock();
+        sequence.store(sequence.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+        if (scan == SCAN_DOORBELL) {
+            std::atomic_ref<uint64_t>(box.doorbells[channel / 64]).fetch_or(1ull << (channel % 64), std::memory_order_release);
+        }
+    }
+    while (ack.load(std::memory_order_acquire) < rounds + 1);
+}
+
+#endif // MAILBOX_HPP
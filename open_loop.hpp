@@ -0,0 +1,146 @@
+#ifndef OPEN_LOOP_HPP
+#define OPEN_LOOP_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "cpu_utils.hpp"
+#include "pingpong_protocols.cuh"
+
+/**
+ * Open-loop load generation.
+ *
+ * The ping/pong cells are closed-loop, so they measure a single channel at
+ * 100% utilisation. Here the producer publishes requests on a fixed
+ * schedule whether or not earlier ones were answered, and latency runs from
+ * each request's *intended* send time, so a producer that falls behind
+ * (ring full, preempted, slow consumer) is charged for the delay instead of
+ * silently sending later (coordinated omission).
+ * */
+
+constexpr size_t OPEN_LOOP_MESSAGES = PINGPONG_ITERATIONS;
+constexpr size_t OPEN_LOOP_CAPACITY = 256;
+const double OPEN_LOOP_RATES[] = {50000., 100000., 200000., 500000., 1000000., 2000000., 5000000.};
+
+enum LoadSchedule {
+    CONSTANT_LOAD,
+    POISSON_LOAD
+};
+
+struct LoadSweep {
+    LoadSchedule schedule = CONSTANT_LOAD;
+    std::vector<double> rates;
+};
+
+const char *schedule_name(LoadSchedule schedule) {
+    return schedule == CONSTANT_LOAD ? "Constant" : "Poisson";
+}
+
+bool parse_load_sweep(const char *spec, LoadSweep *sweep) {
+    const char *rates;
+    if (strncmp(spec, "constant", 8) == 0) {
+        sweep->schedule = CONSTANT_LOAD;
+        rates = spec + 8;
+    } else if (strncmp(spec, "poisson", 7) == 0) {
+        sweep->schedule = POISSON_LOAD;
+        rates = spec + 7;
+    } else {
+        return false;
+    }
+
+    sweep->rates.clear();
+    if (*rates == '\0') {
+        sweep->rates.assign(std::begin(OPEN_LOOP_RATES), std::end(OPEN_LOOP_RATES));
+        return true;
+    } else if (*rates != ':') {
+        return false;
+    }
+
+    std::istringstream list(rates + 1);
+    std::string rate;
+    while (std::getline(list, rate, ',')) {
+        double value = atof(rate.c_str());
+        if (value <= 0.) {
+            return false;
+        }
+        sweep->rates.push_back(value);
+    }
+    return !sweep->rates.empty();
+}
+
+// intended send times in CPU ticks after the start, drawn before the run
+std::vector<uint64_t> load_schedule(LoadSchedule schedule, double rate, size_t count, uint64_t seed = 0x5eed) {
+    std::vector<uint64_t> intended(count);
+    double ticks_per_message = (double) get_cpu_freq() / rate;
+
+    std::mt19937_64 rng(seed);
+    std::exponential_distribution<double> gap(1. / ticks_per_message);
+
+    double at = 0.;
+    for (size_t i = 0; i < count; ++i) {
+        intended[i] = (uint64_t) at;
+        at += schedule == CONSTANT_LOAD ? ticks_per_message : gap(rng);
+    }
+    return intended;
+}
+
+struct OpenLoopRing {
+    uint64_t *head;         // requests published
+    uint64_t *done;         // requests answered
+    uint64_t *requests;     // intended send time of each request
+    uint64_t *responses;    // echoed by the consumer
+    size_t capacity;
+};
+
+/**
+ * Producer side; latencies[i] is in CPU ticks from request i's intended
+ * send time to the moment the producer saw it answered. A request is only
+ * published once the slot it reuses has been collected.
+ * */
+void open_loop_producer(const OpenLoopRing &ring, const std::vector<uint64_t> &intended, std::vector<uint64_t> *latencies, uint64_t *elapsed) {
+    std::atomic_ref<uint64_t> head(*ring.head);
+    std::atomic_ref<uint64_t> done(*ring.done);
+
+    size_t count = intended.size();
+    size_t collected = 0;
+    latencies->assign(count, 0);
+
+    auto collect = [&]() {
+        size_t answered = (size_t) done.load(std::memory_order_acquire);
+        uint64_t now = get_cpu_clock();
+        for (; collected < answered; ++collected) {
+            (*latencies)[collected] = now - ring.responses[collected % ring.capacity];
+        }
+    };
+
+    uint64_t start = get_cpu_clock();
+    for (size_t i = 0; i < count; ++i) {
+        uint64_t send_at = start + intended[i];
+        while (get_cpu_clock() < send_at || i - collected >= ring.capacity) {
+            collect();
+        }
+
+        ring.requests[i % ring.capacity] = send_at;
+        head.store(i + 1, std::memory_order_release);
+    }
+
+    while (collected < count) {
+        collect();
+    }
+    *elapsed = get_cpu_clock() - start;
+}
+
+// nearest-rank percentile of an ascending vector
+double percentile(const std::vector<double> &sorted, double q) {
+    size_t rank = (size_t) (q * (double) sorted.size());
+    return sorted[std::min(rank, sorted.size() - 1)];
+}
+
+#endif // OPEN_LOOP_HPP
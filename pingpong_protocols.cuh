@@ -0,0 +1,374 @@
+#ifndef PINGPONG_PROTOCOLS_CUH
+#define PINGPONG_PROTOCOLS_CUH
+
+#include <atomic>
+#include <cuda/atomic>
+
+#include "structs.cuh"
+
+#define PING 1
+#define PONG 0
+#define PANG 2
+
+constexpr size_t PINGPONG_ITERATIONS = 10000;
+
+// per-round-trip timestamps, two per iteration: trace[2 * i + TraceEvent]
+enum TraceEvent {
+    TRACE_RECEIVE,  // the peer's flag change was observed
+    TRACE_SEND      // our flag change was published
+};
+
+constexpr size_t TRACE_EVENTS = 2 * PINGPONG_ITERATIONS;
+
+/**
+ * Single-source protocol bodies shared by host threads and device kernels.
+ *
+ * Each protocol is written once as a __host__ __device__ template and is
+ * parameterised on an agent policy that supplies:
+ *  - ref<T>, system_ref<T> atomic_ref views (std:: on the host, cuda:: with
+ *                          the flag's thread scope on the device)
+ *  - time_type / clock()   the agent's clock (cntvct_el0 or clock64)
+ *  - relaxed ... seq_cst   memory orders in the agent's namespace
+ *  - iterations            round trips per measurement, PINGPONG_ITERATIONS
+ *                          unless the caller sets it (see run_length.hpp)
+ *  - pause()               body of every spin-wait
+ *  - fence()               seq_cst thread fence at the agent's scope
+ *  - before_publish()      hook run before a flag change is made visible
+ *  - stamp()               records a TraceEvent into the agent's trace buffer
+ *                          when one is attached (trace_clock() is cntvct_el0
+ *                          on the host and globaltimer on the device)
+ *
+ * Flags are plain uint32_t in caller-owned memory. The protocols only ever
+ * touch them through atomic_ref views, so a flag can sit inside any pinned,
+ * managed or mapped buffer without being declared as an atomic type. They
+ * are 32 bits because libcu++ supports cuda::atomic_ref only for 4- and
+ * 8-byte types.
+ *
+ * host_*_function and device_*_kernel are thin instantiations, so the two
+ * sides time exactly the same loop.
+ * */
+
+struct HostAgent {
+    template <typename T> using ref = std::atomic_ref<T>;
+    template <typename T> using system_ref = std::atomic_ref<T>;
+
+    typedef uint64_t time_type;
+
+    size_t iterations = PINGPONG_ITERATIONS;
+
+    static constexpr std::memory_order relaxed = std::memory_order_relaxed;
+    static constexpr std::memory_order acquire = std::memory_order_acquire;
+    static constexpr std::memory_order release = std::memory_order_release;
+    static constexpr std::memory_order acq_rel = std::memory_order_acq_rel;
+    static constexpr std::memory_order seq_cst = std::memory_order_seq_cst;
+
+    uint64_t *trace = nullptr;
+
+    __host__ static time_type clock() { return get_cpu_clock(); }
+    __host__ static uint64_t trace_clock() { return get_cpu_clock(); }
+    __host__ static void pause() {}
+    __host__ static void fence() { std::atomic_thread_fence(std::memory_order_seq_cst); }
+
+    template <typename R>
+    __host__ void before_publish(R &, uint32_t) {}
+
+    __host__ void stamp(size_t i, TraceEvent event) {
+        if (trace != nullptr) trace[2 * i + event] = trace_clock();
+    }
+};
+
+template <cuda::thread_scope Scope>
+struct DeviceAgent {
+    template <typename T> using ref = cuda::atomic_ref<T, Scope>;
+    template <typename T> using system_ref = cuda::atomic_ref<T, cuda::thread_scope_system>;
+
+    typedef clock_t time_type;
+
+    size_t iterations = PINGPONG_ITERATIONS;
+
+    static constexpr cuda::std::memory_order relaxed = cuda::std::memory_order_relaxed;
+    static constexpr cuda::std::memory_order acquire = cuda::std::memory_order_acquire;
+    static constexpr cuda::std::memory_order release = cuda::std::memory_order_release;
+    static constexpr cuda::std::memory_order acq_rel = cuda::std::memory_order_acq_rel;
+    static constexpr cuda::std::memory_order seq_cst = cuda::std::memory_order_seq_cst;
+
+    uint64_t *trace = nullptr;
+
+    __device__ static time_type clock() { return clock64(); }
+    __device__ static uint64_t trace_clock() { return get_gpu_clock(); }
+    __device__ static void pause() {}
+    __device__ static void fence() { cuda::atomic_thread_fence(cuda::std::memory_order_seq_cst, Scope); }
+
+    template <typename R>
+    __device__ void before_publish(R &, uint32_t) {}
+
+    __device__ void stamp(size_t i, TraceEvent event) {
+        if (trace != nullptr) trace[2 * i + event] = trace_clock();
+    }
+};
+
+// maps a MemOrder onto the orders each kind of access uses in the agent's namespace
+template <typename Agent, MemOrder Order>
+struct ProtocolOrders {
+    static constexpr auto load = Order == RELAXED ? Agent::relaxed : (Order == ACQ_REL ? Agent::acquire : Agent::seq_cst);
+    static constexpr auto store = Order == RELAXED ? Agent::relaxed : (Order == ACQ_REL ? Agent::release : Agent::seq_cst);
+    static constexpr auto rmw = Order == RELAXED ? Agent::relaxed : (Order == ACQ_REL ? Agent::acq_rel : Agent::seq_cst);
+};
+
+enum PingPongProtocol {
+    BASE,       // flip the flag with a CAS
+    DECOUPLED   // wait with a load, flip with a store
+};
+
+// how the two fetch-add agents line up before the timed loop
+enum FetchAddStart {
+    START_HANDSHAKE,    // both bump sig and wait for PANG
+    START_SIGNAL,       // store PING into sig and go
+    START_WAIT          // wait for PING in sig
+};
+
+#pragma nv_exec_check_disable
+template <typename Agent, MemOrder Order, FetchAddStart Start>
+__host__ __device__ void fetch_add_protocol(Agent &agent, uint32_t *flag_ptr, uint32_t *sig_ptr, typename Agent::time_type *time) {
+    typedef ProtocolOrders<Agent, Order> O;
+    typename Agent::template ref<uint32_t> flag(*flag_ptr);
+    typename Agent::template system_ref<uint32_t> sig(*sig_ptr);
+
+    if (Start == START_HANDSHAKE) {
+        sig.fetch_add(PING);
+        while (sig.load() != PANG) Agent::pause();
+    } else if (Start == START_SIGNAL) {
+        sig.store(PING);
+    } else {
+        while (sig.load() != PING) Agent::pause();
+    }
+
+    typename Agent::time_type start = Agent::clock();
+    for (size_t i = 0; i < agent.iterations; ++i) {
+        flag.fetch_add(1, O::rmw);
+    }
+    typename Agent::time_type end = Agent::clock();
+
+    *time = end - start;
+}
+
+// change ping to pong with a CAS
+#pragma nv_exec_check_disable
+template <typename Agent, MemOrder Order>
+__host__ __device__ void ping_base_protocol(Agent &agent, uint32_t *flag_ptr, typename Agent::time_type *time) {
+    typedef ProtocolOrders<Agent, Order> O;
+    typename Agent::template ref<uint32_t> flag(*flag_ptr);
+
+    uint32_t expected = PING;
+    while (flag.load(Agent::relaxed) == PONG) Agent::pause();
+
+    typename Agent::time_type start = Agent::clock();
+    for (size_t i = 0; i < agent.iterations; ++i) {
+        agent.before_publish(flag, PING);
+        while (!flag.compare_exchange_strong(expected, PONG, O::rmw, O::load)) {
+            expected = PING;
+            Agent::pause();
+        }
+        // the CAS observes and publishes in one step
+        agent.stamp(i, TRACE_RECEIVE);
+        agent.stamp(i, TRACE_SEND);
+    }
+    typename Agent::time_type end = Agent::clock();
+
+    *time = end - start;
+}
+
+// change pong to ping with a CAS
+#pragma nv_exec_check_disable
+template <typename Agent, MemOrder Order>
+__host__ __device__ void pong_base_protocol(Agent &agent, uint32_t *flag_ptr) {
+    typedef ProtocolOrders<Agent, Order> O;
+    typename Agent::template ref<uint32_t> flag(*flag_ptr);
+
+    flag.store(PING, Agent::relaxed);
+    uint32_t expected = PONG;
+    for (size_t i = 0; i < agent.iterations; ++i) {
+        agent.before_publish(flag, PONG);
+        while (!flag.compare_exchange_strong(expected, PING, O::rmw, O::load)) {
+            expected = PONG;
+            Agent::pause();
+        }
+        agent.stamp(i, TRACE_RECEIVE);
+        agent.stamp(i, TRACE_SEND);
+    }
+}
+
+// wait for ping with a load, answer with a store
+#pragma nv_exec_check_disable
+template <typename Agent, MemOrder Order>
+__host__ __device__ void ping_decoupled_protocol(Agent &agent, uint32_t *flag_ptr, typename Agent::time_type *time) {
+    typedef ProtocolOrders<Agent, Order> O;
+    typename Agent::template ref<uint32_t> flag(*flag_ptr);
+
+    while (flag.load(Agent::relaxed) == PONG) Agent::pause();
+
+    typename Agent::time_type start = Agent::clock();
+    for (size_t i = 0; i < agent.iterations; ++i) {
+        while (flag.load(O::load) != PING) Agent::pause();
+        agent.stamp(i, TRACE_RECEIVE);
+        agent.before_publish(flag, PING);
+        flag.store(PONG, O::store);
+        agent.stamp(i, TRACE_SEND);
+    }
+    typename Agent::time_type end = Agent::clock();
+
+    *time = end - start;
+}
+
+#pragma nv_exec_check_disable
+template <typename Agent, MemOrder Order>
+__host__ __device__ void pong_decoupled_protocol(Agent &agent, uint32_t *flag_ptr) {
+    typedef ProtocolOrders<Agent, Order> O;
+    typename Agent::template ref<uint32_t> flag(*flag_ptr);
+
+    flag.store(PING, Agent::relaxed);
+    for (size_t i = 0; i < agent.iterations; ++i) {
+        while (flag.load(O::load) != PONG) Agent::pause();
+        agent.stamp(i, TRACE_RECEIVE);
+        agent.before_publish(flag, PONG);
+        flag.store(PING, O::store);
+        agent.stamp(i, TRACE_SEND);
+    }
+}
+
+// one-way mode: each side writes trace_clock() into its message slot before publishing the flag
+enum OneWaySlot {
+    ONEWAY_PING,    // message[ONEWAY_PING] is ping's send stamp
+    ONEWAY_PONG
+};
+
+// arrivals[2 * i + ONEWAY_SENT] is the peer's send stamp, arrivals[2 * i + ONEWAY_RECEIVED] ours
+enum OneWayArrival {
+    ONEWAY_SENT,
+    ONEWAY_RECEIVED
+};
+
+/**
+ * Decoupled ping/pong whose messages carry the sender's clock. The stamp is
+ * written before the flag is released and read after it is acquired, so
+ * these always run acquire/release regardless of the cell's MemOrder.
+ * */
+#pragma nv_exec_check_disable
+template <typename Agent>
+__host__ __device__ void one_way_protocol(Agent &agent, uint32_t *flag_ptr, uint64_t *message, uint64_t *arrivals, uint32_t wait_for, uint32_t answer, OneWaySlot own, bool opens) {
+    typename Agent::template ref<uint32_t> flag(*flag_ptr);
+    typename Agent::template ref<uint64_t> outgoing(message[own]);
+    typename Agent::template ref<uint64_t> incoming(message[own == ONEWAY_PING ? ONEWAY_PONG : ONEWAY_PING]);
+
+    if (opens) {
+        outgoing.store(Agent::trace_clock(), Agent::relaxed);
+        flag.store(answer, Agent::release);
+    }
+
+    for (size_t i = 0; i < agent.iterations; ++i) {
+        while (flag.load(Agent::acquire) != wait_for) Agent::pause();
+        arrivals[2 * i + ONEWAY_RECEIVED] = Agent::trace_clock();
+        arrivals[2 * i + ONEWAY_SENT] = incoming.load(Agent::relaxed);
+
+        outgoing.store(Agent::trace_clock(), Agent::relaxed);
+        flag.store(answer, Agent::release);
+    }
+}
+
+#pragma nv_exec_check_disable
+template <typename Agent>
+__host__ __device__ void ping_one_way_protocol(Agent &agent, uint32_t *flag, uint64_t *message, uint64_t *arrivals) {
+    one_way_protocol<Agent>(agent, flag, message, arrivals, PING, PONG, ONEWAY_PING, false);
+}
+
+// pong opens with the first PING, as in the round-trip protocols
+#pragma nv_exec_check_disable
+template <typename Agent>
+__host__ __device__ void pong_one_way_protocol(Agent &agent, uint32_t *flag, uint64_t *message, uint64_t *arrivals) {
+    one_way_protocol<Agent>(agent, flag, message, arrivals, PONG, PING, ONEWAY_PONG, true);
+}
+
+/**
+ * Open-loop consumer: answers agent.iterations requests strictly in order.
+ * head counts the requests the producer has published, done the ones
+ * answered so far; each answer echoes the request's intended send time
+ * into the response ring.
+ * */
+#pragma nv_exec_check_disable
+template <typename Agent>
+__host__ __device__ void open_loop_consumer_protocol(Agent &agent, uint64_t *head_ptr, uint64_t *done_ptr, uint64_t *requests, uint64_t *responses, size_t capacity) {
+    typename Agent::template ref<uint64_t> head(*head_ptr);
+    typename Agent::template ref<uint64_t> done(*done_ptr);
+
+    for (size_t i = 0; i < agent.iterations; ++i) {
+        while (head.load(Agent::acquire) <= i) Agent::pause();
+        responses[i % capacity] = requests[i % capacity];
+        done.store(i + 1, Agent::release);
+    }
+}
+
+// clock calibration results, out[CalibrationSlot], all in ticks of the calibrated clock
+enum CalibrationSlot {
+    CALIBRATION_READ_TICKS,         // summed over all back-to-back reads
+    CALIBRATION_RESOLUTION_TICKS,   // smallest non-zero step
+    CALIBRATION_LOOP_TICKS,         // empty loop of agent.iterations, plus one read
+    CALIBRATION_SLOTS
+};
+
+#pragma nv_exec_check_disable
+template <typename Agent, bool TraceClock>
+__host__ __device__ uint64_t calibration_clock() {
+    return TraceClock ? Agent::trace_clock() : (uint64_t) Agent::clock();
+}
+
+/**
+ * What timing itself costs an agent: back-to-back reads of clock() (or
+ * trace_clock()), the finest step the clock takes, and the loop control of
+ * an empty loop as long as a measurement. The loop body is a compiler
+ * barrier only, so the loop cannot be folded away.
+ * */
+#pragma nv_exec_check_disable
+template <typename Agent, bool TraceClock>
+__host__ __device__ void clock_calibration_protocol(Agent &agent, uint64_t *out, size_t reads) {
+    uint64_t previous = calibration_clock<Agent, TraceClock>();
+    uint64_t total = 0, finest = ~0ull;
+    for (size_t i = 0; i < reads; ++i) {
+        uint64_t now = calibration_clock<Agent, TraceClock>();
+        uint64_t step = now - previous;
+        total += step;
+        if (step != 0 && step < finest) finest = step;
+        previous = now;
+    }
+
+    uint64_t start = calibration_clock<Agent, TraceClock>();
+    for (size_t i = 0; i < agent.iterations; ++i) {
+        asm volatile("" ::: "memory");
+    }
+    uint64_t end = calibration_clock<Agent, TraceClock>();
+
+    out[CALIBRATION_READ_TICKS] = total;
+    out[CALIBRATION_RESOLUTION_TICKS] = finest;
+    out[CALIBRATION_LOOP_TICKS] = end - start;
+}
+
+#pragma nv_exec_check_disable
+template <typename Agent, MemOrder Order, PingPongProtocol Protocol>
+__host__ __device__ void ping_protocol(Agent &agent, uint32_t *flag, typename Agent::time_type *time) {
+    if (Protocol == BASE) {
+        ping_base_protocol<Agent, Order>(agent, flag, time);
+    } else {
+        ping_decoupled_protocol<Agent, Order>(agent, flag, time);
+    }
+}
+
+#pragma nv_exec_check_disable
+template <typename Agent, MemOrder Order, PingPongProtocol Protocol>
+__host__ __device__ void pong_protocol(Agent &agent, uint32_t *flag) {
+    if (Protocol == BASE) {
+        pong_base_protocol<Agent, Order>(agent, flag);
+    } else {
+        pong_decoupled_protocol<Agent, Order>(agent, flag);
+    }
+}
+
+#endif // PINGPONG_PROTOCOLS_CUH
@@ -0,0 +1,282 @@
+#ifndef PLATFORM_HPP
+#define PLATFORM_HPP
+
+#include <dirent.h>
+#include <sys/utsname.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <set>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "cpu_utils.hpp"
+
+#ifndef BUILD_FLAGS
+#define BUILD_FLAGS "unknown"
+#endif
+
+/**
+ * What machine produced a number.
+ *
+ * Gathered once on first use and cached. Every result line carries the
+ * fingerprint id, and the full fingerprint is printed once at startup, so
+ * runs from different machines (or the same machine after a kernel,
+ * firmware or compiler change) can be told apart, and compare mode can say
+ * which fields moved. Current CPU frequencies
+ * and the timer rate (calibrated on x86) are reported but are not part of
+ * the id, since they move run to run.
+ * */
+struct PlatformInfo {
+    std::string id;
+
+    std::string cpu_model;
+    std::string microcode;
+    int logical_cpus = 0;
+    int threads_per_core = 0;
+    int sockets = 0;
+    int numa_nodes = 0;
+    std::string governor;
+    long cur_khz_min = 0;
+    long cur_khz_max = 0;
+    uint64_t timer_freq = 0;
+
+    std::string kernel;
+    std::string thp;
+    std::string isolcpus;
+    std::string nohz_full;
+
+    std::string compiler;
+    std::string flags;
+
+    bool has_device = false;
+    std::string device;
+};
+
+std::string read_sysfs(const std::string &path) {
+    std::ifstream in(path);
+    std::string value;
+    std::getline(in, value);
+    return value;
+}
+
+// first "key : value" match in /proc/cpuinfo
+std::string read_cpuinfo(const std::string &key) {
+    std::ifstream in("/proc/cpuinfo");
+    std::string line;
+    while (std::getline(in, line)) {
+        if (line.compare(0, key.size(), key) == 0) {
+            size_t colon = line.find(':');
+            if (colon != std::string::npos) {
+                return line.substr(line.find_first_not_of(" \t", colon + 1));
+            }
+        }
+    }
+    return "";
+}
+
+// number of CPUs in a sysfs cpu list such as "0-3,8,10-11"
+int count_cpu_list(const std::string &list) {
+    int count = 0;
+    std::istringstream ranges(list);
+    std::string range;
+    while (std::getline(ranges, range, ',')) {
+        int lo, hi;
+        if (sscanf(range.c_str(), "%d-%d", &lo, &hi) == 2) {
+            count += hi - lo + 1;
+        } else if (sscanf(range.c_str(), "%d", &lo) == 1) {
+            count += 1;
+        }
+    }
+    return count;
+}
+
+/**
+ * Where a logical CPU sits: its physical core, last-level cache and NUMA
+ * node, each named by the lowest CPU (or node) number sharing it. Used to
+ * find core pairs that do not disturb each other (sweep.hpp).
+ * */
+struct CpuPlacement {
+    int cpu;
+    int core;
+    int llc;
+    int node;
+};
+
+std::vector<CpuPlacement> cpu_placements() {
+    std::vector<CpuPlacement> placements;
+    int cpus = (int) sysconf(_SC_NPROCESSORS_ONLN);
+    for (int cpu = 0; cpu < cpus; ++cpu) {
+        std::string base = "/sys/devices/system/cpu/cpu" + std::to_string(cpu);
+        CpuPlacement placement = {cpu, cpu, cpu, 0};
+        sscanf(read_sysfs(base + "/topology/thread_siblings_list").c_str(), "%d", &placement.core);
+
+        // the highest cache index is the last level
+        for (int index = 0; ; ++index) {
+            std::string cache = base + "/cache/index" + std::to_string(index);
+            std::string shared = read_sysfs(cache + "/shared_cpu_list");
+            if (shared.empty()) {
+                break;
+            }
+            sscanf(shared.c_str(), "%d", &placement.llc);
+        }
+
+        if (DIR *entries = opendir(base.c_str())) {
+            while (dirent *entry = readdir(entries)) {
+                if (strncmp(entry->d_name, "node", 4) == 0 && isdigit(entry->d_name[4])) {
+                    placement.node = atoi(entry->d_name + 4);
+                }
+            }
+            closedir(entries);
+        }
+        placements.push_back(placement);
+    }
+    return placements;
+}
+
+uint64_t fnv1a(const std::string &text) {
+    uint64_t hash = 0xcbf29ce484222325ull;
+    for (unsigned char c : text) {
+        hash ^= c;
+        hash *= 0x100000001b3ull;
+    }
+    return hash;
+}
+
+PlatformInfo query_platform() {
+    PlatformInfo info;
+
+    info.cpu_model = read_cpuinfo("model name");
+    if (info.cpu_model.empty()) {
+        // arm64 has no model name, only the MIDR fields
+        info.cpu_model = "implementer " + read_cpuinfo("CPU implementer") + " part " + read_cpuinfo("CPU part") + " r" + read_cpuinfo("CPU variant") + "p" + read_cpuinfo("CPU revision");
+    }
+    info.microcode = read_cpuinfo("microcode");
+    if (info.microcode.empty()) {
+        info.microcode = read_sysfs("/sys/devices/system/cpu/cpu0/regs/identification/revidr_el1");
+    }
+
+    info.logical_cpus = (int) sysconf(_SC_NPROCESSORS_ONLN);
+    info.threads_per_core = count_cpu_list(read_sysfs("/sys/devices/system/cpu/cpu0/topology/thread_siblings_list"));
+
+    std::set<std::string> packages;
+    for (int cpu = 0; cpu < info.logical_cpus; ++cpu) {
+        std::string base = "/sys/devices/system/cpu/cpu" + std::to_string(cpu);
+        std::string package = read_sysfs(base + "/topology/physical_package_id");
+        if (!package.empty()) {
+            packages.insert(package);
+        }
+
+        long khz = atol(read_sysfs(base + "/cpufreq/scaling_cur_freq").c_str());
+        if (khz > 0) {
+            info.cur_khz_min = info.cur_khz_min == 0 ? khz : std::min(info.cur_khz_min, khz);
+            info.cur_khz_max = std::max(info.cur_khz_max, khz);
+        }
+    }
+    info.sockets = (int) packages.size();
+
+    if (DIR *nodes = opendir("/sys/devices/system/node")) {
+        while (dirent *entry = readdir(nodes)) {
+            if (strncmp(entry->d_name, "node", 4) == 0 && isdigit(entry->d_name[4])) {
+                info.numa_nodes++;
+            }
+        }
+        closedir(nodes);
+    }
+
+    info.governor = read_sysfs("/sys/devices/system/cpu/cpu0/cpufreq/scaling_governor");
+    info.timer_freq = get_cpu_freq();
+
+    struct utsname name;
+    if (uname(&name) == 0) {
+        info.kernel = std::string(name.release) + " " + name.version + " " + name.machine;
+    }
+
+    std::string thp = read_sysfs("/sys/kernel/mm/transparent_hugepage/enabled");
+    size_t open = thp.find('['), close = thp.find(']');
+    info.thp = (open != std::string::npos && close != std::string::npos) ? thp.substr(open + 1, close - open - 1) : thp;
+
+    info.isolcpus = read_sysfs("/sys/devices/system/cpu/isolated");
+    info.nohz_full = read_sysfs("/sys/devices/system/cpu/nohz_full");
+
+#ifdef __CUDACC_VER_MAJOR__
+    info.compiler = "nvcc " + std::to_string(__CUDACC_VER_MAJOR__) + "." + std::to_string(__CUDACC_VER_MINOR__) + " / " + __VERSION__;
+#else
+    info.compiler = __VERSION__;
+#endif
+    info.flags = BUILD_FLAGS;
+
+    int devices = 0;
+    if (cudaGetDeviceCount(&devices) == cudaSuccess && devices > 0) {
+        const cudaDeviceProp &properties = get_device_properties();
+        int driver = 0, runtime = 0;
+        cudaDriverGetVersion(&driver);
+        cudaRuntimeGetVersion(&runtime);
+
+        std::ostringstream device;
+        device << properties.name << " sm_" << properties.major << properties.minor << " " << properties.multiProcessorCount << " SMs " << properties.clockRate / 1000 << " MHz " << (properties.totalGlobalMem >> 20) << " MiB driver " << driver << " runtime " << runtime;
+        info.has_device = true;
+        info.device = device.str();
+    } else {
+        info.device = "none";
+    }
+
+    std::ostringstream stable;
+    stable << info.cpu_model << '|' << info.microcode << '|' << info.logical_cpus << '|' << info.threads_per_core << '|' << info.sockets << '|' << info.numa_nodes << '|' << info.governor << '|' << info.kernel << '|' << info.thp << '|' << info.isolcpus << '|' << info.nohz_full << '|' << info.compiler << '|' << info.flags << '|' << info.device;
+
+    char id[17];
+    snprintf(id, sizeof(id), "%016llx", (unsigned long long) fnv1a(stable.str()));
+    info.id = id;
+
+    return info;
+}
+
+const PlatformInfo &platform() {
+    static PlatformInfo info = query_platform();
+    return info;
+}
+
+typedef std::vector<std::pair<std::string, std::string>> PlatformFields;
+
+PlatformFields platform_fields(const PlatformInfo &info) {
+    std::ostringstream topology, khz;
+    topology << info.logical_cpus << " CPUs, " << info.threads_per_core << " threads/core, " << info.sockets << " sockets, " << info.numa_nodes << " NUMA nodes";
+    khz << info.cur_khz_min << "-" << info.cur_khz_max;
+
+    return {
+        {"CPU", info.cpu_model},
+        {"Microcode", info.microcode},
+        {"Topology", topology.str()},
+        {"Governor", info.governor},
+        {"CPU kHz", khz.str()},
+        {"Timer Hz", std::to_string(info.timer_freq)},
+        {"Kernel", info.kernel},
+        {"THP", info.thp},
+        {"isolcpus", info.isolcpus},
+        {"nohz_full", info.nohz_full},
+        {"Compiler", info.compiler},
+        {"Flags", info.flags},
+        {"Device", info.device}
+    };
+}
+
+// "Platform <id> | <key> : <value> ...", once per output, so a saved run carries the full fingerprint behind its ids
+void print_platform(std::ostream &out) {
+    const PlatformInfo &info = platform();
+
+    out << "Platform " << info.id;
+    for (const auto &field : platform_fields(info)) {
+        out << " | " << field.first << " : " << field.second;
+    }
+    out << std::endl;
+}
+
+#endif // PLATFORM_HPP
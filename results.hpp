@@ -0,0 +1,132 @@
+#ifndef RESULTS_HPP
+#define RESULTS_HPP
+
+#include <algorithm>
+#include <iostream>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "contamination.hpp"
+#include "platform.hpp"
+
+// how compare (-c) and the sweep interference check read a field
+enum FieldKind {
+    LOWER_IS_BETTER,        // latencies and the like, the default
+    HIGHER_IS_BETTER,       // throughputs, where a drop is the regression
+    DESCRIPTIVE             // how the result was produced rather than how fast; never compared
+};
+
+struct ResultField {
+    std::string key;
+    double value;
+    FieldKind kind = LOWER_IS_BETTER;
+};
+
+typedef std::vector<ResultField> ResultFields;
+
+// one printed result line, kept around so a run can be compared after the fact
+struct ResultRecord {
+    std::string experiment;
+    ResultFields fields;
+    std::string allocator;
+    std::string platform;
+};
+
+// allocator of the arena the current cells run in, stamped on every record;
+// per thread, since parallel sweep workers run on different allocators
+std::string &current_allocator() {
+    thread_local std::string allocator;
+    return allocator;
+}
+
+std::vector<ResultRecord> &result_records() {
+    static std::vector<ResultRecord> records;
+    return records;
+}
+
+// serialises result lines and result_records() across sweep workers
+std::mutex &output_mutex() {
+    static std::mutex mutex;
+    return mutex;
+}
+
+/**
+ * When records is set, report_result() on this thread also collects into
+ * it; an exclusive capture keeps the result out of the output and
+ * result_records() altogether (interference re-runs, see sweep.hpp).
+ * */
+struct ResultCapture {
+    std::vector<ResultRecord> *records = nullptr;
+    bool exclusive = false;
+};
+
+ResultCapture &result_capture() {
+    thread_local ResultCapture capture;
+    return capture;
+}
+
+double median(std::vector<double> values) {
+    std::sort(values.begin(), values.end());
+    size_t n = values.size();
+    return n % 2 ? values[n / 2] : (values[n / 2 - 1] + values[n / 2]) / 2.;
+}
+
+// printed after the key so a saved run keeps its fields' kinds; lower-is-better has none
+const char *const FIELD_KIND_TAGS[] = {"", " [higher]", " [info]"};
+
+/**
+ * "<experiment> | <key>[ <tag>] : <value> ... | Allocator : <name> | Platform : <id>".
+ * Every other line with " | " fields starts with "Info | ", so no status
+ * line is ever read back as a result.
+ * */
+std::string format_result(const ResultRecord &record) {
+    std::ostringstream line;
+    line << record.experiment;
+    for (const ResultField &field : record.fields) {
+        line << " | " << field.key << FIELD_KIND_TAGS[field.kind] << " : " << field.value;
+    }
+    if (!record.allocator.empty()) {
+        line << " | Allocator : " << record.allocator;
+    }
+    line << " | Platform : " << record.platform;
+    return line.str();
+}
+
+/**
+ * Prints a result line and records it. Every cell reports through here so
+ * each line carries the fingerprint of the machine that produced it (see
+ * platform.hpp) and the verdict on whether its run was disturbed (see
+ * contamination.hpp).
+ * */
+void report_result(const std::string &experiment, const ResultFields &fields) {
+    ResultRecord record = {experiment, fields, current_allocator(), platform().id};
+
+    Contamination contaminated = contamination().finish();
+    if (contaminated.exceeded) {
+        record.fields.push_back({"Ctx Switches", (double) contaminated.switches, DESCRIPTIVE});
+        record.fields.push_back({"Migrations", (double) contaminated.migrations, DESCRIPTIVE});
+        record.fields.push_back({"Interrupts", (double) contaminated.interrupts, DESCRIPTIVE});
+        record.fields.push_back({"Freq Delta %", contaminated.freq_delta, DESCRIPTIVE});
+        if (contamination_config().discard) {
+            std::lock_guard<std::mutex> lock(output_mutex());
+            std::cout << "Info | Contaminated | " << format_result(record) << std::endl;
+            return;
+        }
+    }
+    ResultCapture &capture = result_capture();
+    if (capture.records != nullptr) {
+        capture.records->push_back(record);
+        if (capture.exclusive) {
+            return;
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(output_mutex());
+    std::cout << format_result(record) << std::endl;
+    result_records().push_back(record);
+}
+
+#endif // RESULTS_HPP
@@ -0,0 +1,159 @@
+#ifndef RPC_CUH
+#define RPC_CUH
+
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "cpu_utils.hpp"
+#include "pingpong_protocols.cuh"
+
+/**
+ * Shared-memory RPC through a table of request slots.
+ *
+ * A client claims a free slot (CAS on status, starting from its own index),
+ * writes opcode and arguments and publishes RPC_REQUEST; the host service
+ * thread runs the handler, writes the response and publishes RPC_DONE; the
+ * client reads the response and frees the slot. With fewer slots than
+ * clients, clients queue for slots.
+ * */
+
+constexpr size_t RPC_CALLS = 1000;
+constexpr size_t RPC_MAX_CLIENTS = 64;
+constexpr size_t RPC_ARGS = 4;
+constexpr size_t RPC_RESULTS = 2;
+
+enum RpcStatus {
+    RPC_FREE,
+    RPC_CLAIMED,
+    RPC_REQUEST,
+    RPC_DONE
+};
+
+enum RpcOpcode {
+    RPC_ADD,        // sum of the arguments
+    RPC_ECHO,       // the first two arguments back
+    RPC_HASH,       // a multiplicative mix of all of them
+    RPC_OPCODES
+};
+
+struct alignas(gpu_cacheline) RpcSlot {
+    uint32_t status;
+    uint32_t opcode;
+    uint64_t args[RPC_ARGS];
+    uint64_t results[RPC_RESULTS];
+};
+
+// the handlers; clients run them too, to check the answers
+__host__ __device__ inline void rpc_execute(uint32_t opcode, const uint64_t *args, uint64_t *results) {
+    if (opcode == RPC_ADD) {
+        results[0] = args[0] + args[1] + args[2] + args[3];
+        results[1] = 0;
+    } else if (opcode == RPC_ECHO) {
+        results[0] = args[0];
+        results[1] = args[1];
+    } else {
+        uint64_t hash = 0x9e3779b97f4a7c15ull;
+        for (size_t i = 0; i < RPC_ARGS; ++i) hash = (hash ^ args[i]) * 0x100000001b3ull;
+        results[0] = hash;
+        results[1] = hash >> 32;
+    }
+}
+
+struct RpcSweep {
+    std::vector<size_t> clients;
+    std::vector<size_t> slots;      // empty for one per client
+};
+
+bool parse_count_list(const std::string &spec, size_t max, std::vector<size_t> *counts) {
+    counts->clear();
+    std::istringstream list(spec);
+    std::string count;
+    while (std::getline(list, count, ',')) {
+        int value = atoi(count.c_str());
+        if (value < 1 || (size_t) value > max) {
+            return false;
+        }
+        counts->push_back((size_t) value);
+    }
+    return !counts->empty();
+}
+
+bool parse_rpc_sweep(const char *spec, RpcSweep *sweep) {
+    const char *slots = strchr(spec, ':');
+    std::string clients(spec, slots == nullptr ? strlen(spec) : (size_t) (slots - spec));
+
+    sweep->slots.clear();
+    return parse_count_list(clients, RPC_MAX_CLIENTS, &sweep->clients) && (slots == nullptr || parse_count_list(slots + 1, RPC_MAX_CLIENTS, &sweep->slots));
+}
+
+/**
+ * One client's calls; latencies[i] is call i in trace_clock() ticks. Returns
+ * how many answers were wrong.
+ * */
+#pragma nv_exec_check_disable
+template <typename Agent>
+__host__ __device__ size_t rpc_client_protocol(Agent &agent, RpcSlot *table, size_t slots, size_t client, uint64_t *latencies) {
+    size_t wrong = 0;
+    for (size_t call = 0; call < agent.iterations; ++call) {
+        uint64_t start = Agent::trace_clock();
+
+        size_t index = client % slots;
+        while (true) {
+            uint32_t expected = RPC_FREE;
+            typename Agent::template system_ref<uint32_t> status(table[index].status);
+            if (status.load(Agent::relaxed) == RPC_FREE && status.compare_exchange_strong(expected, RPC_CLAIMED, Agent::acquire, Agent::relaxed)) break;
+            index = (index + 1) % slots;
+            Agent::pause();
+        }
+
+        RpcSlot &slot = table[index];
+        typename Agent::template system_ref<uint32_t> status(slot.status);
+        slot.opcode = (uint32_t) ((client + call) % RPC_OPCODES);
+        for (size_t i = 0; i < RPC_ARGS; ++i) slot.args[i] = client * 1000003ull + call * 31ull + i;
+        status.store(RPC_REQUEST, Agent::release);
+
+        while (status.load(Agent::acquire) != RPC_DONE) Agent::pause();
+
+        uint64_t expected[RPC_RESULTS];
+        rpc_execute(slot.opcode, slot.args, expected);
+        for (size_t i = 0; i < RPC_RESULTS; ++i) wrong += slot.results[i] != expected[i];
+        status.store(RPC_FREE, Agent::release);
+
+        latencies[call] = Agent::trace_clock() - start;
+    }
+    return wrong;
+}
+
+void host_rpc_client_function(RpcSlot *table, size_t slots, size_t client, uint64_t *latencies, size_t *wrong) {
+    HostAgent agent;
+    agent.iterations = RPC_CALLS;
+    *wrong = rpc_client_protocol(agent, table, slots, client, latencies);
+}
+
+/**
+ * The service thread: serves total requests, scanning the table round
+ * robin. elapsed runs from the first request seen to the last answer.
+ * */
+void rpc_server(RpcSlot *table, size_t slots, size_t total, uint64_t *elapsed) {
+    uint64_t start = 0;
+    size_t index = 0;
+    for (size_t served = 0; served < total; index = (index + 1) % slots) {
+        std::atomic_ref<uint32_t> status(table[index].status);
+        if (status.load(std::memory_order_acquire) != RPC_REQUEST) {
+            continue;
+        }
+        if (served == 0) start = get_cpu_clock();
+
+        rpc_execute(table[index].opcode, table[index].args, table[index].results);
+        status.store(RPC_DONE, std::memory_order_release);
+        served++;
+    }
+    *elapsed = get_cpu_clock() - start;
+}
+
+#endif // RPC_CUH
@@ -0,0 +1,188 @@
+#ifndef RUN_LENGTH_HPP
+#define RUN_LENGTH_HPP
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <functional>
+#include <vector>
+
+#include "calibration.hpp"
+#include "pingpong_protocols.cuh"
+#include "results.hpp"
+#include "trace.hpp"
+
+/**
+ * How many round trips a ping/pong cell measures.
+ *
+ * By default every cell runs fixed_iterations() round trips once. An
+ * adaptive cell first grows its batch until one batch takes a
+ * 1/ADAPTIVE_MIN_BATCHES share of the minimum time, then repeats batches of
+ * that size until the time reaches the minimum and the relative standard
+ * error of the batch means is at or below the target, or the next batch
+ * would pass the cap. Sizing batches are warm-up; only the last, full-size
+ * one is kept. Times are the agents' own measured loop times, so kernel
+ * launch and thread start are excluded. Traced runs keep
+ * PINGPONG_ITERATIONS, since trace buffers are sized for it.
+ * */
+
+constexpr size_t ADAPTIVE_FIRST_BATCH = 100;
+constexpr size_t ADAPTIVE_MIN_BATCHES = 5;
+
+struct RunLength {
+    bool adaptive = false;
+    double min_ms = 100.;
+    double target_rse = 1.;             // percent
+    size_t max_iterations = 10000000;
+};
+
+RunLength &run_length() {
+    static RunLength length;
+    return length;
+}
+
+// round trips of a fixed-length run; per thread, since parallel sweep workers each run their own point
+size_t &fixed_iterations() {
+    thread_local size_t iterations = PINGPONG_ITERATIONS;
+    return iterations;
+}
+
+bool parse_run_length(const char *spec, RunLength *length) {
+    double min_ms = length->min_ms, target_rse = length->target_rse, max_iterations = (double) length->max_iterations;
+    if (sscanf(spec, "%lf,%lf,%lf", &min_ms, &target_rse, &max_iterations) < 1 || min_ms <= 0. || target_rse <= 0. || max_iterations < (double) ADAPTIVE_MIN_BATCHES) {
+        return false;
+    }
+
+    length->adaptive = true;
+    length->min_ms = min_ms;
+    length->target_rse = target_rse;
+    length->max_iterations = (size_t) max_iterations;
+    return true;
+}
+
+struct Measurement {
+    double latency_ns;      // per round trip, raw
+    double corrected_ns;    // less timer and loop overhead (calibration.hpp)
+    size_t iterations;      // round trips the estimate is based on
+    double rse;             // percent, 0 for a single fixed batch
+    bool resolved;          // every batch spanned enough clock steps to mean something
+};
+
+Measurement make_measurement(const std::vector<double> &batches, size_t size, double rse, const ClockCalibration &clock) {
+    double elapsed = 0.;
+    bool resolved = true;
+    for (double ns : batches) {
+        elapsed += ns;
+        resolved = resolved && ns >= CALIBRATION_MIN_RESOLUTIONS * clock.resolution_ns;
+    }
+
+    size_t iterations = batches.size() * size;
+    double corrected = (elapsed - (double) batches.size() * clock.read_ns) / (double) iterations - clock.loop_ns;
+    return {elapsed / (double) iterations, corrected, iterations, rse, resolved && corrected > 0.};
+}
+
+/**
+ * batch(iterations) runs that many round trips and returns their total time
+ * in ns, as measured with the clock clock describes.
+ * */
+Measurement measure_latency(const std::function<double(size_t)> &batch, const ClockCalibration &clock) {
+    const RunLength &length = run_length();
+    if (!length.adaptive || trace_config().enabled) {
+        size_t iterations = trace_config().enabled ? PINGPONG_ITERATIONS : fixed_iterations();
+        return make_measurement({batch(iterations)}, iterations, 0., clock);
+    }
+
+    double min_ns = length.min_ms * 1000000.;
+    double batch_ns = min_ns / (double) ADAPTIVE_MIN_BATCHES;
+    size_t largest = length.max_iterations / ADAPTIVE_MIN_BATCHES;
+
+    // grow by at most 10x a step, aiming a little past the target as Google Benchmark does
+    size_t size = std::min(ADAPTIVE_FIRST_BATCH, largest);
+    double ns = batch(size);
+    while (ns < batch_ns && size < largest) {
+        double grow = ns > 0. ? std::min(10., std::max(2., 1.4 * batch_ns / ns)) : 10.;
+        size = std::min(largest, (size_t) ((double) size * grow));
+        ns = batch(size);
+    }
+
+    std::vector<double> batches = {ns}, means = {ns / (double) size};
+    double elapsed = ns;
+    double rse = 100.;
+    while (true) {
+        double mean = elapsed / (double) (means.size() * size);
+        double variance = 0.;
+        for (double m : means) {
+            variance += (m - mean) * (m - mean);
+        }
+        rse = means.size() > 1 && mean > 0. ? 100. * std::sqrt(variance / (double) (means.size() - 1) / (double) means.size()) / mean : 100.;
+
+        bool settled = means.size() >= ADAPTIVE_MIN_BATCHES && elapsed >= min_ns && rse <= length.target_rse;
+        if (settled || (means.size() + 1) * size > length.max_iterations) {
+            break;
+        }
+
+        ns = batch(size);
+        batches.push_back(ns);
+        means.push_back(ns / (double) size);
+        elapsed += ns;
+    }
+
+    return make_measurement(batches, size, rse, clock);
+}
+
+// one timed agent of a cell: its key, its measurement and the clock that took it
+struct LatencyReport {
+    const char *key;
+    Measurement measurement;
+    const ClockCalibration *clock;
+};
+
+/**
+ * "<key> : <raw> | <key> Corrected : <corrected> ... | Iterations : <n>",
+ * one raw/corrected pair per agent after the cell's own fields, plus the
+ * first agent's RSE when the run length was adaptive. If any measurement
+ * is unresolved the cell is printed on an "Unresolved" line instead and not
+ * recorded.
+ * */
+void report_latencies(const std::string &experiment, const std::vector<LatencyReport> &latencies, const ResultFields &extra = {}) {
+    bool resolved = true;
+    for (const LatencyReport &latency : latencies) {
+        resolved = resolved && latency.measurement.resolved;
+    }
+    if (!resolved) {
+        contamination().finish();
+        std::lock_guard<std::mutex> lock(output_mutex());
+        std::cout << "Info | Unresolved | " << experiment;
+        for (const LatencyReport &latency : latencies) {
+            std::cout << " | " << latency.key << " : " << latency.measurement.latency_ns << " | " << latency.key << " Corrected : " << latency.measurement.corrected_ns << " | " << latency.clock->name << " Resolution ns : " << latency.clock->resolution_ns;
+        }
+        std::cout << std::endl;
+        return;
+    }
+
+    ResultFields fields = extra;
+    for (const LatencyReport &latency : latencies) {
+        fields.push_back({latency.key, latency.measurement.latency_ns});
+        fields.push_back({std::string(latency.key) + " Corrected", latency.measurement.corrected_ns});
+    }
+    fields.push_back({"Iterations", (double) latencies.front().measurement.iterations, DESCRIPTIVE});
+    if (run_length().adaptive && !trace_config().enabled) {
+        fields.push_back({"RSE %", latencies.front().measurement.rse, DESCRIPTIVE});
+    }
+    report_result(experiment, fields);
+}
+
+void report_latency(const std::string &experiment, const char *key, const Measurement &measurement, const ClockCalibration &clock) {
+    report_latencies(experiment, {{key, measurement, &clock}});
+}
+
+/**
+ * A second agent timed alongside the one measure_latency() followed: its
+ * batch times, of which the last ones match the kept measurement.
+ * */
+Measurement companion_measurement(const std::vector<double> &batches, const Measurement &primary, size_t size, const ClockCalibration &clock) {
+    size_t kept = std::max<size_t>(1, primary.iterations / size);
+    return make_measurement(std::vector<double>(batches.end() - (ptrdiff_t) std::min(kept, batches.size()), batches.end()), size, primary.rse, clock);
+}
+
+#endif // RUN_LENGTH_HPP
@@ -0,0 +1,131 @@
+#ifndef SELECTION_HPP
+#define SELECTION_HPP
+
+#include <fnmatch.h>
+#include <strings.h>
+
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "structs.cuh"
+
+/**
+ * Which cells of the hard-wired sequence actually run.
+ *
+ * The experiment name is the label the cell reports its result under, so a
+ * pattern written from the output selects that cell. A cell that has no
+ * such parameter (no scope on a host-only cell, say) does not match a
+ * filter on it. Every cell asks select_cell() before touching the arena, so
+ * a filtered-out group costs nothing.
+ * */
+
+// a cell's parameters, nullptr where one does not apply
+struct CellParams {
+    const char *scope;
+    const char *order;
+    const char *protocol;
+};
+
+struct ExperimentSelection {
+    std::vector<std::string> patterns;
+    std::map<std::string, std::vector<std::string>> filters;
+    bool list_only = false;
+    int listed = 0;
+};
+
+// per thread, so sweep workers can each select their own point's cells
+ExperimentSelection &experiment_selection() {
+    thread_local ExperimentSelection selection;
+    return selection;
+}
+
+std::vector<std::string> split_list(const std::string &list) {
+    std::vector<std::string> values;
+    std::istringstream items(list);
+    std::string item;
+    while (std::getline(items, item, ',')) {
+        if (!item.empty()) {
+            values.push_back(item);
+        }
+    }
+    return values;
+}
+
+bool parse_filter(const char *spec, ExperimentSelection *selection) {
+    std::string filter(spec);
+    size_t equals = filter.find('=');
+    if (equals == std::string::npos) {
+        return false;
+    }
+
+    std::string key = filter.substr(0, equals);
+    if (key != "scope" && key != "order" && key != "protocol" && key != "allocator") {
+        return false;
+    }
+
+    std::vector<std::string> values = split_list(filter.substr(equals + 1));
+    if (values.empty()) {
+        return false;
+    }
+
+    std::vector<std::string> &accepted = selection->filters[key];
+    accepted.insert(accepted.end(), values.begin(), values.end());
+    return true;
+}
+
+bool parse_allocator(const std::string &name, Allocator *allocator) {
+    if (strcasecmp(name.c_str(), "MALLOC") == 0) {
+        *allocator = MALLOC;
+    } else if (strcasecmp(name.c_str(), "HOST") == 0) {
+        *allocator = CUDA_MALLOC_HOST;
+    } else if (strcasecmp(name.c_str(), "UM") == 0) {
+        *allocator = UM;
+    } else if (strcasecmp(name.c_str(), "CUDA_MALLOC") == 0) {
+        *allocator = CUDA_MALLOC;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+bool matches_filter(const ExperimentSelection &selection, const char *key, const char *value) {
+    auto filter = selection.filters.find(key);
+    if (filter == selection.filters.end()) {
+        return true;
+    }
+    if (value == nullptr) {
+        return false;
+    }
+    for (const std::string &accepted : filter->second) {
+        if (strcasecmp(accepted.c_str(), value) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// true when the cell should run now; in list mode prints it instead
+bool select_cell(const std::string &experiment, const CellParams &params) {
+    ExperimentSelection &selection = experiment_selection();
+
+    bool named = selection.patterns.empty();
+    for (const std::string &pattern : selection.patterns) {
+        named = named || fnmatch(pattern.c_str(), experiment.c_str(), FNM_CASEFOLD) == 0;
+    }
+
+    if (!named || !matches_filter(selection, "scope", params.scope) || !matches_filter(selection, "order", params.order) || !matches_filter(selection, "protocol", params.protocol)) {
+        return false;
+    }
+
+    if (selection.list_only) {
+        std::cout << "Info | Experiment | " << experiment << std::endl;
+        selection.listed++;
+        return false;
+    }
+    return true;
+}
+
+#endif // SELECTION_HPP
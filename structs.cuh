@@ -22,7 +22,8 @@ enum Scope {
 
 enum MemOrder {
     RELAXED,
-    ACQ_REL
+    ACQ_REL,
+    SEQ_CST
 };
 
 enum Allocator {
@@ -32,69 +33,51 @@ enum Allocator {
     UM,
 };
 
+inline const char *scope_name(cuda::thread_scope scope) {
+    switch (scope) {
+        case cuda::thread_scope_thread: return "Thread";
+        case cuda::thread_scope_block: return "Block";
+        case cuda::thread_scope_device: return "Device";
+        default: return "System";
+    }
+}
+
+inline const char *order_name(MemOrder order) {
+    switch (order) {
+        case RELAXED: return "Relaxed";
+        case ACQ_REL: return "Acq-Rel";
+        default: return "Seq-Cst";
+    }
+}
+
+// spelled the way -m and -f allocator=... accept them
+inline const char *allocator_name(Allocator allocator) {
+    switch (allocator) {
+        case CUDA_MALLOC_HOST: return "HOST";
+        case MALLOC: return "MALLOC";
+        case CUDA_MALLOC: return "CUDA_MALLOC";
+        default: return "UM";
+    }
+}
+
 enum ProducerConsumerTypes {
     CPU,
     GPU
 };
 
-struct alignedDataSameCacheline_thread {
-    alignas(cpu_cacheline) cuda::atomic<int, cuda::thread_scope_thread> flag;
-    uint32_t data;
-};
-
-struct alignedDataDiffCPUCacheline_thread {
-    alignas(cpu_cacheline) cuda::atomic<int, cuda::thread_scope_thread> flag;
-    alignas(cpu_cacheline) uint32_t data;
-};
-
-struct alignedDataDiffGPUCacheline_thread {
-    alignas(gpu_cacheline) cuda::atomic<int, cuda::thread_scope_thread> flag;
-    alignas(gpu_cacheline) uint32_t data;
-};
-
-struct alignedDataSameCacheline_block {
-    alignas(cpu_cacheline) cuda::atomic<int, cuda::thread_scope_block> flag;
-    uint32_t data;
-};
-
-struct alignedDataDiffCPUCacheline_block {
-    alignas(cpu_cacheline) cuda::atomic<int, cuda::thread_scope_block> flag;
-    alignas(cpu_cacheline) uint32_t data;
-};
-
-struct alignedDataDiffGPUCacheline_block {
-    alignas(gpu_cacheline) cuda::atomic<int, cuda::thread_scope_block> flag;
-    alignas(gpu_cacheline) uint32_t data;
-};
-
-
-struct alignedDataSameCacheline_gpu {
-    alignas(cpu_cacheline) cuda::atomic<int, cuda::thread_scope_device> flag;
-    uint32_t data;
-};
-
-struct alignedDataDiffCPUCacheline_gpu {
-    alignas(cpu_cacheline) cuda::atomic<int, cuda::thread_scope_device> flag;
-    alignas(cpu_cacheline) uint32_t data;
-};
-
-struct alignedDataDiffGPUCacheline_gpu {
-    alignas(gpu_cacheline) cuda::atomic<int, cuda::thread_scope_device> flag;
-    alignas(gpu_cacheline) uint32_t data;
-};
-
-struct alignedDataSameCacheline_sys {
-    alignas(cpu_cacheline) cuda::atomic<int, cuda::thread_scope_system> flag;
+// flag and payload are plain storage; scope and ordering come from the atomic_ref view used on them
+struct alignedDataSameCacheline {
+    alignas(cpu_cacheline) uint32_t flag;
     uint32_t data;
 };
 
-struct alignedDataDiffCPUCacheline_sys {
-    alignas(cpu_cacheline) cuda::atomic<int, cuda::thread_scope_system> flag;
+struct alignedDataDiffCPUCacheline {
+    alignas(cpu_cacheline) uint32_t flag;
     alignas(cpu_cacheline) uint32_t data;
 };
 
-struct alignedDataDiffGPUCacheline_sys {
-    alignas(gpu_cacheline) cuda::atomic<int, cuda::thread_scope_system> flag;
+struct alignedDataDiffGPUCacheline {
+    alignas(gpu_cacheline) uint32_t flag;
     alignas(gpu_cacheline) uint32_t data;
 };
 
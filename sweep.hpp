@@ -0,0 +1,536 @@
+#ifndef SWEEP_HPP
+#define SWEEP_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "arena.cuh"
+#include "compare.hpp"
+#include "cpu_pingpong.hpp"
+#include "json.hpp"
+#include "results.hpp"
+#include "selection.hpp"
+
+/**
+ * Declarative sweeps.
+ *
+ *   {
+ *     "axes": {
+ *       "allocator":  ["MALLOC", "UM"],
+ *       "scope":      ["System", "Device"],
+ *       "order":      ["Relaxed", "Acq-Rel"],
+ *       "protocol":   ["Base", "Decoupled"],
+ *       "cores":      [[0, 1], [0, 2]],
+ *       "iterations": [1000, 10000]
+ *     },
+ *     "exclude": [ {"allocator": "UM", "protocol": "Base"} ],
+ *     "trials": 3
+ *   }
+ *
+ * Every combination of axis values that no exclusion matches is a point,
+ * run "trials" times under the current mode. An exclusion matches when all
+ * of its keys equal the point's values, so an empty one would drop every
+ * point and is rejected. "iterations" sets fixed_iterations(), which -a and
+ * -T override.
+ *
+ * Each finished point is appended to <file>.cache under a key hashed from
+ * the binary, the platform fingerprint, the mode, every option that changes
+ * which cells run or what they report (sweep_options()) and the point, so
+ * an interrupted or extended sweep only runs what is missing, and a rebuild
+ * or another machine invalidates the cache by construction.
+ * */
+
+const char *const SWEEP_AXES[] = {"allocator", "scope", "order", "protocol", "cores", "iterations"};
+
+typedef std::vector<std::pair<std::string, std::string>> SweepPoint;
+
+struct Sweep {
+    std::vector<std::pair<std::string, std::vector<std::string>>> axes;
+    std::vector<std::map<std::string, std::string>> exclusions;
+    int trials = 1;
+};
+
+bool known_axis(const std::string &name) {
+    for (const char *axis : SWEEP_AXES) {
+        if (name == axis) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool load_sweep_file(const char *path, Sweep *sweep) {
+    std::ifstream in(path);
+    if (!in) {
+        std::cout << "Could not open sweep " << path << std::endl;
+        return false;
+    }
+    std::stringstream text;
+    text << in.rdbuf();
+
+    JsonValue root;
+    std::string error;
+    if (!parse_json(text.str(), &root, &error)) {
+        std::cout << "Sweep " << path << ": " << error << std::endl;
+        return false;
+    }
+
+    const JsonValue *axes = root.find("axes");
+    if (axes == nullptr || axes->kind != JsonValue::OBJECT) {
+        std::cout << "Sweep " << path << " has no axes" << std::endl;
+        return false;
+    }
+
+    for (const auto &axis : axes->object) {
+        if (!known_axis(axis.first) || axis.second.kind != JsonValue::ARRAY || axis.second.array.empty()) {
+            std::cout << "Sweep " << path << ": unsupported axis " << axis.first << std::endl;
+            return false;
+        }
+
+        std::vector<std::string> values;
+        for (const JsonValue &value : axis.second.array) {
+            values.push_back(value.text());
+        }
+        sweep->axes.push_back({axis.first, values});
+    }
+
+    // an empty rule would match, and drop, every point
+    if (const JsonValue *exclude = root.find("exclude")) {
+        if (exclude->kind != JsonValue::ARRAY) {
+            std::cout << "Sweep " << path << ": exclude is not an array of rules" << std::endl;
+            return false;
+        }
+        for (size_t i = 0; i < exclude->array.size(); ++i) {
+            const JsonValue &rule = exclude->array[i];
+            if (rule.kind != JsonValue::OBJECT || rule.object.empty()) {
+                std::cout << "Sweep " << path << ": exclusion " << i << " is not an object naming at least one axis" << std::endl;
+                return false;
+            }
+            std::map<std::string, std::string> exclusion;
+            for (const auto &key : rule.object) {
+                if (!known_axis(key.first)) {
+                    std::cout << "Sweep " << path << ": exclusion names unsupported axis " << key.first << std::endl;
+                    return false;
+                }
+                exclusion[key.first] = key.second.text();
+            }
+            sweep->exclusions.push_back(exclusion);
+        }
+    }
+
+    if (const JsonValue *trials = root.find("trials")) {
+        if (trials->kind != JsonValue::NUMBER || trials->number < 1. || trials->number != std::floor(trials->number)) {
+            std::cout << "Sweep " << path << ": trials " << trials->text() << " is not a positive integer" << std::endl;
+            return false;
+        }
+        sweep->trials = (int) trials->number;
+    }
+
+    return true;
+}
+
+bool excluded(const Sweep &sweep, const SweepPoint &point) {
+    for (const auto &exclusion : sweep.exclusions) {
+        size_t matched = 0;
+        for (const auto &axis : point) {
+            auto rule = exclusion.find(axis.first);
+            if (rule != exclusion.end() && strcasecmp(rule->second.c_str(), axis.second.c_str()) == 0) {
+                matched++;
+            }
+        }
+        if (matched == exclusion.size()) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// cartesian product, first axis varying slowest
+std::vector<SweepPoint> expand_sweep(const Sweep &sweep) {
+    std::vector<SweepPoint> points(1);
+    for (const auto &axis : sweep.axes) {
+        std::vector<SweepPoint> extended;
+        for (const SweepPoint &point : points) {
+            for (const std::string &value : axis.second) {
+                SweepPoint next = point;
+                next.push_back({axis.first, value});
+                extended.push_back(next);
+            }
+        }
+        points = extended;
+    }
+
+    std::vector<SweepPoint> kept;
+    for (const SweepPoint &point : points) {
+        if (!excluded(sweep, point)) {
+            kept.push_back(point);
+        }
+    }
+    return kept;
+}
+
+// the running executable's bytes, hashed once
+uint64_t binary_hash() {
+    static uint64_t hash = [] {
+        std::ifstream in("/proc/self/exe", std::ios::binary);
+        std::stringstream bytes;
+        bytes << in.rdbuf();
+        return fnv1a(bytes.str());
+    }();
+    return hash;
+}
+
+// every option outside the mode that changes which cells run or what they report
+std::string sweep_options(const ExperimentSelection &selection, const CorePair &cores) {
+    std::ostringstream options;
+    for (const std::string &pattern : selection.patterns) {
+        options << "|e=" << pattern;
+    }
+    for (const auto &filter : selection.filters) {
+        options << "|f=" << filter.first;
+        for (const std::string &value : filter.second) {
+            options << ',' << value;
+        }
+    }
+    options << "|L=" << selection.list_only << "|p=" << cores.first << ',' << cores.second
+            << "|J=" << (low_jitter().enabled ? low_jitter().priority : -1)
+            << "|x=" << contamination_config().discard
+            << "|T=" << (trace_config().enabled ? trace_config().prefix : std::string());
+    return options.str();
+}
+
+std::string sweep_key(const SweepPoint &point, const std::string &mode, const std::string &options, int trials) {
+    std::ostringstream parameters;
+    parameters << binary_hash() << '|' << platform().id << '|' << mode << options << '|' << trials;
+    for (const auto &axis : point) {
+        parameters << '|' << axis.first << '=' << axis.second;
+    }
+
+    char key[17];
+    snprintf(key, sizeof(key), "%016llx", (unsigned long long) fnv1a(parameters.str()));
+    return key;
+}
+
+/**
+ * Cache file: one block per finished point,
+ *   <key> begin / <key> <result line>... / <key> done
+ * Only blocks that reached "done" count; a block cut short by an interrupt
+ * is dropped and its point runs again. A point whose cells were all
+ * filtered out is cached with no result lines.
+ * */
+std::map<std::string, std::vector<std::string>> load_sweep_cache(const std::string &path) {
+    std::map<std::string, std::vector<std::string>> pending, finished;
+    std::ifstream in(path);
+    std::string line;
+    while (std::getline(in, line)) {
+        size_t space = line.find(' ');
+        if (space == std::string::npos) {
+            continue;
+        }
+
+        std::string key = line.substr(0, space);
+        std::string rest = line.substr(space + 1);
+        if (rest == "begin") {
+            pending[key].clear();
+        } else if (rest == "done") {
+            finished[key] = pending[key];
+        } else {
+            pending[key].push_back(rest);
+        }
+    }
+    return finished;
+}
+
+std::string describe_point(const SweepPoint &point) {
+    std::string description;
+    for (const auto &axis : point) {
+        description += (description.empty() ? "" : ", ") + axis.first + "=" + axis.second;
+    }
+    return description;
+}
+
+/**
+ * Core pairs for parallel sweep workers: at most one per NUMA node (its own
+ * memory controller), inside one last-level cache of that node, on two
+ * distinct physical cores. Two workers then share neither a cache nor a
+ * memory controller, only the interconnect between them.
+ *
+ * With per_llc (-j <n>:llc) every last-level cache with two physical cores
+ * gets a pair, so single-node machines with several LLCs can run in
+ * parallel too; those workers do share their node's memory controller.
+ * */
+std::vector<CorePair> disjoint_core_pairs(size_t limit, bool per_llc) {
+    std::map<int, std::map<int, std::vector<int>>> cores;   // node -> llc -> one CPU per physical core
+    for (const CpuPlacement &placement : cpu_placements()) {
+        if (placement.core == placement.cpu) {
+            cores[placement.node][placement.llc].push_back(placement.cpu);
+        }
+    }
+
+    std::vector<CorePair> pairs;
+    for (const auto &node : cores) {
+        for (const auto &llc : node.second) {
+            if (llc.second.size() >= 2 && pairs.size() < limit) {
+                pairs.push_back({llc.second[0], llc.second[1]});
+                if (!per_llc) break;
+            }
+        }
+    }
+    return pairs;
+}
+
+// a point resolved into the per-thread state its cells read
+struct SweepTask {
+    SweepPoint point;
+    std::string key;
+    Allocator allocator = MALLOC;
+    bool pinned = false;        // the point has its own cores axis value
+    CorePair cores;
+    size_t iterations = PINGPONG_ITERATIONS;
+    ExperimentSelection selection;
+};
+
+bool resolve_point(const SweepPoint &point, const ExperimentSelection &base, SweepTask *task) {
+    task->point = point;
+    task->selection = base;
+    for (const auto &axis : point) {
+        if (axis.first == "allocator") {
+            if (!parse_allocator(axis.second, &task->allocator)) {
+                std::cout << "Sweep point " << describe_point(point) << ": invalid allocator" << std::endl;
+                return false;
+            }
+        } else if (axis.first == "cores") {
+            if (sscanf(axis.second.c_str(), "%d,%d", &task->cores.first, &task->cores.second) != 2) {
+                std::cout << "Sweep point " << describe_point(point) << ": cores must be a pair" << std::endl;
+                return false;
+            }
+            task->pinned = true;
+        } else if (axis.first == "iterations") {
+            long iterations = atol(axis.second.c_str());
+            if (iterations < 1) {
+                std::cout << "Sweep point " << describe_point(point) << ": iterations must be positive" << std::endl;
+                return false;
+            }
+            task->iterations = (size_t) iterations;
+        } else {
+            task->selection.filters[axis.first] = {axis.second};
+        }
+    }
+    return true;
+}
+
+// runs one point on the calling thread and returns what its cells reported
+std::vector<ResultRecord> run_point(const SweepTask &task, const CorePair &cores, int trials, bool exclusive, const std::function<void(Arena &)> &run) {
+    experiment_selection() = task.selection;
+    core_pair() = task.pinned ? task.cores : cores;
+    current_allocator() = allocator_name(task.allocator);
+    fixed_iterations() = task.iterations;
+
+    std::vector<ResultRecord> records;
+    result_capture() = {&records, exclusive};
+    {
+        Arena arena(task.allocator);
+        for (int trial = 0; trial < trials; ++trial) {
+            run(arena);
+        }
+    }
+    result_capture() = {};
+    fixed_iterations() = PINGPONG_ITERATIONS;
+    return records;
+}
+
+constexpr size_t INTERFERENCE_SAMPLE = 10;          // re-run one point in this many alone
+constexpr double INTERFERENCE_THRESHOLD = 10.;      // percent
+
+/**
+ * Compares a point's parallel results, trial by trial, with a re-run on an
+ * otherwise idle machine and prints, per result, the field that moved most.
+ * Returns the number of results that moved more than INTERFERENCE_THRESHOLD.
+ * */
+size_t check_interference(const std::vector<ResultRecord> &parallel, const std::vector<ResultRecord> &alone) {
+    size_t diverged = 0;
+    auto same = [](const ResultRecord &a, const ResultRecord &b) { return a.experiment == b.experiment && a.allocator == b.allocator; };
+    for (size_t i = 0; i < parallel.size(); ++i) {
+        // the n-th repeat of a result against the n-th repeat alone; either run may have dropped one (-x, Unresolved)
+        size_t occurrence = (size_t) std::count_if(parallel.begin(), parallel.begin() + i, [&](const ResultRecord &record) { return same(record, parallel[i]); });
+        auto match = alone.begin();
+        for (size_t seen = 0; match != alone.end(); ++match) {
+            if (same(*match, parallel[i]) && seen++ == occurrence) break;
+        }
+        if (match == alone.end()) {
+            continue;
+        }
+
+        std::string worst;
+        double worst_parallel = 0., worst_alone = 0., worst_delta = 0.;
+        for (size_t f = 0; f < parallel[i].fields.size() && f < match->fields.size(); ++f) {
+            const auto &field = parallel[i].fields[f];
+            double reference = match->fields[f].value;
+            if (field.key != match->fields[f].key) {
+                continue;
+            }
+            if (field.kind == DESCRIPTIVE || reference == 0.) {
+                continue;
+            }
+            double delta = 100. * (field.value - reference) / reference;
+            if (worst.empty() || std::fabs(delta) > std::fabs(worst_delta)) {
+                worst = field.key;
+                worst_parallel = field.value;
+                worst_alone = reference;
+                worst_delta = delta;
+            }
+        }
+        if (worst.empty()) {
+            continue;
+        }
+
+        bool moved = std::fabs(worst_delta) > INTERFERENCE_THRESHOLD;
+        diverged += moved;
+        std::cout << "Info | Interference | " << parallel[i].experiment << " | Allocator : " << parallel[i].allocator << " | Field : " << worst << " | Parallel : " << worst_parallel << " | Alone : " << worst_alone << " | Delta % : " << worst_delta << " | " << (moved ? "DIVERGED" : "OK") << std::endl;
+    }
+    return diverged;
+}
+
+/**
+ * Runs (or replays) every point. run(arena) is the mode the binary was
+ * started in; it runs the sequence under whatever experiment_selection()
+ * currently holds.
+ *
+ * With workers != 1 (0 = as many as the topology allows), uncached points
+ * are spread over threads that each own a pair from disjoint_core_pairs()
+ * (one per node, or one per LLC with per_llc) and run one point at a time.
+ * Afterwards a sample of those points is run again alone and checked
+ * against its parallel numbers. Points that bring
+ * their own cores, and modes that launch kernels on a machine with a device
+ * (every cell shares it), run serially.
+ * */
+bool run_sweep(const char *path, const std::string &mode, bool launches_kernels, int workers, bool per_llc, const std::function<void(Arena &)> &run) {
+    Sweep sweep;
+    if (!load_sweep_file(path, &sweep)) {
+        return false;
+    }
+
+    std::string cache_path = std::string(path) + ".cache";
+    auto cache = load_sweep_cache(cache_path);
+    std::ofstream cache_out(cache_path, std::ios::app);
+
+    ExperimentSelection base = experiment_selection();
+    CorePair base_cores = core_pair();
+    std::string base_allocator = current_allocator();
+
+    std::string options = sweep_options(base, base_cores);
+    std::vector<SweepPoint> points = expand_sweep(sweep);
+    std::vector<SweepTask> tasks;
+    size_t replayed = 0;
+    bool pinned = false;
+
+    for (const SweepPoint &point : points) {
+        std::string key = sweep_key(point, mode, options, sweep.trials);
+
+        auto cached = cache.find(key);
+        if (cached != cache.end()) {
+            for (const std::string &line : cached->second) {
+                ResultRecord record;
+                if (parse_result_line(line, &record)) {
+                    result_records().push_back(record);
+                }
+                std::cout << line << std::endl;
+            }
+            replayed++;
+            continue;
+        }
+
+        SweepTask task;
+        if (!resolve_point(point, base, &task)) {
+            return false;
+        }
+        task.key = key;
+        pinned = pinned || task.pinned;
+        tasks.push_back(task);
+    }
+
+    std::vector<CorePair> pairs;
+    if (workers != 1 && !tasks.empty()) {
+        if (pinned) {
+            std::cout << "Info | Sweep | Serial : points choose their own cores" << std::endl;
+        } else if (launches_kernels && platform().has_device) {
+            std::cout << "Info | Sweep | Serial : cells share the device" << std::endl;
+        } else {
+            pairs = disjoint_core_pairs(workers == 0 ? tasks.size() : (size_t) workers, per_llc);
+            if (pairs.size() < 2 && per_llc) {
+                std::cout << "Info | Sweep | Serial : no two last-level caches with two cores each" << std::endl;
+                pairs.clear();
+            } else if (pairs.size() < 2) {
+                std::cout << "Info | Sweep | Serial : no two core pairs share neither cache nor memory controller (-j <n>:llc allows one pair per last-level cache)" << std::endl;
+                pairs.clear();
+            }
+        }
+    }
+
+    // written only once the point has finished, so an interrupted point reruns
+    std::mutex cache_mutex;
+    auto finish = [&](const SweepTask &task, const std::vector<ResultRecord> &records) {
+        std::lock_guard<std::mutex> lock(cache_mutex);
+        cache_out << task.key << " begin\n";
+        for (const ResultRecord &record : records) {
+            cache_out << task.key << ' ' << format_result(record) << '\n';
+        }
+        cache_out << task.key << " done" << std::endl;
+    };
+
+    if (pairs.empty()) {
+        for (const SweepTask &task : tasks) {
+            std::cout << "Info | Sweep | " << describe_point(task.point) << std::endl;
+            finish(task, run_point(task, base_cores, sweep.trials, false, run));
+        }
+    } else {
+        std::vector<std::vector<ResultRecord>> results(tasks.size());
+        std::atomic<size_t> next(0);
+
+        std::vector<std::thread> threads;
+        for (const CorePair &cores : pairs) {
+            threads.emplace_back([&, cores]() {
+                for (size_t i = next++; i < tasks.size(); i = next++) {
+                    {
+                        std::lock_guard<std::mutex> lock(output_mutex());
+                        std::cout << "Info | Sweep | " << describe_point(tasks[i].point) << " | Cores : " << cores.first << "," << cores.second << std::endl;
+                    }
+                    results[i] = run_point(tasks[i], cores, sweep.trials, false, run);
+                    finish(tasks[i], results[i]);
+                }
+            });
+        }
+        for (std::thread &thread : threads) {
+            thread.join();
+        }
+
+        size_t sampled = 0, diverged = 0;
+        for (size_t i = 0; i < tasks.size(); i += INTERFERENCE_SAMPLE) {
+            std::cout << "Info | Interference | Re-running alone : " << describe_point(tasks[i].point) << std::endl;
+            diverged += check_interference(results[i], run_point(tasks[i], pairs[0], sweep.trials, true, run));
+            sampled++;
+        }
+        std::cout << "Info | Sweep | Parallel | Workers : " << pairs.size() << " | Re-run : " << sampled << " | Diverged : " << diverged << std::endl;
+    }
+
+    experiment_selection() = base;
+    core_pair() = base_cores;
+    current_allocator() = base_allocator;
+
+    std::cout << "Info | Sweep | Points : " << points.size() << " | Cached : " << replayed << " | Cache : " << cache_path << std::endl;
+    return true;
+}
+
+#endif // SWEEP_HPP
@@ -0,0 +1,125 @@
+#ifndef TOKEN_RING_HPP
+#define TOKEN_RING_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <set>
+#include <sstream>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include "cpu_utils.hpp"
+#include "pingpong_protocols.cuh"
+#include "platform.hpp"
+
+/**
+ * Token ring across N host agents.
+ *
+ * Agent i only ever reads its own flag and writes its successor's, so each
+ * line bounces between two neighbours, as in a staged pipeline. Flags count
+ * the tokens handed to an agent; agent 0 starts out holding every token.
+ * Agents take one CPU per physical core in (node, LLC, core) order, so
+ * growing N fills an LLC, then the next LLC, then the next node.
+ * */
+
+constexpr size_t RING_PASSES = PINGPONG_ITERATIONS;
+
+struct RingSweep {
+    std::vector<size_t> agents;
+    size_t tokens = 1;
+};
+
+bool parse_ring_sweep(const char *spec, RingSweep *sweep) {
+    const char *tokens = strchr(spec, ':');
+    std::string agents(spec, tokens == nullptr ? strlen(spec) : (size_t) (tokens - spec));
+
+    sweep->agents.clear();
+    std::istringstream list(agents);
+    std::string count;
+    while (std::getline(list, count, ',')) {
+        int value = atoi(count.c_str());
+        if (value < 2) {
+            return false;
+        }
+        sweep->agents.push_back((size_t) value);
+    }
+
+    sweep->tokens = 1;
+    if (tokens != nullptr) {
+        int value = atoi(tokens + 1);
+        if (value < 1) {
+            return false;
+        }
+        sweep->tokens = (size_t) value;
+    }
+    return !sweep->agents.empty();
+}
+
+// n CPUs in (node, LLC, core) order, physical cores before SMT siblings; fewer if the machine has fewer
+std::vector<CpuPlacement> ring_placements(size_t n) {
+    std::vector<CpuPlacement> cpus = cpu_placements();
+    std::sort(cpus.begin(), cpus.end(), [](const CpuPlacement &a, const CpuPlacement &b) {
+        return std::tie(a.node, a.llc, a.core, a.cpu) < std::tie(b.node, b.llc, b.core, b.cpu);
+    });
+
+    std::vector<CpuPlacement> primary, siblings;
+    std::set<int> seen;
+    for (const CpuPlacement &placement : cpus) {
+        (seen.insert(placement.core).second ? primary : siblings).push_back(placement);
+    }
+    primary.insert(primary.end(), siblings.begin(), siblings.end());
+    primary.resize(std::min(n, primary.size()));
+    return primary;
+}
+
+// every agent but 0: passes on each token it is handed
+void ring_relay(uint64_t *own, uint64_t *next, size_t passes) {
+    std::atomic_ref<uint64_t> received(*own);
+    std::atomic_ref<uint64_t> sent(*next);
+
+    for (uint64_t k = 1; k <= passes; ++k) {
+        while (received.load(std::memory_order_acquire) < k);
+        sent.store(k, std::memory_order_release);
+    }
+}
+
+/**
+ * Agent 0: sends token k once k - tokens have come back, and stamps every
+ * send and return in CPU ticks. elapsed runs from the first send to the
+ * last return.
+ * */
+void ring_origin(uint64_t *own, uint64_t *next, size_t passes, size_t tokens, std::vector<uint64_t> *sends, std::vector<uint64_t> *returns, uint64_t *elapsed) {
+    std::atomic_ref<uint64_t> received(*own);
+    std::atomic_ref<uint64_t> sent(*next);
+    sends->assign(passes, 0);
+    returns->assign(passes, 0);
+
+    size_t returned = 0;
+    auto collect = [&]() {
+        uint64_t back = received.load(std::memory_order_acquire);
+        uint64_t now = get_cpu_clock();
+        for (; returned < back; ++returned) {
+            (*returns)[returned] = now;
+        }
+    };
+
+    uint64_t start = get_cpu_clock();
+    for (uint64_t k = 1; k <= passes; ++k) {
+        while (returned + tokens < k) {
+            collect();
+        }
+        (*sends)[k - 1] = get_cpu_clock();
+        sent.store(k, std::memory_order_release);
+    }
+
+    while (returned < passes) {
+        collect();
+    }
+    *elapsed = get_cpu_clock() - start;
+}
+
+#endif // TOKEN_RING_HPP
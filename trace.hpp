@@ -0,0 +1,175 @@
+#ifndef TRACE_HPP
+#define TRACE_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "arena.cuh"
+#include "pingpong_protocols.cuh"
+
+/**
+ * Optional per-round-trip tracing.
+ *
+ * Each agent of a ping/pong cell gets a TRACE_EVENTS buffer in the arena
+ * and stamps every receive and send into it (see Agent::stamp). After the
+ * cell has finished, both buffers are converted to nanoseconds and written
+ * as Chrome trace-event JSON, which Perfetto and chrome://tracing open.
+ *
+ * The two agents stamp in different clock domains (cntvct_el0, globaltimer),
+ * so the pong timeline is shifted onto the ping timeline. The offset comes
+ * from the trace itself: every ping send / pong receive / pong send / ping
+ * receive quadruple is an NTP-style exchange, and the one with the smallest
+ * round trip bounds the offset most tightly (error <= round trip / 2).
+ * */
+
+struct TraceConfig {
+    bool enabled = false;
+    std::string prefix;
+    std::atomic<int> written{0};
+};
+
+TraceConfig &trace_config() {
+    static TraceConfig config;
+    return config;
+}
+
+// nullptr unless tracing is on, so the protocols skip stamping entirely
+uint64_t *trace_slot(Arena &arena) {
+    return trace_config().enabled ? arena.slot<uint64_t>(TRACE_EVENTS) : nullptr;
+}
+
+// one agent's stamps, in nanoseconds of its own clock domain
+struct AgentTrace {
+    std::string name;
+    std::vector<double> ns;
+
+    double at(size_t i, TraceEvent event) const { return ns[2 * i + event]; }
+    size_t rounds() const { return ns.size() / 2; }
+};
+
+AgentTrace read_trace(const Arena &arena, const uint64_t *trace, const std::string &name, double ns_per_tick) {
+    std::vector<uint64_t> ticks(TRACE_EVENTS);
+    arena.read(trace, TRACE_EVENTS, ticks.data());
+
+    AgentTrace agent = {name, std::vector<double>(TRACE_EVENTS)};
+    for (size_t i = 0; i < TRACE_EVENTS; ++i) {
+        agent.ns[i] = (double) ticks[i] * ns_per_tick;
+    }
+    return agent;
+}
+
+double host_ns_per_tick() {
+    return 1000000000. / (double) get_cpu_freq();
+}
+
+// globaltimer already counts nanoseconds
+double device_ns_per_tick() {
+    return 1.;
+}
+
+struct ClockOffset {
+    double offset_ns;   // add to a server timestamp to land on the client timeline
+    double error_ns;    // half of the round trip the estimate came from
+    double at_ns;       // client time of that exchange
+};
+
+/**
+ * Cristian/NTP offset from exchanges t1 (client send), t2 (server receive),
+ * t3 (server send), t4 (client receive). Keeps the exchange with the
+ * smallest round trip, where queueing and scheduling noise is least.
+ * */
+ClockOffset estimate_clock_offset(const std::vector<double> &t1, const std::vector<double> &t2, const std::vector<double> &t3, const std::vector<double> &t4) {
+    ClockOffset best = {0., -1., 0.};
+    for (size_t i = 0; i < t1.size(); ++i) {
+        double round_trip = (t4[i] - t1[i]) - (t3[i] - t2[i]);
+        if (round_trip < 0.) {
+            continue;
+        }
+        if (best.error_ns < 0. || round_trip / 2. < best.error_ns) {
+            best.offset_ns = ((t1[i] - t2[i]) + (t4[i] - t3[i])) / 2.;
+            best.error_ns = round_trip / 2.;
+            best.at_ns = t1[i];
+        }
+    }
+    return best;
+}
+
+// ping send i -> pong receive i -> pong send i -> ping receive i + 1
+ClockOffset pingpong_offset(const AgentTrace &ping, const AgentTrace &pong) {
+    std::vector<double> t1, t2, t3, t4;
+    for (size_t i = 0; i + 1 < ping.rounds(); ++i) {
+        t1.push_back(ping.at(i, TRACE_SEND));
+        t2.push_back(pong.at(i, TRACE_RECEIVE));
+        t3.push_back(pong.at(i, TRACE_SEND));
+        t4.push_back(ping.at(i + 1, TRACE_RECEIVE));
+    }
+    return estimate_clock_offset(t1, t2, t3, t4);
+}
+
+void write_trace_agent(std::ofstream &out, const AgentTrace &agent, int tid, double shift_ns, int flow_out, int flow_in, bool &first) {
+    char line[256];
+
+    snprintf(line, sizeof(line), "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":\"%s\"}}", first ? "" : ",\n", tid, agent.name.c_str());
+    out << line;
+    first = false;
+
+    for (size_t i = 0; i < agent.rounds(); ++i) {
+        double receive = (agent.at(i, TRACE_RECEIVE) + shift_ns) / 1000.;
+        double send = (agent.at(i, TRACE_SEND) + shift_ns) / 1000.;
+
+        // waiting for the peer since our previous send
+        if (i > 0) {
+            double previous = (agent.at(i - 1, TRACE_SEND) + shift_ns) / 1000.;
+            snprintf(line, sizeof(line), ",\n{\"name\":\"wait\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f,\"args\":{\"round\":%zu}}", tid, previous, receive - previous, i);
+            out << line;
+        }
+
+        // ping's first PING comes from pong's untraced initial store
+        long received = flow_in + 2 * (long) i;
+        if (received >= 0) {
+            snprintf(line, sizeof(line), ",\n{\"name\":\"flag\",\"cat\":\"flag\",\"ph\":\"f\",\"bp\":\"e\",\"id\":%ld,\"pid\":1,\"tid\":%d,\"ts\":%.3f}", received, tid, receive);
+            out << line;
+        }
+        snprintf(line, sizeof(line), ",\n{\"name\":\"send\",\"ph\":\"i\",\"s\":\"t\",\"pid\":1,\"tid\":%d,\"ts\":%.3f}", tid, send);
+        out << line;
+        snprintf(line, sizeof(line), ",\n{\"name\":\"flag\",\"cat\":\"flag\",\"ph\":\"s\",\"id\":%ld,\"pid\":1,\"tid\":%d,\"ts\":%.3f}", flow_out + 2 * (long) i, tid, send);
+        out << line;
+    }
+}
+
+void export_trace(const std::string &experiment, AgentTrace ping, AgentTrace pong) {
+    TraceConfig &config = trace_config();
+    ClockOffset offset = pingpong_offset(ping, pong);
+
+    // ping's first receive is time zero
+    double origin = ping.at(0, TRACE_RECEIVE);
+
+    std::string slug;
+    for (char c : experiment) {
+        slug += isalnum((unsigned char) c) ? c : '_';
+    }
+    std::string path = config.prefix + std::to_string(config.written++) + "-" + slug + ".json";
+
+    std::ofstream out(path);
+    if (!out) {
+        std::cout << "Could not write trace " << path << std::endl;
+        return;
+    }
+
+    // flows: ping's send i lands at pong's receive i (even ids), pong's send i at ping's receive i + 1 (odd ids)
+    bool first = true;
+    out << "{\"displayTimeUnit\":\"ns\",\"otherData\":{\"experiment\":\"" << experiment << "\",\"offset_ns\":" << offset.offset_ns << ",\"error_ns\":" << offset.error_ns << "},\"traceEvents\":[\n";
+    write_trace_agent(out, ping, 1, -origin, 0, -1, first);
+    write_trace_agent(out, pong, 2, offset.offset_ns - origin, 1, 0, first);
+    out << "\n]}\n";
+
+    std::cout << "Info | Trace | " << experiment << " | File : " << path << " | Offset : " << offset.offset_ns << " | Error : " << offset.error_ns << std::endl;
+}
+
+#endif // TRACE_HPP
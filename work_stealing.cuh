@@ -0,0 +1,227 @@
+#ifndef WORK_STEALING_CUH
+#define WORK_STEALING_CUH
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "cpu_utils.hpp"
+#include "pingpong_protocols.cuh"
+
+/**
+ * Chase-Lev work-stealing deque, written once against the agent policy.
+ *
+ *  Acq-Rel     the weakest correct mapping (Le et al., PPoPP'13): release
+ *              push, acquire steal, seq_cst CAS on top, and a seq_cst
+ *              fence() between take's bottom store and top load and
+ *              between steal's top and bottom loads
+ *  Seq-Cst     every access seq_cst, no fences
+ *
+ * Relaxed is not offered; without the fences take and steal can both win
+ * the last task. The buffer is a fixed power-of-two ring (WS_CAPACITY); the
+ * benchmark never has more than WS_BATCH tasks in flight, so it is not
+ * grown.
+ * */
+
+constexpr size_t WS_CAPACITY = 4096;
+constexpr size_t WS_BATCH = 64;
+constexpr size_t WS_TASKS = 10 * PINGPONG_ITERATIONS;
+
+struct WorkDeque {
+    int64_t *top;           // each on its own line
+    int64_t *bottom;
+    uint64_t *tasks;        // WS_CAPACITY of them
+};
+
+#pragma nv_exec_check_disable
+template <typename Agent, MemOrder Order>
+__host__ __device__ void deque_push(const WorkDeque &deque, uint64_t task) {
+    typedef ProtocolOrders<Agent, Order> O;
+    typename Agent::template ref<int64_t> bottom(*deque.bottom);
+
+    int64_t b = bottom.load(Agent::relaxed);
+    typename Agent::template ref<uint64_t>(deque.tasks[b & (WS_CAPACITY - 1)]).store(task, Agent::relaxed);
+    bottom.store(b + 1, O::store);
+}
+
+// owner side; false once the deque is empty
+#pragma nv_exec_check_disable
+template <typename Agent, MemOrder Order>
+__host__ __device__ bool deque_take(const WorkDeque &deque, uint64_t *task) {
+    typename Agent::template ref<int64_t> bottom(*deque.bottom);
+    typename Agent::template ref<int64_t> top(*deque.top);
+
+    int64_t b = bottom.load(Agent::relaxed) - 1;
+    bottom.store(b, Order == SEQ_CST ? Agent::seq_cst : Agent::relaxed);
+    if (Order != SEQ_CST) Agent::fence();
+    int64_t t = top.load(Order == SEQ_CST ? Agent::seq_cst : Agent::relaxed);
+
+    if (t > b) {
+        bottom.store(b + 1, Agent::relaxed);
+        return false;
+    }
+
+    *task = typename Agent::template ref<uint64_t>(deque.tasks[b & (WS_CAPACITY - 1)]).load(Agent::relaxed);
+    if (t == b) {
+        // the last task: race the thieves for it
+        bool won = top.compare_exchange_strong(t, t + 1, Agent::seq_cst, Agent::relaxed);
+        bottom.store(b + 1, Agent::relaxed);
+        return won;
+    }
+    return true;
+}
+
+enum StealResult {
+    STEAL_EMPTY,
+    STEAL_LOST,     // another thief or the owner took it first
+    STEAL_WON
+};
+
+#pragma nv_exec_check_disable
+template <typename Agent, MemOrder Order>
+__host__ __device__ StealResult deque_steal(const WorkDeque &deque, uint64_t *task) {
+    typedef ProtocolOrders<Agent, Order> O;
+    typename Agent::template ref<int64_t> bottom(*deque.bottom);
+    typename Agent::template ref<int64_t> top(*deque.top);
+
+    int64_t t = top.load(O::load);
+    if (Order != SEQ_CST) Agent::fence();
+    int64_t b = bottom.load(O::load);
+
+    if (t >= b) {
+        return STEAL_EMPTY;
+    }
+    *task = typename Agent::template ref<uint64_t>(deque.tasks[t & (WS_CAPACITY - 1)]).load(Agent::relaxed);
+    return top.compare_exchange_strong(t, t + 1, Agent::seq_cst, Agent::relaxed) ? STEAL_WON : STEAL_LOST;
+}
+
+struct StealSweep {
+    std::vector<double> grains_ns;
+    size_t max_thieves = 0;     // 0 for every CPU but the owner's
+};
+
+bool parse_steal_sweep(const char *spec, StealSweep *sweep) {
+    const char *thieves = strchr(spec, ':');
+    std::string grains(spec, thieves == nullptr ? strlen(spec) : (size_t) (thieves - spec));
+
+    sweep->grains_ns.clear();
+    std::istringstream list(grains);
+    std::string grain;
+    while (std::getline(list, grain, ',')) {
+        if (grain.empty() || atof(grain.c_str()) < 0.) {
+            return false;
+        }
+        sweep->grains_ns.push_back(atof(grain.c_str()));
+    }
+
+    sweep->max_thieves = 0;
+    if (thieves != nullptr && (sweep->max_thieves = (size_t) atoi(thieves + 1)) < 1) {
+        return false;
+    }
+    return !sweep->grains_ns.empty();
+}
+
+// 0, 1, 2, 4, ... max
+std::vector<size_t> thief_counts(size_t max) {
+    std::vector<size_t> counts = {0};
+    for (size_t count = 1; count < max; count *= 2) {
+        counts.push_back(count);
+    }
+    if (max > 0) counts.push_back(max);
+    return counts;
+}
+
+inline void run_task(uint64_t grain_ticks) {
+    uint64_t until = get_cpu_clock() + grain_ticks;
+    while (get_cpu_clock() < until);
+}
+
+// the owner's go flag, then one line per thief
+enum StealSlot {
+    STEAL_EXECUTED,     // tasks run, published after each
+    STEAL_ATTEMPTS,     // steals that found a task, won or lost
+    STEAL_SLOTS
+};
+
+struct StealRun {
+    uint64_t elapsed;           // CPU ticks, first push to last task finished anywhere
+    uint64_t push_ticks;        // WS_CAPACITY uncontended pushes
+    uint64_t pop_ticks;         // and as many pops
+};
+
+/**
+ * Times the fast path, then raises go (1) and works through WS_TASKS; once
+ * every task has run somewhere it raises stop (2).
+ * */
+template <MemOrder Order>
+void steal_owner(WorkDeque deque, uint64_t *go_ptr, const std::vector<uint64_t *> &thieves, uint64_t grain_ticks, StealRun *run) {
+    std::atomic_ref<uint64_t> go(*go_ptr);
+    uint64_t task;
+
+    uint64_t start = get_cpu_clock();
+    for (size_t i = 0; i < WS_CAPACITY; ++i) {
+        deque_push<HostAgent, Order>(deque, i);
+    }
+    uint64_t pushed = get_cpu_clock();
+    while (deque_take<HostAgent, Order>(deque, &task));
+    run->push_ticks = pushed - start;
+    run->pop_ticks = get_cpu_clock() - pushed;
+
+    go.store(1, std::memory_order_release);
+    start = get_cpu_clock();
+
+    size_t executed = 0;
+    for (size_t sent = 0; sent < WS_TASKS; ) {
+        for (size_t end = std::min(WS_TASKS, sent + WS_BATCH); sent < end; ++sent) {
+            deque_push<HostAgent, Order>(deque, sent);
+        }
+        while (deque_take<HostAgent, Order>(deque, &task)) {
+            run_task(grain_ticks);
+            executed++;
+        }
+    }
+
+    while (true) {
+        size_t total = executed;
+        for (uint64_t *own : thieves) {
+            total += std::atomic_ref<uint64_t>(own[STEAL_EXECUTED]).load(std::memory_order_acquire);
+        }
+        if (total >= WS_TASKS) break;
+    }
+    run->elapsed = get_cpu_clock() - start;
+    go.store(2, std::memory_order_release);
+}
+
+template <MemOrder Order>
+void steal_thief(WorkDeque deque, uint64_t *go_ptr, uint64_t *own, uint64_t grain_ticks) {
+    std::atomic_ref<uint64_t> go(*go_ptr);
+    std::atomic_ref<uint64_t> executed(own[STEAL_EXECUTED]);
+    uint64_t attempts = 0, done = 0, task;
+
+    while (go.load(std::memory_order_acquire) == 0);
+    while (go.load(std::memory_order_relaxed) == 1) {
+        StealResult result = deque_steal<HostAgent, Order>(deque, &task);
+        if (result != STEAL_EMPTY) attempts++;
+        if (result == STEAL_WON) {
+            run_task(grain_ticks);
+            executed.store(++done, std::memory_order_release);
+        }
+    }
+    own[STEAL_ATTEMPTS] = attempts;
+}
+
+// static partitioning: worker i runs its share of WS_TASKS, no deque, once go is raised
+void static_worker(size_t worker, size_t workers, uint64_t grain_ticks, uint64_t *go_ptr, uint64_t *finished) {
+    while (std::atomic_ref<uint64_t>(*go_ptr).load(std::memory_order_acquire) == 0);
+    for (size_t task = worker; task < WS_TASKS; task += workers) {
+        run_task(grain_ticks);
+    }
+    *finished = get_cpu_clock();
+}
+
+#endif // WORK_STEALING_CUH